@@ -19,6 +19,7 @@
 #include <net/if.h>
 #include <netinet/in.h>
 #include <mntent.h>
+#include <sys/sysmacros.h>
 
 #define LONG_TIMEOUT (60*1000) // 1 minutes
 #define SHORT_TIMEOUT (5*1000) // 5 seconds
@@ -46,7 +47,7 @@ static void strtrim(char *s)
 
 static enum result_error_e sense_to_error(sense_info_t *info)
 {
-	// TODO: May need a more granular decision based on asc/ascq
+	// The scan refines this with the asc/ascq in its retry policy (lib/retry.c)
 
 	switch (info->sense_key) {
 		case SENSE_KEY_NO_SENSE:
@@ -141,11 +142,9 @@ static const char *status_code_to_str(int status)
 	}
 }
 
-static const char *driver_status_to_str(int driver_status)
+static const char *driver_status_to_str(int driver_status, char *buf, unsigned buf_len)
 {
-	static char buf[256];
-
-	snprintf(buf, sizeof(buf), "%s %s",
+	snprintf(buf, buf_len, "%s %s",
 			driver_status_low_to_str(driver_status & 0x0F),
 			driver_status_high_to_str(driver_status & 0xF0));
 	return buf;
@@ -191,9 +190,11 @@ static int sg_ioctl(int fd, unsigned char *cdb, unsigned cdb_len,
 #if 0
 	if (hdr.status || hdr.driver_status || hdr.msg_status || hdr.host_status || hdr.sb_len_wr)
 	{
+		char driver_status_buf[128];
+
 		printf("status: %d %s\n", hdr.status, status_code_to_str(hdr.status));
 		printf("masked status: %d\n", hdr.masked_status);
-		printf("driver status: %d %s\n", hdr.driver_status, driver_status_to_str(hdr.driver_status));
+		printf("driver status: %d %s\n", hdr.driver_status, driver_status_to_str(hdr.driver_status, driver_status_buf, sizeof(driver_status_buf)));
 		printf("msg status: %d\n", hdr.msg_status);
 		printf("host status: %d = %s\n", hdr.host_status, host_status_to_str(hdr.host_status));
 		printf("sense len: %d\n", hdr.sb_len_wr);
@@ -201,6 +202,8 @@ static int sg_ioctl(int fd, unsigned char *cdb, unsigned cdb_len,
 #endif
 
 	*buf_read = hdr.dxfer_len - hdr.resid;
+	io_res->device_time_msec = hdr.duration;
+	io_res->device_time_valid = true;
 
 	if (*buf_read == buf_len)
 		io_res->data = DATA_FULL;
@@ -227,10 +230,12 @@ static int sg_ioctl(int fd, unsigned char *cdb, unsigned cdb_len,
 
 	if (hdr.status != 0) {
 		// No sense but we have an error, consider it fatal if no data returned
+		char driver_status_buf[128];
+
 		ERROR("IO failed with no sense: status=%d (%s) mask=%d driver=%d (%s) msg=%d host=%d (%s)",
 				hdr.status, status_code_to_str(hdr.status),
 				hdr.masked_status,
-				hdr.driver_status, driver_status_to_str(hdr.driver_status),
+				hdr.driver_status, driver_status_to_str(hdr.driver_status, driver_status_buf, sizeof(driver_status_buf)),
 				hdr.msg_status,
 				hdr.host_status, host_status_to_str(hdr.host_status));
 
@@ -316,6 +321,46 @@ Exit:
 	return state;
 }
 
+static uint32_t sysfs_read_u32(const char *dir, const char *name)
+{
+	char path[256];
+	unsigned long val = 0;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	f = fopen(path, "r");
+	if (f == NULL)
+		return 0;
+	if (fscanf(f, "%lu", &val) != 1)
+		val = 0;
+	fclose(f);
+	return val;
+}
+
+int disk_dev_io_limits(const char *path, disk_io_limits_t *limits)
+{
+	struct stat st;
+	char queue_dir[128];
+	char partition[128];
+
+	memset(limits, 0, sizeof(*limits));
+
+	if (stat(path, &st) != 0 || !S_ISBLK(st.st_mode))
+		return -1;
+
+	// A partition has no queue of its own, its limits are those of the whole disk
+	snprintf(partition, sizeof(partition), "/sys/dev/block/%u:%u/partition", major(st.st_rdev), minor(st.st_rdev));
+	if (access(partition, F_OK) == 0)
+		snprintf(queue_dir, sizeof(queue_dir), "/sys/dev/block/%u:%u/../queue", major(st.st_rdev), minor(st.st_rdev));
+	else
+		snprintf(queue_dir, sizeof(queue_dir), "/sys/dev/block/%u:%u/queue", major(st.st_rdev), minor(st.st_rdev));
+
+	limits->max_transfer_bytes = sysfs_read_u32(queue_dir, "max_sectors_kb") * 1024;
+	limits->optimal_io_bytes = sysfs_read_u32(queue_dir, "optimal_io_size");
+	limits->physical_block_bytes = sysfs_read_u32(queue_dir, "physical_block_size");
+	return 0;
+}
+
 bool disk_dev_open(disk_dev_t *dev, const char *path)
 {
 	dev->fd = open(path, O_RDWR|O_DIRECT);
@@ -338,7 +383,7 @@ void disk_dev_cdb_in(disk_dev_t *dev, unsigned char *cdb, unsigned cdb_len, unsi
 	sg_ioctl(dev->fd, cdb, cdb_len, buf, buf_size, SG_DXFER_FROM_DEV, LONG_TIMEOUT, sense, sense_size, buf_read, sense_read, io_res);
 }
 
-ssize_t disk_dev_read(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
+static ssize_t disk_dev_read_cdb(disk_dev_t *dev, bool fua, bool dpo, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
 {
 	unsigned char cdb[32];
 	unsigned char sense[128];
@@ -350,7 +395,10 @@ ssize_t disk_dev_read(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes
 	memset(buf, 0, len_bytes);
 	memset(io_res, 0, sizeof(*io_res));
 
-	cdb_len = cdb_read_10(cdb, false, offset_bytes / dev->sector_size, len_bytes / dev->sector_size);
+	if (dpo)
+		cdb_len = cdb_read_16(cdb, fua, false, dpo, offset_bytes / dev->sector_size, len_bytes / dev->sector_size);
+	else
+		cdb_len = cdb_read_10(cdb, fua, offset_bytes / dev->sector_size, len_bytes / dev->sector_size);
 	ret = sg_ioctl(dev->fd, cdb, cdb_len, buf, len_bytes, SG_DXFER_FROM_DEV, LONG_TIMEOUT, sense, sizeof(sense), &buf_read, &sense_read, io_res);
 	if (ret < 0) {
 		return -1;
@@ -364,6 +412,22 @@ ssize_t disk_dev_read(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes
 	return buf_read;
 }
 
+ssize_t disk_dev_read(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
+{
+	return disk_dev_read_cdb(dev, dev->read_bypass_cache, dev->read_bypass_cache, offset_bytes, len_bytes, buf, io_res);
+}
+
+ssize_t disk_dev_read_fua(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
+{
+	return disk_dev_read_cdb(dev, true, false, offset_bytes, len_bytes, buf, io_res);
+}
+
+bool disk_dev_read_bypass_cache(disk_dev_t *dev, bool bypass)
+{
+	dev->read_bypass_cache = bypass;
+	return true;
+}
+
 ssize_t disk_dev_write(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
 {
 	unsigned char cdb[32];
@@ -373,7 +437,6 @@ ssize_t disk_dev_write(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_byte
 	unsigned sense_read = 0;
 	int ret;
 
-	memset(buf, 0, len_bytes);
 	memset(io_res, 0, sizeof(*io_res));
 
 	cdb_len = cdb_write_10(cdb, false, offset_bytes / dev->sector_size, len_bytes / dev->sector_size);
@@ -383,7 +446,7 @@ ssize_t disk_dev_write(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_byte
 	}
 
 	if (buf_read < len_bytes && sense_read > 0) {
-		VERBOSE("not all read: requested=%u read=%u sense=%u", len_bytes, buf_read, sense_read);
+		VERBOSE("not all written: requested=%u written=%u sense=%u", len_bytes, buf_read, sense_read);
 		return -1;
 	}
 
@@ -4,6 +4,7 @@
 struct disk_dev_t {
 	int fd;
 	uint32_t sector_size;
+	bool read_bypass_cache;
 };
 
 #endif
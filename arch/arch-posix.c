@@ -19,6 +19,13 @@ bool disk_dev_open(disk_dev_t *dev, const char *path)
 	return dev->fd >= 0;
 }
 
+int disk_dev_io_limits(const char *path, disk_io_limits_t *limits)
+{
+	(void)path;
+	memset(limits, 0, sizeof(*limits));
+	return -1;
+}
+
 void disk_dev_close(disk_dev_t *dev)
 {
 	close(dev->fd);
@@ -27,6 +34,7 @@ void disk_dev_close(disk_dev_t *dev)
 
 ssize_t disk_dev_read(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
 {
+	memset(io_res, 0, sizeof(*io_res));
 	ssize_t ret = pread(dev->fd, buf, len_bytes, offset_bytes);
 	if (ret == len_bytes) {
 		io_res->data = DATA_FULL;
@@ -54,8 +62,22 @@ ssize_t disk_dev_read(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes
 	//TODO: Handle EINTR with a retry
 }
 
+/* O_DIRECT already bypasses the host cache, there is no portable way to bypass the device cache */
+ssize_t disk_dev_read_fua(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
+{
+	return disk_dev_read(dev, offset_bytes, len_bytes, buf, io_res);
+}
+
+/* There is no portable way to pass FUA and DPO */
+bool disk_dev_read_bypass_cache(disk_dev_t *dev, bool bypass)
+{
+	(void)dev;
+	return !bypass;
+}
+
 ssize_t disk_dev_write(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
 {
+	memset(io_res, 0, sizeof(*io_res));
 	ssize_t ret = pwrite(dev->fd, buf, len_bytes, offset_bytes);
 	if (ret == len_bytes) {
 		io_res->data = DATA_FULL;
@@ -0,0 +1,682 @@
+#include "arch.h"
+#include "libscsicmd/include/scsicmd.h"
+#include "libscsicmd/include/scsicmd_utils.h"
+#include "libscsicmd/include/ata.h"
+#include "libscsicmd/include/ata_parse.h"
+#include "verbose.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+/* Replay of a recorded SCSI trace in place of a disk.
+ *
+ * The trace is the CSV written by libscsicmd/test/collect_raw_data, one command per line:
+ *   msg,cdb,sense,data[,duration_msec]
+ * with the buffers in hex. Lines that don't hold a command are ignored.
+ *
+ * A command is answered with the first recorded response for the same CDB, the allocation
+ * length is ignored when matching. A CDB that was recorded several times is answered with
+ * the responses in order and the last one repeats, so a trace can script a changing value.
+ * A command that wasn't recorded fails as an unsupported command.
+ *
+ * Reads and writes are matched by the LBA range instead. A request that overlaps a recorded
+ * READ or WRITE gets its sense and duration, which is how a trace places bad or slow sectors,
+ * any other request completes at once with zeroed data. Written data is not kept.
+ *
+ * A recorded duration is spent before answering so the scan measures it, the replay is
+ * instant otherwise.
+ *
+ * disk_dev_t is defined by the platform header, the replay only uses its fd and keeps its
+ * own state here so a single trace can be open at a time.
+ */
+
+typedef struct replay_entry_t {
+	unsigned char cdb[32];
+	unsigned cdb_len;
+	unsigned char *sense;
+	unsigned sense_len;
+	unsigned char *data;
+	unsigned data_len;
+	bool duration_valid;
+	uint32_t duration_msec;
+	bool used;
+} replay_entry_t;
+
+static struct {
+	replay_entry_t *entries;
+	unsigned num_entries;
+	uint32_t sector_size;
+	bool read_bypass_cache;
+	pthread_mutex_t lock;
+} replay = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* Allocation length fields, they depend on the buffer of the caller and not on the command */
+static const struct {
+	uint8_t opcode;
+	uint8_t offset;
+	uint8_t len;
+} alloc_len_fields[] = {
+	{0x12, 3, 2},  // INQUIRY
+	{0x1A, 4, 1},  // MODE SENSE 6
+	{0x1C, 3, 2},  // RECEIVE DIAGNOSTIC RESULTS
+	{0x37, 7, 2},  // READ DEFECT DATA 10
+	{0x4D, 7, 2},  // LOG SENSE
+	{0x5A, 7, 2},  // MODE SENSE 10
+	{0x95, 10, 4}, // ZBC IN
+	{0x9E, 10, 4}, // SERVICE ACTION IN 16
+	{0xB7, 6, 4},  // READ DEFECT DATA 12
+};
+
+/* ILLEGAL REQUEST, INVALID COMMAND OPERATION CODE */
+static unsigned char sense_invalid_opcode[18] = {0x70, 0, 0x05, 0, 0, 0, 0, 0x0A, 0, 0, 0, 0, 0x20, 0x00, 0, 0, 0, 0};
+
+static void strtrim(char *s)
+{
+	char *t;
+
+	// Skip initial spaces
+	for (t = s; *t && isspace(*t); t++)
+		;
+
+	if (t != s) {
+		// Copy content to start
+		while (*t && !isspace(*t)) {
+			*s++ = *t++;
+		}
+		*s = 0;
+	} else {
+		while (*t && !isspace(*t))
+			t++;
+		*t = 0;
+	}
+}
+
+static enum result_error_e sense_to_error(sense_info_t *info)
+{
+	switch (info->sense_key) {
+		case SENSE_KEY_NO_SENSE:
+			return ERROR_NONE;
+
+		case SENSE_KEY_RECOVERED_ERROR:
+			return ERROR_CORRECTED;
+
+		case SENSE_KEY_MEDIUM_ERROR:
+			return ERROR_UNCORRECTED;
+
+		case SENSE_KEY_UNIT_ATTENTION:
+		case SENSE_KEY_NOT_READY:
+		case SENSE_KEY_ABORTED_COMMAND:
+			return ERROR_NEED_RETRY;
+
+		case SENSE_KEY_HARDWARE_ERROR:
+		case SENSE_KEY_ILLEGAL_REQUEST:
+		case SENSE_KEY_DATA_PROTECT:
+		case SENSE_KEY_BLANK_CHECK:
+		case SENSE_KEY_VENDOR_SPECIFIC:
+		case SENSE_KEY_COPY_ABORTED:
+		case SENSE_KEY_RESERVED_C:
+		case SENSE_KEY_VOLUME_OVERFLOW:
+		case SENSE_KEY_MISCOMPARE:
+		case SENSE_KEY_COMPLETED:
+			return ERROR_FATAL;
+	}
+
+	ERROR("BUG: Cannot translate sense 0x%02X to error code", info->sense_key);
+	return ERROR_UNKNOWN;
+}
+
+static int hex_val(char ch)
+{
+	if (ch >= '0' && ch <= '9')
+		return ch - '0';
+	else if (ch >= 'a' && ch <= 'f')
+		return ch - 'a' + 10;
+	else if (ch >= 'A' && ch <= 'F')
+		return ch - 'A' + 10;
+	return -1;
+}
+
+/* Parse a hex field into buf, returns the number of bytes or -1 if it isn't a hex buffer */
+static int parse_hex(const char *str, unsigned char *buf, unsigned buf_size)
+{
+	unsigned len = 0;
+	int top = -1;
+
+	for (; *str; str++) {
+		if (isspace((unsigned char)*str))
+			continue;
+
+		int val = hex_val(*str);
+		if (val < 0)
+			return -1;
+
+		if (top < 0) {
+			top = val;
+		} else {
+			if (len == buf_size)
+				return -1;
+			buf[len++] = top << 4 | val;
+			top = -1;
+		}
+	}
+
+	return top < 0 ? (int)len : -1;
+}
+
+static unsigned char *dup_buf(const unsigned char *buf, unsigned len)
+{
+	unsigned char *out;
+
+	if (len == 0)
+		return NULL;
+
+	out = malloc(len);
+	if (out)
+		memcpy(out, buf, len);
+	return out;
+}
+
+static bool replay_parse_line(char *line, replay_entry_t *entry)
+{
+	static unsigned char buf[64*1024];
+	char *fields[5];
+	unsigned num_fields = 0;
+	char *next = line;
+	int len;
+
+	line[strcspn(line, "\r\n")] = 0;
+	while (next && num_fields < 5) {
+		fields[num_fields++] = next;
+		next = strchr(next, ',');
+		if (next)
+			*next++ = 0;
+	}
+
+	// msg,cdb,sense,data and an optional duration
+	if (num_fields < 4)
+		return false;
+
+	memset(entry, 0, sizeof(*entry));
+
+	len = parse_hex(fields[1], entry->cdb, sizeof(entry->cdb));
+	if (len < 6)
+		return false;
+	entry->cdb_len = len;
+
+	len = parse_hex(fields[2], buf, sizeof(buf));
+	if (len < 0)
+		return false;
+	entry->sense_len = len;
+	entry->sense = dup_buf(buf, len);
+
+	len = parse_hex(fields[3], buf, sizeof(buf));
+	if (len < 0) {
+		free(entry->sense);
+		return false;
+	}
+	entry->data_len = len;
+	entry->data = dup_buf(buf, len);
+
+	if (num_fields == 5 && *fields[4]) {
+		char *end;
+		unsigned long duration = strtoul(fields[4], &end, 10);
+		if (*end == 0) {
+			entry->duration_valid = true;
+			entry->duration_msec = duration;
+		}
+	}
+
+	return true;
+}
+
+static bool replay_load(const char *path)
+{
+	FILE *f;
+	char *line = NULL;
+	size_t line_size = 0;
+	unsigned entries_size = 0;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		return false;
+
+	while (getline(&line, &line_size, f) >= 0) {
+		if (replay.num_entries == entries_size) {
+			unsigned new_size = entries_size ? entries_size * 2 : 64;
+			replay_entry_t *entries = realloc(replay.entries, new_size * sizeof(*entries));
+			if (entries == NULL)
+				break;
+			replay.entries = entries;
+			entries_size = new_size;
+		}
+
+		if (replay_parse_line(line, &replay.entries[replay.num_entries]))
+			replay.num_entries++;
+	}
+
+	free(line);
+	fclose(f);
+
+	INFO("Replaying %u recorded commands from %s", replay.num_entries, path);
+	return replay.num_entries > 0;
+}
+
+static void replay_free(void)
+{
+	unsigned i;
+
+	for (i = 0; i < replay.num_entries; i++) {
+		free(replay.entries[i].sense);
+		free(replay.entries[i].data);
+	}
+	free(replay.entries);
+	replay.entries = NULL;
+	replay.num_entries = 0;
+}
+
+static bool cdb_is_rw(const unsigned char *cdb, unsigned cdb_len, bool *is_write, uint64_t *lba, uint32_t *num_blocks)
+{
+	switch (cdb[0]) {
+		case 0x28: // READ 10
+		case 0x2A: // WRITE 10
+			if (cdb_len < 10)
+				return false;
+			*is_write = cdb[0] == 0x2A;
+			*lba = get_uint32((unsigned char *)cdb, 2);
+			*num_blocks = get_uint16((unsigned char *)cdb, 7);
+			return true;
+		case 0x88: // READ 16
+		case 0x8A: // WRITE 16
+			if (cdb_len < 16)
+				return false;
+			*is_write = cdb[0] == 0x8A;
+			*lba = get_uint64((unsigned char *)cdb, 2);
+			*num_blocks = get_uint32((unsigned char *)cdb, 10);
+			return true;
+	}
+
+	return false;
+}
+
+static bool cdb_match(const replay_entry_t *entry, const unsigned char *cdb, unsigned cdb_len)
+{
+	unsigned skip_start = 0;
+	unsigned skip_end = 0;
+	unsigned i;
+
+	if (entry->cdb_len != cdb_len)
+		return false;
+
+	for (i = 0; i < sizeof(alloc_len_fields)/sizeof(alloc_len_fields[0]); i++) {
+		if (alloc_len_fields[i].opcode == cdb[0]) {
+			skip_start = alloc_len_fields[i].offset;
+			skip_end = skip_start + alloc_len_fields[i].len;
+			break;
+		}
+	}
+
+	for (i = 0; i < cdb_len; i++) {
+		if ((i < skip_start || i >= skip_end) && entry->cdb[i] != cdb[i])
+			return false;
+	}
+
+	return true;
+}
+
+static replay_entry_t *replay_find_rw(const unsigned char *cdb, unsigned cdb_len)
+{
+	bool is_write;
+	uint64_t lba;
+	uint32_t num_blocks;
+	unsigned i;
+
+	if (!cdb_is_rw(cdb, cdb_len, &is_write, &lba, &num_blocks))
+		return NULL;
+
+	for (i = 0; i < replay.num_entries; i++) {
+		replay_entry_t *entry = &replay.entries[i];
+		bool entry_is_write;
+		uint64_t entry_lba;
+		uint32_t entry_num_blocks;
+
+		if (!cdb_is_rw(entry->cdb, entry->cdb_len, &entry_is_write, &entry_lba, &entry_num_blocks))
+			continue;
+		if (entry_is_write != is_write)
+			continue;
+		if (entry_lba < lba + num_blocks && lba < entry_lba + entry_num_blocks)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static replay_entry_t *replay_find(const unsigned char *cdb, unsigned cdb_len)
+{
+	replay_entry_t *last = NULL;
+	unsigned i;
+
+	for (i = 0; i < replay.num_entries; i++) {
+		replay_entry_t *entry = &replay.entries[i];
+
+		if (!cdb_match(entry, cdb, cdb_len))
+			continue;
+		if (!entry->used) {
+			entry->used = true;
+			return entry;
+		}
+		last = entry;
+	}
+
+	return last;
+}
+
+static void replay_cdb(unsigned char *cdb, unsigned cdb_len, unsigned char *buf, unsigned buf_size, unsigned *buf_read,
+		unsigned char *sense, unsigned sense_size, unsigned *sense_read, bool data_in, io_result_t *io_res)
+{
+	const unsigned char *entry_sense = NULL;
+	unsigned entry_sense_len = 0;
+	replay_entry_t *entry;
+	bool is_write;
+	uint64_t lba;
+	uint32_t num_blocks;
+
+	memset(io_res, 0, sizeof(*io_res));
+	*sense_read = 0;
+	*buf_read = 0;
+
+	pthread_mutex_lock(&replay.lock);
+	if (cdb_is_rw(cdb, cdb_len, &is_write, &lba, &num_blocks)) {
+		entry = replay_find_rw(cdb, cdb_len);
+		if (entry == NULL || entry->sense_len == 0)
+			*buf_read = buf_size;
+	} else {
+		entry = replay_find(cdb, cdb_len);
+		if (entry == NULL) {
+			char cdb_hex[32*3+1];
+			unsigned i;
+
+			for (i = 0; i < cdb_len && i < 32; i++)
+				snprintf(cdb_hex + i*3, sizeof(cdb_hex) - i*3, " %02x", cdb[i]);
+			cdb_hex[i*3] = 0;
+			VERBOSE("Replay has no response for CDB%s, answering as unsupported", cdb_hex);
+			entry_sense = sense_invalid_opcode;
+			entry_sense_len = sizeof(sense_invalid_opcode);
+		} else if (!data_in) {
+			*buf_read = entry->sense_len ? 0 : buf_size;
+		} else {
+			*buf_read = entry->data_len < buf_size ? entry->data_len : buf_size;
+			if (*buf_read)
+				memcpy(buf, entry->data, *buf_read);
+		}
+	}
+
+	if (entry) {
+		entry_sense = entry->sense;
+		entry_sense_len = entry->sense_len;
+		if (entry->duration_valid) {
+			io_res->device_time_valid = true;
+			io_res->device_time_msec = entry->duration_msec;
+		}
+	}
+	pthread_mutex_unlock(&replay.lock);
+
+	if (io_res->device_time_valid) {
+		struct timespec ts = {
+			.tv_sec = io_res->device_time_msec / 1000,
+			.tv_nsec = (io_res->device_time_msec % 1000) * 1000000,
+		};
+		while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+			;
+	}
+
+	if (*buf_read == buf_size)
+		io_res->data = DATA_FULL;
+	else if (*buf_read == 0)
+		io_res->data = DATA_NONE;
+	else
+		io_res->data = DATA_PARTIAL;
+
+	if (entry_sense_len) {
+		unsigned len = entry_sense_len;
+		if (len > sizeof(io_res->sense))
+			len = sizeof(io_res->sense);
+		memcpy(io_res->sense, entry_sense, len);
+		io_res->sense_len = len;
+
+		if (len > sense_size)
+			len = sense_size;
+		memcpy(sense, entry_sense, len);
+		*sense_read = len;
+
+		if (scsi_parse_sense(io_res->sense, io_res->sense_len, &io_res->info))
+			io_res->error = sense_to_error(&io_res->info);
+		else
+			io_res->error = ERROR_UNKNOWN;
+		return;
+	}
+
+	io_res->error = ERROR_NONE;
+}
+
+disk_mount_e disk_dev_mount_state(const char *path)
+{
+	(void)path;
+	return DISK_NOT_MOUNTED;
+}
+
+int disk_dev_io_limits(const char *path, disk_io_limits_t *limits)
+{
+	(void)path;
+	memset(limits, 0, sizeof(*limits));
+	return -1;
+}
+
+bool disk_dev_open(disk_dev_t *dev, const char *path)
+{
+	dev->fd = open(path, O_RDONLY);
+	if (dev->fd < 0)
+		return false;
+
+	if (!replay_load(path)) {
+		ERROR("No recorded commands found in the trace %s", path);
+		replay_free();
+		close(dev->fd);
+		dev->fd = -1;
+		return false;
+	}
+
+	replay.sector_size = 512;
+	replay.read_bypass_cache = false;
+	return true;
+}
+
+void disk_dev_close(disk_dev_t *dev)
+{
+	replay_free();
+	close(dev->fd);
+	dev->fd = -1;
+}
+
+void disk_dev_cdb_out(disk_dev_t *dev, unsigned char *cdb, unsigned cdb_len, unsigned char *buf, unsigned buf_size, unsigned *buf_read, unsigned char *sense, unsigned sense_size, unsigned *sense_read, io_result_t *io_res)
+{
+	(void)dev;
+	replay_cdb(cdb, cdb_len, buf, buf_size, buf_read, sense, sense_size, sense_read, false, io_res);
+}
+
+void disk_dev_cdb_in(disk_dev_t *dev, unsigned char *cdb, unsigned cdb_len, unsigned char *buf, unsigned buf_size, unsigned *buf_read, unsigned char *sense, unsigned sense_size, unsigned *sense_read, io_result_t *io_res)
+{
+	(void)dev;
+	replay_cdb(cdb, cdb_len, buf, buf_size, buf_read, sense, sense_size, sense_read, true, io_res);
+}
+
+static ssize_t disk_dev_rw_cdb(bool write, bool fua, bool dpo, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
+{
+	unsigned char cdb[32];
+	unsigned char sense[128];
+	int cdb_len;
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+
+	if (write)
+		cdb_len = cdb_write_10(cdb, false, offset_bytes / replay.sector_size, len_bytes / replay.sector_size);
+	else if (dpo)
+		cdb_len = cdb_read_16(cdb, fua, false, dpo, offset_bytes / replay.sector_size, len_bytes / replay.sector_size);
+	else
+		cdb_len = cdb_read_10(cdb, fua, offset_bytes / replay.sector_size, len_bytes / replay.sector_size);
+
+	if (!write)
+		memset(buf, 0, len_bytes);
+	replay_cdb(cdb, cdb_len, buf, len_bytes, &buf_read, sense, sizeof(sense), &sense_read, !write, io_res);
+
+	if (buf_read < len_bytes && sense_read > 0) {
+		VERBOSE("not all %s: requested=%u done=%u sense=%u", write ? "written" : "read", len_bytes, buf_read, sense_read);
+		// The kernel fails a command that returned sense with EIO
+		errno = EIO;
+		return -1;
+	}
+
+	return buf_read;
+}
+
+ssize_t disk_dev_read(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
+{
+	(void)dev;
+	return disk_dev_rw_cdb(false, replay.read_bypass_cache, replay.read_bypass_cache, offset_bytes, len_bytes, buf, io_res);
+}
+
+ssize_t disk_dev_read_fua(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
+{
+	(void)dev;
+	return disk_dev_rw_cdb(false, true, false, offset_bytes, len_bytes, buf, io_res);
+}
+
+bool disk_dev_read_bypass_cache(disk_dev_t *dev, bool bypass)
+{
+	(void)dev;
+	replay.read_bypass_cache = bypass;
+	return true;
+}
+
+ssize_t disk_dev_write(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res)
+{
+	(void)dev;
+	return disk_dev_rw_cdb(true, false, false, offset_bytes, len_bytes, buf, io_res);
+}
+
+int disk_dev_read_cap(disk_dev_t *dev, uint64_t *size_bytes, uint64_t *sector_size)
+{
+	unsigned char cdb[32];
+	unsigned char buf[512];
+	unsigned char sense[128];
+	int cdb_len;
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	memset(buf, 0, sizeof(buf));
+
+	cdb_len = cdb_read_capacity_10(cdb);
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, sizeof(buf), &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (sense_read > 0)
+		return -1;
+
+	uint32_t max_lba_32;
+	uint32_t block_size;
+	if (!parse_read_capacity_10(buf, buf_read, &max_lba_32, &block_size))
+		return -1;
+
+	if (max_lba_32 < 0xFFFFFFFF) {
+		*size_bytes = ((uint64_t)max_lba_32 + 1) * block_size;
+		replay.sector_size = *sector_size = block_size;
+		return 0;
+	}
+
+	// disk size is too large for READ CAPACITY 10, need to use READ CAPACITY 16
+	uint64_t max_lba;
+	cdb_len = cdb_read_capacity_16(cdb, sizeof(buf));
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, sizeof(buf), &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (sense_read > 0)
+		return -1;
+
+	if (!parse_read_capacity_16_simple(buf, buf_read, &max_lba, &block_size))
+		return -1;
+
+	*size_bytes = (max_lba + 1) * block_size;
+	replay.sector_size = *sector_size = block_size;
+	return 0;
+}
+
+int disk_dev_identify(disk_dev_t *dev, char *vendor, char *model, char *fw_rev, char *serial, bool *is_ata, unsigned char *ata_buf, unsigned *ata_buf_len)
+{
+	unsigned char cdb[32];
+	unsigned char buf[512];
+	unsigned char sense[128];
+	int cdb_len;
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	*is_ata = false;
+	*ata_buf_len = 0;
+	memset(buf, 0, sizeof(buf));
+
+	cdb_len = cdb_inquiry_simple(cdb, 96);
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, sizeof(buf), &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (sense_read > 0)
+		return -1;
+
+	int device_type;
+	if (!parse_inquiry(buf, buf_read, &device_type, vendor, model, fw_rev, serial))
+	{
+		INFO("Failed to parse the inquiry data");
+		return -1;
+	}
+	strtrim(vendor);
+	strtrim(model);
+	strtrim(fw_rev);
+	strtrim(serial);
+
+	// If the vendor doesn't start with ATA it is a proper SCSI interface
+	if (strncmp(vendor, "ATA", 3) != 0)
+		return 0;
+
+	*is_ata = true;
+
+	// For an ATA disk we need to get the proper ATA IDENTIFY response
+	memset(buf, 0, sizeof(buf));
+	cdb_len = cdb_ata_identify(cdb);
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, sizeof(buf), &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (sense_read > 0)
+		return -1;
+
+	ata_get_ata_identify_model(buf, vendor);
+	strtrim(vendor);
+	strcpy(model, vendor + strlen(vendor) + 1);
+	strtrim(model);
+	ata_get_ata_identify_fw_rev(buf, fw_rev);
+	strtrim(fw_rev);
+	ata_get_ata_identify_serial_number(buf, serial);
+	strtrim(serial);
+
+	memcpy(ata_buf, buf, buf_read);
+	*ata_buf_len = buf_read;
+
+	return 0;
+}
+
+void mac_read(unsigned char *buf, int len)
+{
+	(void)len;
+	*buf = 0;
+}
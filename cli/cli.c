@@ -34,6 +34,10 @@
 #include <memory.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <sched.h>
+
+/* Latency buckets of a disk that isn't zoned, also the width of the graphs */
+#define LATENCY_GRAPH_LEN 70
 
 static disk_t disk;
 static progressbar *bar;
@@ -45,9 +49,43 @@ struct options_t {
 	int fix;
 	enum scan_mode mode;
 	unsigned scan_size;
+	bool scan_size_auto;
 	char *data_log_name;
 	char *data_log_raw_name;
 	disk_mount_e allowed_mount;
+	char *metrics_socket;
+	char *metrics_file;
+	int io_cpu;
+	unsigned jitter_calibration_sec;
+	bool glist_poll;
+	burn_in_t burn_in;
+	char *fingerprint_file;
+	bool skip_bad_areas;
+	char *policy_file;
+	stop_early_e stop_early;
+	bool erc;
+	unsigned erc_read_msec;
+	unsigned erc_write_msec;
+	bool bypass_cache;
+	bool mapped_only;
+	unsigned mapped_sample_percent;
+};
+
+/* Long options that have no short option equivalent */
+enum {
+	OPT_METRICS_SOCKET = 256,
+	OPT_METRICS_FILE,
+	OPT_CPU,
+	OPT_JITTER_CALIBRATION,
+	OPT_GLIST_POLL,
+	OPT_BURN_IN,
+	OPT_FINGERPRINT,
+	OPT_SKIP_BAD_AREAS,
+	OPT_POLICY,
+	OPT_STOP_EARLY,
+	OPT_ERC,
+	OPT_BYPASS_CACHE,
+	OPT_MAPPED_ONLY,
 };
 
 static void print_header(void)
@@ -65,11 +103,24 @@ static int usage(void) {
 	printf("    -v, --verbose        - Increase verbosity, multiple uses for higher levels\n");
 	printf("    -f, --fix            - Attempt to fix near failures, nothing can be done for unreadable sectors\n");
 	printf("    -s, --scan <mode>    - Scan in order (seq, random)\n");
-	printf("    -e, --size <size>    - Scan size (default to 64K, must be multiple of 512)\n");
+	printf("    -e, --size <size>    - Scan size (default to 64K, must be multiple of 512, auto to probe the device)\n");
 	printf("    -o, --output <file>  - Output file (json)\n");
 	printf("    -r, --raw-log <file> - Raw log of all scan results (json)\n");
 	printf("    --force-mounted      - Allow checking a read-only mounted disk\n");
 	printf("    --force-mounted-rw   - Allow checking a read-write mounted disk\n");
+	printf("    --metrics-socket <path> - Serve live metrics (Prometheus text) on a unix socket\n");
+	printf("    --metrics-file <file>   - Periodically write live metrics for the node_exporter textfile collector\n");
+	printf("    --cpu <n>            - Pin the scan to CPU n to reduce host noise in latency measurements\n");
+	printf("    --jitter-calibration <sec> - Measure host jitter before the scan (default 0, no calibration)\n");
+	printf("    --glist-poll         - Read the grown defect list whenever it grows during the scan, not just at the end\n");
+	printf("    --burn-in <patterns> - DESTRUCTIVE: write and verify comma separated patterns (byte value, lba, random[:seed])\n");
+	printf("    --fingerprint <file> - Keep content checksums in file and report content that changed since the previous scan\n");
+	printf("    --skip-bad-areas     - Skip ahead over areas with consecutive errors and read them last (sequential scan)\n");
+	printf("    --policy <file>      - Verdict thresholds per disk model\n");
+	printf("    --stop-early[=pass]  - Stop once the disk is certain to fail, or at the end of the pass in progress\n");
+	printf("    --erc <read>[,<write>] - Limit the disk error recovery time in msec during the scan, weak sectors fail fast\n");
+	printf("    --bypass-cache       - Disable read look-ahead and read with FUA/DPO to measure the media latency\n");
+	printf("    --mapped-only[=<pct>] - Read only the mapped extents of a thin provisioned disk, sample pct%% of the unmapped reads\n");
 	printf("\n");
 	return 1;
 }
@@ -151,15 +202,165 @@ static void print_latency(latency_t *latency_graph, unsigned latency_graph_len)
 
 }
 
+static void print_throughput(latency_t *latency_graph, unsigned latency_graph_len)
+{
+	unsigned i;
+	uint32_t j;
+
+	const uint32_t height = 15; // number of lines to fill
+	double max_val = 1.0;
+
+	for (i = 0; i < latency_graph_len; i++) {
+		if (max_val < latency_graph[i].throughput_mbps)
+			max_val = latency_graph[i].throughput_mbps;
+		if (max_val < latency_graph[i].model_mbps)
+			max_val = latency_graph[i].model_mbps;
+	}
+
+	const double height_interval = max_val / height;
+
+	for (j = height; j > 0; j--) {
+		if (j % 5 == 0)
+			printf("%5.0f | ", j * height_interval);
+		else
+			printf("      | ");
+
+		for (i = 0; i < latency_graph_len; i++) {
+			uint32_t val_height = latency_graph[i].throughput_mbps / height_interval + 0.5;
+			uint32_t model_height = latency_graph[i].model_mbps / height_interval + 0.5;
+
+			if (val_height == j)
+				printf("*");
+			else if (model_height == j)
+				printf("-");
+			else
+				printf(" ");
+		}
+		printf("\n");
+	}
+	printf("      +-");
+	for (i = 0; i < latency_graph_len; i++) {
+		printf("-");
+	}
+	printf("\n        ");
+	for (i = 0; i < latency_graph_len; i++) {
+		printf("%c", latency_graph[i].throughput_dip ? '^' : ' ');
+	}
+	printf("\n");
+
+	for (i = 0; i < latency_graph_len; i++) {
+		if (latency_graph[i].throughput_dip)
+			printf("Throughput dip at sectors %"PRIu64"-%"PRIu64": %.1f MB/s, zone rate is %.1f MB/s\n",
+					latency_graph[i].start_sector, latency_graph[i].end_sector,
+					latency_graph[i].throughput_mbps, latency_graph[i].model_mbps);
+	}
+}
+
+/* A zoned disk has a latency bucket per zone, fold them into columns that fit the terminal */
+static unsigned latency_graph_fold(const latency_t *graph, unsigned len, latency_t *folded, unsigned folded_len)
+{
+	unsigned i, j;
+
+	if (len <= folded_len) {
+		memcpy(folded, graph, len * sizeof(latency_t));
+		return len;
+	}
+
+	for (i = 0; i < folded_len; i++) {
+		const unsigned start = (uint64_t)i * len / folded_len;
+		const unsigned end = (uint64_t)(i + 1) * len / folded_len;
+		latency_t *f = &folded[i];
+		double model_sum = 0.0;
+
+		memset(f, 0, sizeof(*f));
+		f->start_sector = graph[start].start_sector;
+		f->end_sector = graph[end-1].end_sector;
+		f->latency_min_msec = UINT32_MAX;
+		for (j = start; j < end; j++) {
+			const latency_t *l = &graph[j];
+			if (l->bytes == 0)
+				continue;
+			if (l->latency_min_msec < f->latency_min_msec)
+				f->latency_min_msec = l->latency_min_msec;
+			if (l->latency_max_msec > f->latency_max_msec)
+				f->latency_max_msec = l->latency_max_msec;
+			// The worst median of the folded zones is shown
+			if (l->latency_median_msec > f->latency_median_msec)
+				f->latency_median_msec = l->latency_median_msec;
+			f->bytes += l->bytes;
+			f->io_nsec += l->io_nsec;
+			model_sum += l->model_mbps * l->bytes;
+			f->throughput_dip |= l->throughput_dip;
+		}
+		if (f->bytes == 0) {
+			f->latency_min_msec = 0;
+			continue;
+		}
+		if (f->io_nsec)
+			f->throughput_mbps = f->bytes * 1000.0 / f->io_nsec;
+		f->model_mbps = model_sum / f->bytes;
+	}
+
+	return folded_len;
+}
+
 void report_scan_done(disk_t *pdisk)
 {
+	latency_t graph[LATENCY_GRAPH_LEN];
+	unsigned graph_len;
+	unsigned i;
+
 	progressbar_finish(bar);
 
 	printf("\nAccess time histogram:\n");
 	hdr_percentiles_print(pdisk->histogram, stdout, 5, 1000.0, CLASSIC); // Print msecs
 
-	printf("\nLatency graph:\n");
-	print_latency(pdisk->latency_graph, pdisk->latency_graph_len);
+	printf("\nLatency percentiles (msec):");
+	for (i = 0; i < pdisk->latency_percentiles.len; i++)
+		printf(" %g%%: %.3f", pdisk->latency_percentiles.percentile[i], pdisk->latency_percentiles.value_usec[i] / 1000.0);
+	printf("\n");
+
+	if (pdisk->device_histogram->total_count > 0) {
+		printf("\nDevice reported access time histogram (msec resolution):\n");
+		hdr_percentiles_print(pdisk->device_histogram, stdout, 5, 1000.0, CLASSIC);
+	}
+
+	if (pdisk->zones.zoned)
+		printf("\nLatency graph (%u zones, %u per column):\n", pdisk->latency_graph_len,
+				(pdisk->latency_graph_len + LATENCY_GRAPH_LEN - 1) / LATENCY_GRAPH_LEN);
+	else
+		printf("\nLatency graph:\n");
+	graph_len = latency_graph_fold(pdisk->latency_graph, pdisk->latency_graph_len, graph, LATENCY_GRAPH_LEN);
+	print_latency(graph, graph_len);
+
+	if (pdisk->provisioning.valid) {
+		const uint64_t num_sectors = pdisk->num_bytes / pdisk->sector_size;
+		printf("\nMapped %"PRIu64" of %"PRIu64" sectors (%.1f%%), %"PRIu64" reads of unmapped extents skipped and %"PRIu64" sampled\n",
+				pdisk->provisioning.mapped_sectors, num_sectors, pdisk->provisioning.mapped_sectors * 100.0 / num_sectors,
+				pdisk->provisioning.skipped_reads, pdisk->provisioning.sampled_reads);
+	}
+
+	if (pdisk->retry_histogram->total_count > 0) {
+		printf("\nRetry access time histogram (%"PRIu64" retries, %"PRIu64" recovered, %"PRIu64" reads bisected, %"PRIu64" bad sectors in %"PRIu64" physical sectors):\n",
+				pdisk->retry.retries, pdisk->retry.recovered, pdisk->retry.bisected, pdisk->retry.bad_sectors, pdisk->retry.bad_phys_sectors);
+		hdr_percentiles_print(pdisk->retry_histogram, stdout, 5, 1000.0, CLASSIC);
+	}
+
+	if (pdisk->retry.corrected > 0)
+		printf("\n%"PRIu64" reads returned a recovered error, the device corrected them\n", pdisk->retry.corrected);
+
+	if (pdisk->write_histogram->total_count > 0) {
+		printf("\nWrite access time histogram:\n");
+		hdr_percentiles_print(pdisk->write_histogram, stdout, 5, 1000.0, CLASSIC);
+
+		printf("\nWrite latency graph:\n");
+		graph_len = latency_graph_fold(pdisk->write_latency_graph, pdisk->latency_graph_len, graph, LATENCY_GRAPH_LEN);
+		print_latency(graph, graph_len);
+	}
+
+	printf("\nThroughput graph (MB/s, * measured, - zone rate, ^ dip):\n");
+	graph_len = latency_graph_fold(pdisk->latency_graph, pdisk->latency_graph_len, graph, LATENCY_GRAPH_LEN);
+	print_throughput(graph, graph_len);
 
 	printf("\nConclusion: %s\n", conclusion_to_str(pdisk->conclusion));
 }
@@ -202,10 +403,65 @@ static unsigned str_to_scan_size(const char *str)
 	return (unsigned)val;
 }
 
+static int str_to_uint(const char *str, unsigned *val)
+{
+	char *endptr;
+	unsigned long ret;
+
+	errno = 0;
+	ret = strtoul(str, &endptr, 0);
+	if (errno != 0 || *endptr != 0 || endptr == str || ret > UINT32_MAX) {
+		ERROR("Failed to parse the value (%s) to a number", str);
+		return -1;
+	}
+
+	*val = ret;
+	return 0;
+}
+
+static int parse_burn_in(char *arg, burn_in_t *burn_in)
+{
+	char *saveptr = NULL;
+	char *s;
+
+	burn_in->num_patterns = 0;
+	for (s = strtok_r(arg, ",", &saveptr); s; s = strtok_r(NULL, ",", &saveptr)) {
+		if (burn_in->num_patterns == MAX_BURN_IN_PATTERNS) {
+			ERROR("At most %d burn-in patterns are supported", MAX_BURN_IN_PATTERNS);
+			return -1;
+		}
+		if (str_to_pattern(s, &burn_in->patterns[burn_in->num_patterns])) {
+			ERROR("Invalid burn-in pattern %s", s);
+			return -1;
+		}
+		burn_in->num_patterns++;
+	}
+
+	return burn_in->num_patterns ? 0 : -1;
+}
+
+/* <read_msec>[,<write_msec>], the write limit defaults to the read limit */
+static int parse_erc(char *arg, options_t *opts)
+{
+	char *comma = strchr(arg, ',');
+
+	if (comma)
+		*comma = 0;
+	if (str_to_uint(arg, &opts->erc_read_msec))
+		return -1;
+	opts->erc_write_msec = opts->erc_read_msec;
+	if (comma && str_to_uint(comma + 1, &opts->erc_write_msec))
+		return -1;
+
+	opts->erc = true;
+	return 0;
+}
+
 static int parse_args(int argc, char **argv, options_t *opts)
 {
 	int c;
 	int unknown = 0;
+	unsigned val;
 	static int allowed_mount = DISK_NOT_MOUNTED;
 
 	opts->scan_size = 64*1024;
@@ -221,6 +477,19 @@ static int parse_args(int argc, char **argv, options_t *opts)
 			{"output",  required_argument, 0,  'o'},
 			{"force-mounted", no_argument, &allowed_mount, DISK_MOUNTED_RO},
 			{"force-mounted-rw", no_argument, &allowed_mount, DISK_MOUNTED_RW},
+			{"metrics-socket", required_argument, 0, OPT_METRICS_SOCKET},
+			{"metrics-file", required_argument, 0, OPT_METRICS_FILE},
+			{"cpu", required_argument, 0, OPT_CPU},
+			{"jitter-calibration", required_argument, 0, OPT_JITTER_CALIBRATION},
+			{"glist-poll", no_argument, 0, OPT_GLIST_POLL},
+			{"burn-in", required_argument, 0, OPT_BURN_IN},
+			{"fingerprint", required_argument, 0, OPT_FINGERPRINT},
+			{"skip-bad-areas", no_argument, 0, OPT_SKIP_BAD_AREAS},
+			{"policy", required_argument, 0, OPT_POLICY},
+			{"stop-early", optional_argument, 0, OPT_STOP_EARLY},
+			{"erc", required_argument, 0, OPT_ERC},
+			{"bypass-cache", no_argument, 0, OPT_BYPASS_CACHE},
+			{"mapped-only", optional_argument, 0, OPT_MAPPED_ONLY},
 			{0,         0,                 0,  0}
 		};
 
@@ -246,7 +515,10 @@ static int parse_args(int argc, char **argv, options_t *opts)
 				}
 				break;
 			case 'e':
-				opts->scan_size = str_to_scan_size(optarg);
+				if (strcmp(optarg, "auto") == 0)
+					opts->scan_size_auto = true;
+				else
+					opts->scan_size = str_to_scan_size(optarg);
 				break;
 
 			case 'o':
@@ -256,12 +528,79 @@ static int parse_args(int argc, char **argv, options_t *opts)
 				opts->data_log_raw_name = optarg;
 				break;
 
+			case OPT_METRICS_SOCKET:
+				opts->metrics_socket = optarg;
+				break;
+			case OPT_METRICS_FILE:
+				opts->metrics_file = optarg;
+				break;
+			case OPT_CPU:
+				if (str_to_uint(optarg, &val)) {
+					unknown = 1;
+					break;
+				}
+				if (val >= CPU_SETSIZE) {
+					ERROR("CPU %u is out of range, at most %d CPUs are supported", val, CPU_SETSIZE);
+					unknown = 1;
+					break;
+				}
+				opts->io_cpu = val;
+				break;
+			case OPT_JITTER_CALIBRATION:
+				if (str_to_uint(optarg, &val)) {
+					unknown = 1;
+					break;
+				}
+				opts->jitter_calibration_sec = val;
+				break;
+			case OPT_GLIST_POLL:
+				opts->glist_poll = true;
+				break;
+			case OPT_BURN_IN:
+				if (parse_burn_in(optarg, &opts->burn_in))
+					unknown = 1;
+				break;
+			case OPT_FINGERPRINT:
+				opts->fingerprint_file = optarg;
+				break;
+			case OPT_SKIP_BAD_AREAS:
+				opts->skip_bad_areas = true;
+				break;
+			case OPT_POLICY:
+				opts->policy_file = optarg;
+				break;
+			case OPT_STOP_EARLY:
+				if (optarg == NULL)
+					opts->stop_early = STOP_EARLY_NOW;
+				else if (strcmp(optarg, "pass") == 0)
+					opts->stop_early = STOP_EARLY_PASS;
+				else
+					unknown = 1;
+				break;
+			case OPT_ERC:
+				if (parse_erc(optarg, opts))
+					unknown = 1;
+				break;
+			case OPT_BYPASS_CACHE:
+				opts->bypass_cache = true;
+				break;
+			case OPT_MAPPED_ONLY:
+				opts->mapped_only = true;
+				if (optarg && (str_to_uint(optarg, &opts->mapped_sample_percent) || opts->mapped_sample_percent > 100))
+					unknown = 1;
+				break;
+
 			default:
 				unknown = 1;
 				break;
 		}
 	}
 
+	if (opts->fingerprint_file && opts->burn_in.num_patterns) {
+		printf("Fingerprints describe the existing content and cannot be used with a burn-in!\n");
+		return usage();
+	}
+
 	if (optind == argc) {
 		printf("No disk path provided to scan!\n");
 		return usage();
@@ -317,6 +656,8 @@ int diskscan_cli(int argc, char **argv)
 	memset(&opts, 0, sizeof(opts));
 	opts.mode = SCAN_MODE_SEQ;
 	opts.allowed_mount = DISK_NOT_MOUNTED;
+	opts.io_cpu = -1;
+	opts.jitter_calibration_sec = 0;
 
 	if (parse_args(argc, argv, &opts))
 		return 1;
@@ -326,14 +667,67 @@ int diskscan_cli(int argc, char **argv)
 
 	setup_signals();
 
-	if (disk_open(&disk, opts.disk_path, opts.fix, 70, opts.allowed_mount))
+	// The burn-in needs the same write access and mount checks as fixing
+	if (disk_open(&disk, opts.disk_path, opts.fix || opts.burn_in.num_patterns, LATENCY_GRAPH_LEN, opts.allowed_mount))
+		return 1;
+	disk.fix = opts.fix;
+	disk.burn_in = opts.burn_in;
+	disk.io_cpu = opts.io_cpu;
+	disk.jitter_calibration_sec = opts.jitter_calibration_sec;
+	disk.glist.poll = opts.glist_poll;
+	disk.bad_areas.skip = opts.skip_bad_areas;
+	disk.stop_early = opts.stop_early;
+	disk.provisioning.mapped_only = opts.mapped_only;
+	disk.provisioning.sample_percent = opts.mapped_sample_percent;
+
+	if (opts.policy_file && policy_load(&disk, opts.policy_file)) {
+		disk_close(&disk);
+		return 1;
+	}
+
+	if (opts.fingerprint_file && fingerprint_open(&disk, opts.fingerprint_file)) {
+		disk_close(&disk);
+		return 1;
+	}
+
+	if (opts.erc && disk_recovery_limit_set(&disk, opts.erc_read_msec, opts.erc_write_msec)) {
+		disk_close(&disk);
 		return 1;
+	}
+
+	if (opts.bypass_cache && disk_cache_bypass_set(&disk)) {
+		disk_close(&disk);
+		return 1;
+	}
+
+	if (opts.scan_size_auto) {
+		bool interrupted;
+		unsigned scan_size = disk_scan_size_auto(&disk, &interrupted);
+		if (interrupted) {
+			INFO("Disk scan interrupted");
+			disk.conclusion = CONCLUSION_ABORTED;
+			printf("\nConclusion: %s\n", conclusion_to_str(disk.conclusion));
+			disk_close(&disk);
+			return 1;
+		}
+		if (scan_size)
+			opts.scan_size = scan_size;
+		else
+			INFO("Using the default scan size of %u KB", opts.scan_size / 1024);
+	}
 
 	/*
 	if (print_disk_info(&disk))
 		return 1;
 	*/
 
+	// The publisher starts first, a failure must not leave the data logs unterminated
+	if (opts.metrics_socket || opts.metrics_file) {
+		if (metrics_start(&disk, opts.metrics_socket, opts.metrics_file)) {
+			disk_close(&disk);
+			return 1;
+		}
+	}
 	if (opts.data_log_raw_name)
 		data_log_raw_start(&disk.data_raw, opts.data_log_raw_name, &disk);
 	if (opts.data_log_name)
@@ -341,6 +735,7 @@ int diskscan_cli(int argc, char **argv)
 	ret = 0;
 	if (disk_scan(&disk, opts.mode, opts.scan_size))
 		ret = 1;
+	metrics_end(&disk);
 	if (opts.data_log_raw_name)
 		data_log_raw_end(&disk.data_raw);
 	if (opts.data_log_name)
@@ -4,6 +4,7 @@
 
 #include <errno.h>
 #include <stddef.h>
+#include <string.h>
 #include <math.h>
 
 #include "hdr_encoding.h"
@@ -162,6 +163,23 @@ static const char base64_table[] =
         '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/', '\0'
     };
 
+/**
+ * Two base64 characters for every 12 bit value, one lookup replaces two and
+ * the characters are copied out in pairs.  The table is built by the compiler.
+ */
+#define B64_CHAR(v) ((char) ((v) < 26 ? 'A' + (v) : (v) < 52 ? 'a' + (v) - 26 : (v) < 62 ? '0' + (v) - 52 : (v) == 62 ? '+' : '/'))
+#define B64_PAIR(i) B64_CHAR((i) >> 6), B64_CHAR((i) & 0x3F)
+#define B64_PAIRS_4(i) B64_PAIR(i), B64_PAIR((i) + 1), B64_PAIR((i) + 2), B64_PAIR((i) + 3)
+#define B64_PAIRS_16(i) B64_PAIRS_4(i), B64_PAIRS_4((i) + 4), B64_PAIRS_4((i) + 8), B64_PAIRS_4((i) + 12)
+#define B64_PAIRS_64(i) B64_PAIRS_16(i), B64_PAIRS_16((i) + 16), B64_PAIRS_16((i) + 32), B64_PAIRS_16((i) + 48)
+#define B64_PAIRS_256(i) B64_PAIRS_64(i), B64_PAIRS_64((i) + 64), B64_PAIRS_64((i) + 128), B64_PAIRS_64((i) + 192)
+#define B64_PAIRS_1024(i) B64_PAIRS_256(i), B64_PAIRS_256((i) + 256), B64_PAIRS_256((i) + 512), B64_PAIRS_256((i) + 768)
+
+static const char base64_pair_table[4096 * 2] =
+    {
+        B64_PAIRS_1024(0), B64_PAIRS_1024(1024), B64_PAIRS_1024(2048), B64_PAIRS_1024(3072)
+    };
+
 static char get_base_64(uint32_t _24_bit_value, int shift)
 {
     uint32_t _6_bit_value = 0x3F & (_24_bit_value >> shift);
@@ -200,7 +218,7 @@ static int from_base_64(int c)
 
 size_t hdr_base64_encoded_len(size_t decoded_size)
 {
-    return (size_t) (ceil(decoded_size / 3.0) * 4.0);
+    return (decoded_size + 2) / 3 * 4;
 }
 
 size_t hdr_base64_decoded_len(size_t encoded_size)
@@ -263,7 +281,27 @@ int hdr_base64_encode(
 
     size_t i = 0;
     size_t j = 0;
-    for (; input_len - i >= 3 && j < output_len; i += 3, j += 4)
+
+    // Four blocks at a time keeps the loads and stores independent of each other
+    for (; input_len - i >= 12; i += 12, j += 16)
+    {
+        const uint8_t* in = &input[i];
+        const uint32_t v0 = ((uint32_t) in[0] << 16) | ((uint32_t) in[1] << 8) | in[2];
+        const uint32_t v1 = ((uint32_t) in[3] << 16) | ((uint32_t) in[4] << 8) | in[5];
+        const uint32_t v2 = ((uint32_t) in[6] << 16) | ((uint32_t) in[7] << 8) | in[8];
+        const uint32_t v3 = ((uint32_t) in[9] << 16) | ((uint32_t) in[10] << 8) | in[11];
+
+        memcpy(&output[j],      &base64_pair_table[(v0 >> 12) * 2], 2);
+        memcpy(&output[j + 2],  &base64_pair_table[(v0 & 0xFFF) * 2], 2);
+        memcpy(&output[j + 4],  &base64_pair_table[(v1 >> 12) * 2], 2);
+        memcpy(&output[j + 6],  &base64_pair_table[(v1 & 0xFFF) * 2], 2);
+        memcpy(&output[j + 8],  &base64_pair_table[(v2 >> 12) * 2], 2);
+        memcpy(&output[j + 10], &base64_pair_table[(v2 & 0xFFF) * 2], 2);
+        memcpy(&output[j + 12], &base64_pair_table[(v3 >> 12) * 2], 2);
+        memcpy(&output[j + 14], &base64_pair_table[(v3 & 0xFFF) * 2], 2);
+    }
+
+    for (; input_len - i >= 3; i += 3, j += 4)
     {
         hdr_base64_encode_block(&input[i], &output[j]);
     }
@@ -71,6 +71,37 @@ static void update_min_max(struct hdr_histogram* h, int64_t value)
     h->max_value = (value > h->max_value) ? value : h->max_value;
 }
 
+static void counts_inc_normalised_atomic(
+    struct hdr_histogram* h, int32_t index, int64_t value)
+{
+    int32_t normalised_index = normalize_index(h, index);
+    __atomic_add_fetch(&h->counts[normalised_index], value, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&h->total_count, value, __ATOMIC_SEQ_CST);
+}
+
+static void update_min_max_atomic(struct hdr_histogram* h, int64_t value)
+{
+    int64_t current_min_value = __atomic_load_n(&h->min_value, __ATOMIC_SEQ_CST);
+    while (value != 0 && value < current_min_value)
+    {
+        if (__atomic_compare_exchange_n(
+                &h->min_value, &current_min_value, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        {
+            break;
+        }
+    }
+
+    int64_t current_max_value = __atomic_load_n(&h->max_value, __ATOMIC_SEQ_CST);
+    while (value > current_max_value)
+    {
+        if (__atomic_compare_exchange_n(
+                &h->max_value, &current_max_value, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        {
+            break;
+        }
+    }
+}
+
 // ##     ## ######## #### ##       #### ######## ##    ##
 // ##     ##    ##     ##  ##        ##     ##     ##  ##
 // ##     ##    ##     ##  ##        ##     ##      ####
@@ -389,6 +420,31 @@ bool hdr_record_values(struct hdr_histogram* h, int64_t value, int64_t count)
     return true;
 }
 
+bool hdr_record_value_atomic(struct hdr_histogram* h, int64_t value)
+{
+    return hdr_record_values_atomic(h, value, 1);
+}
+
+bool hdr_record_values_atomic(struct hdr_histogram* h, int64_t value, int64_t count)
+{
+    if (value < 0)
+    {
+        return false;
+    }
+
+    int32_t counts_index = counts_index_for(h, value);
+
+    if (counts_index < 0 || h->counts_len <= counts_index)
+    {
+        return false;
+    }
+
+    counts_inc_normalised_atomic(h, counts_index, count);
+    update_min_max_atomic(h, value);
+
+    return true;
+}
+
 bool hdr_record_corrected_value(struct hdr_histogram* h, int64_t value, int64_t expected_interval)
 {
     return hdr_record_corrected_values(h, value, 1, expected_interval);
@@ -491,25 +547,60 @@ int64_t hdr_min(const struct hdr_histogram* h)
     return non_zero_min(h);
 }
 
+static int64_t count_at_percentile(const struct hdr_histogram* h, double percentile)
+{
+    double requested_percentile = percentile < 100.0 ? percentile : 100.0;
+    int64_t count =
+        (int64_t) (((requested_percentile / 100) * h->total_count) + 0.5);
+    return count > 1 ? count : 1;
+}
+
 int64_t hdr_value_at_percentile(const struct hdr_histogram* h, double percentile)
 {
+    int64_t value;
+
+    hdr_value_at_percentiles(h, &percentile, &value, 1);
+    return value;
+}
+
+int hdr_value_at_percentiles(
+        const struct hdr_histogram* h, const double* percentiles, int64_t* values, size_t length)
+{
+    size_t i;
+
+    for (i = 1; i < length; i++)
+    {
+        if (percentiles[i] < percentiles[i - 1])
+        {
+            return EINVAL;
+        }
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        values[i] = 0;
+    }
+
     struct hdr_iter iter;
     hdr_iter_init(&iter, h);
 
-    double requested_percentile = percentile < 100.0 ? percentile : 100.0;
-    int64_t count_at_percentile =
-        (int64_t) (((requested_percentile / 100) * h->total_count) + 0.5);
-    count_at_percentile = count_at_percentile > 1 ? count_at_percentile : 1;
     int64_t total = 0;
+    size_t at = 0;
+    int64_t count = length ? count_at_percentile(h, percentiles[0]) : 0;
 
-    while (hdr_iter_next(&iter))
+    while (at < length && hdr_iter_next(&iter))
     {
         total += iter.count;
 
-        if (total >= count_at_percentile)
+        // Several percentiles may fall in the same bucket
+        while (at < length && total >= count)
         {
-            int64_t value_from_index = iter.value;
-            return highest_equivalent_value(h, value_from_index);
+            values[at] = highest_equivalent_value(h, iter.value);
+            at++;
+            if (at < length)
+            {
+                count = count_at_percentile(h, percentiles[at]);
+            }
         }
     }
 
@@ -113,6 +113,32 @@ bool hdr_record_value(struct hdr_histogram* h, int64_t value);
  */
 bool hdr_record_values(struct hdr_histogram* h, int64_t value, int64_t count);
 
+/**
+ * Records a value in the histogram, safe to call from any number of threads
+ * concurrently.  The counts, the total count and the min and max are each
+ * updated atomically, a reader that isn't synchronised with the writers (see
+ * hdr_interval_recorder) may see a total count that is slightly ahead or behind
+ * the sum of the counts.
+ *
+ * @param h "This" pointer
+ * @param value Value to add to the histogram
+ * @return false if the value is larger than the highest_trackable_value and can't be recorded,
+ * true otherwise.
+ */
+bool hdr_record_value_atomic(struct hdr_histogram* h, int64_t value);
+
+/**
+ * Records count values in the histogram, safe to call from any number of
+ * threads concurrently.  See hdr_record_value_atomic.
+ *
+ * @param h "This" pointer
+ * @param value Value to add to the histogram
+ * @param count Number of 'value's to add to the histogram
+ * @return false if any value is larger than the highest_trackable_value and can't be recorded,
+ * true otherwise.
+ */
+bool hdr_record_values_atomic(struct hdr_histogram* h, int64_t value, int64_t count);
+
 
 /**
  * Record a value in the histogram and backfill based on an expected interval.
@@ -192,6 +218,19 @@ int64_t hdr_max(const struct hdr_histogram* h);
  */
 int64_t hdr_value_at_percentile(const struct hdr_histogram* h, double percentile);
 
+/**
+ * Get the values at several percentiles in a single pass over the counts,
+ * each call to hdr_value_at_percentile walks the counts from the start.
+ *
+ * @param h "This" pointer.
+ * @param percentiles The percentiles to get the values for, in ascending order
+ * @param values Output array of the same length, the value for each percentile
+ * @param length Number of percentiles
+ * @return 0 on success, EINVAL if the percentiles are not in ascending order.
+ */
+int hdr_value_at_percentiles(
+        const struct hdr_histogram* h, const double* percentiles, int64_t* values, size_t length);
+
 /**
  * Gets the standard deviation for the values in the histogram.
  *
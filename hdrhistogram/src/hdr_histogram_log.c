@@ -223,24 +223,20 @@ typedef struct __attribute__((__packed__))
     uint8_t data[0];
 } _compression_flyweight;
 
-int hdr_encode_compressed(
-    struct hdr_histogram* h,
-    uint8_t** compressed_histogram,
-    size_t* compressed_len)
+static size_t encoded_v2_max_len(const struct hdr_histogram* h, int32_t* counts_limit)
 {
-    _encoding_flyweight_v1* encoded = NULL;
-    _compression_flyweight* compressed = NULL;
-    int result = 0;
-
     int32_t len_to_max = counts_index_for(h, h->max_value) + 1;
-    int32_t counts_limit = len_to_max < h->counts_len ? len_to_max : h->counts_len;
+    *counts_limit = len_to_max < h->counts_len ? len_to_max : h->counts_len;
 
-    const size_t encoded_len = sizeof(_encoding_flyweight_v1) + MAX_BYTES_LEB128 * (size_t) counts_limit;
-    if ((encoded = (_encoding_flyweight_v1*) calloc(encoded_len, sizeof(uint8_t))) == NULL)
-    {
-        FAIL_AND_CLEANUP(cleanup, result, ENOMEM);
-    }
+    return sizeof(_encoding_flyweight_v1) + MAX_BYTES_LEB128 * (size_t) *counts_limit;
+}
 
+/**
+ * Counts are ZigZag LEB128 encoded and runs of zeros are collapsed into a
+ * single negative count, so a sparse histogram packs into a few bytes.
+ */
+static size_t encode_v2(const struct hdr_histogram* h, int32_t counts_limit, _encoding_flyweight_v1* encoded)
+{
     int data_index = 0;
     int i;
     for (i = 0; i < counts_limit;)
@@ -276,6 +272,27 @@ int hdr_encode_compressed(
     encoded->highest_trackable_value  = htobe64(h->highest_trackable_value);
     encoded->conversion_ratio_bits    = htobe64(double_to_int64_bits(h->conversion_ratio));
 
+    return encoded_size;
+}
+
+int hdr_encode_compressed(
+    struct hdr_histogram* h,
+    uint8_t** compressed_histogram,
+    size_t* compressed_len)
+{
+    _encoding_flyweight_v1* encoded = NULL;
+    _compression_flyweight* compressed = NULL;
+    int result = 0;
+    int32_t counts_limit;
+
+    const size_t encoded_len = encoded_v2_max_len(h, &counts_limit);
+    if ((encoded = (_encoding_flyweight_v1*) calloc(encoded_len, sizeof(uint8_t))) == NULL)
+    {
+        FAIL_AND_CLEANUP(cleanup, result, ENOMEM);
+    }
+
+    size_t encoded_size = encode_v2(h, counts_limit, encoded);
+
 
     // Estimate the size of the compressed histogram.
     uLongf destLen = compressBound(encoded_size);
@@ -1066,35 +1083,161 @@ cleanup:
 
 int hdr_log_encode(struct hdr_histogram* histogram, char** encoded_histogram)
 {
-    char *encoded_histogram_tmp = NULL;
-    uint8_t* compressed_histogram = NULL;
-    size_t compressed_len = 0;
-    int rc = 0;
-    int result = 0;
+    struct hdr_log_encoder encoder;
+    const char* encoded;
     size_t encoded_len;
 
-    rc = hdr_encode_compressed(histogram, &compressed_histogram, &compressed_len);
+    int rc = hdr_log_encoder_init(&encoder, Z_DEFAULT_COMPRESSION);
     if (rc != 0)
     {
-        FAIL_AND_CLEANUP(cleanup, result, rc);
+        return rc;
     }
 
-    encoded_len = hdr_base64_encoded_len(compressed_len);
-    encoded_histogram_tmp = calloc(encoded_len + 1, sizeof(char));
+    rc = hdr_log_encoder_encode(&encoder, histogram, &encoded, &encoded_len);
+    if (rc == 0)
+    {
+        // Hand the buffer over to the caller
+        *encoded_histogram = encoder.base64;
+        encoder.base64 = NULL;
+    }
 
-    rc = hdr_base64_encode(
-        compressed_histogram, compressed_len, encoded_histogram_tmp, encoded_len);
-    if (rc != 0)
+    hdr_log_encoder_destroy(&encoder);
+
+    return rc;
+}
+
+//  ######## ##    ##  ######   #######  ########  ######## ########
+//  ##       ###   ## ##    ## ##     ## ##     ## ##       ##     ##
+//  ##       ####  ## ##       ##     ## ##     ## ##       ##     ##
+//  ######   ## ## ## ##       ##     ## ##     ## ######   ########
+//  ##       ##  #### ##       ##     ## ##     ## ##       ##   ##
+//  ##       ##   ### ##    ## ##     ## ##     ## ##       ##    ##
+//  ######## ##    ##  ######   #######  ########  ######## ##     ##
+
+int hdr_log_encoder_init(struct hdr_log_encoder* encoder, int compression_level)
+{
+    z_stream* strm;
+
+    memset(encoder, 0, sizeof(*encoder));
+
+    if (compression_level < Z_DEFAULT_COMPRESSION || Z_BEST_COMPRESSION < compression_level)
     {
-        FAIL_AND_CLEANUP(cleanup, result, rc);
+        return EINVAL;
     }
 
-    *encoded_histogram = encoded_histogram_tmp;
+    if ((strm = calloc(1, sizeof(z_stream))) == NULL)
+    {
+        return ENOMEM;
+    }
 
-cleanup:
-    free(compressed_histogram);
+    strm_init(strm);
+    if (deflateInit(strm, compression_level) != Z_OK)
+    {
+        free(strm);
+        return HDR_DEFLATE_INIT_FAIL;
+    }
 
-    return result;
+    encoder->compression_level = compression_level;
+    encoder->deflate_stream = strm;
+
+    return 0;
+}
+
+void hdr_log_encoder_destroy(struct hdr_log_encoder* encoder)
+{
+    if (encoder->deflate_stream)
+    {
+        deflateEnd(encoder->deflate_stream);
+        free(encoder->deflate_stream);
+    }
+
+    free(encoder->encoded);
+    free(encoder->compressed);
+    free(encoder->base64);
+    memset(encoder, 0, sizeof(*encoder));
+}
+
+static int ensure_capacity(void** buffer, size_t* capacity, size_t len)
+{
+    if (len <= *capacity)
+    {
+        return 0;
+    }
+
+    // Grow geometrically so that a slowly growing histogram doesn't reallocate every time
+    size_t new_capacity = *capacity * 2 > len ? *capacity * 2 : len;
+    void* new_buffer = realloc(*buffer, new_capacity);
+    if (NULL == new_buffer)
+    {
+        return ENOMEM;
+    }
+
+    *buffer = new_buffer;
+    *capacity = new_capacity;
+
+    return 0;
+}
+
+int hdr_log_encoder_encode(
+    struct hdr_log_encoder* encoder,
+    const struct hdr_histogram* histogram,
+    const char** encoded_histogram,
+    size_t* encoded_len)
+{
+    z_stream* strm = encoder->deflate_stream;
+    int32_t counts_limit;
+
+    size_t max_len = encoded_v2_max_len(histogram, &counts_limit);
+    if (ensure_capacity((void**) &encoder->encoded, &encoder->encoded_capacity, max_len))
+    {
+        return ENOMEM;
+    }
+
+    size_t encoded_size = encode_v2(histogram, counts_limit, (_encoding_flyweight_v1*) encoder->encoded);
+
+    if (deflateReset(strm) != Z_OK)
+    {
+        return HDR_DEFLATE_FAIL;
+    }
+
+    size_t bound = deflateBound(strm, encoded_size);
+    if (ensure_capacity((void**) &encoder->compressed, &encoder->compressed_capacity, sizeof(_compression_flyweight) + bound))
+    {
+        return ENOMEM;
+    }
+
+    _compression_flyweight* compressed = (_compression_flyweight*) encoder->compressed;
+    strm->next_in = encoder->encoded;
+    strm->avail_in = (uInt) encoded_size;
+    strm->next_out = compressed->data;
+    strm->avail_out = (uInt) bound;
+
+    if (deflate(strm, Z_FINISH) != Z_STREAM_END)
+    {
+        return HDR_DEFLATE_FAIL;
+    }
+
+    compressed->cookie = htobe32(V2_COMPRESSION_COOKIE | 0x10);
+    compressed->length = htobe32((int32_t) strm->total_out);
+
+    size_t compressed_len = sizeof(_compression_flyweight) + strm->total_out;
+    size_t base64_len = hdr_base64_encoded_len(compressed_len);
+    if (ensure_capacity((void**) &encoder->base64, &encoder->base64_capacity, base64_len + 1))
+    {
+        return ENOMEM;
+    }
+
+    int rc = hdr_base64_encode(encoder->compressed, compressed_len, encoder->base64, base64_len);
+    if (rc != 0)
+    {
+        return rc;
+    }
+    encoder->base64[base64_len] = '\0';
+
+    *encoded_histogram = encoder->base64;
+    *encoded_len = base64_len;
+
+    return 0;
 }
 
 int hdr_log_decode(struct hdr_histogram** histogram, char* base64_histogram, size_t base64_len)
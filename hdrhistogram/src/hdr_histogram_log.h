@@ -38,6 +38,58 @@ int hdr_log_encode(struct hdr_histogram* histogram, char** encoded_histogram);
  */
 int hdr_log_decode(struct hdr_histogram** histogram, char* base64_histogram, size_t base64_len);
 
+/**
+ * Reusable state for encoding many histograms, as for periodic logs.  The
+ * buffers are kept between calls and only grow to fit the largest histogram
+ * encoded, the deflate stream is reset rather than set up again.
+ */
+struct hdr_log_encoder
+{
+    int compression_level;
+    void* deflate_stream;
+    uint8_t* encoded;
+    size_t encoded_capacity;
+    uint8_t* compressed;
+    size_t compressed_capacity;
+    char* base64;
+    size_t base64_capacity;
+};
+
+/**
+ * Initialise the encoder.
+ *
+ * @param encoder 'This' pointer
+ * @param compression_level zlib compression level, 0 (none) to 9 (best) or -1
+ * for the zlib default which is what hdr_log_encode uses.
+ * @return 0 on success, EINVAL for an invalid level, ENOMEM or
+ * HDR_DEFLATE_INIT_FAIL.
+ */
+int hdr_log_encoder_init(struct hdr_log_encoder* encoder, int compression_level);
+
+/**
+ * Free the buffers of the encoder, strings it returned are no longer valid.
+ *
+ * @param encoder 'This' pointer
+ */
+void hdr_log_encoder_destroy(struct hdr_log_encoder* encoder);
+
+/**
+ * Encode and compress the histogram in the same format as hdr_log_encode into
+ * the buffers of the encoder.
+ *
+ * @param encoder 'This' pointer
+ * @param histogram The histogram to encode
+ * @param encoded_histogram Set to the null terminated base64 string, it is
+ * owned by the encoder and valid until the next call.
+ * @param encoded_len Set to the length of the string.
+ * @return 0 on success, ENOMEM or HDR_DEFLATE_FAIL.
+ */
+int hdr_log_encoder_encode(
+    struct hdr_log_encoder* encoder,
+    const struct hdr_histogram* histogram,
+    const char** encoded_histogram,
+    size_t* encoded_len);
+
 struct hdr_log_writer
 {
 };
@@ -4,6 +4,8 @@
  * as explained at http://creativecommons.org/publicdomain/zero/1.0/
  */
 
+#include <stdlib.h>
+
 #include "hdr_interval_recorder.h"
 
 int hdr_interval_recorder_init(struct hdr_interval_recorder* r)
@@ -50,3 +52,98 @@ void* hdr_interval_recorder_sample(struct hdr_interval_recorder* r)
 
     return r->inactive;
 }
+
+int hdr_interval_recorder_init_all(
+    struct hdr_interval_recorder* r,
+    int64_t lowest_trackable_value,
+    int64_t highest_trackable_value,
+    int significant_figures)
+{
+    struct hdr_histogram* active;
+    struct hdr_histogram* inactive;
+
+    int rc = hdr_interval_recorder_init(r);
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = hdr_init(lowest_trackable_value, highest_trackable_value, significant_figures, &active);
+    if (rc)
+    {
+        hdr_interval_recorder_destroy(r);
+        return rc;
+    }
+
+    rc = hdr_init(lowest_trackable_value, highest_trackable_value, significant_figures, &inactive);
+    if (rc)
+    {
+        free(active);
+        hdr_interval_recorder_destroy(r);
+        return rc;
+    }
+
+    r->active = active;
+    r->inactive = inactive;
+
+    return 0;
+}
+
+void hdr_interval_recorder_destroy_all(struct hdr_interval_recorder* r)
+{
+    hdr_interval_recorder_destroy(r);
+    free(r->active);
+    free(r->inactive);
+    r->active = NULL;
+    r->inactive = NULL;
+}
+
+bool hdr_interval_recorder_record_value(struct hdr_interval_recorder* r, int64_t value)
+{
+    int64_t val = hdr_phaser_writer_enter(&r->phaser);
+
+    struct hdr_histogram* active = __atomic_load_n(&r->active, __ATOMIC_SEQ_CST);
+
+    bool recorded = hdr_record_value(active, value);
+
+    hdr_phaser_writer_exit(&r->phaser, val);
+
+    return recorded;
+}
+
+bool hdr_interval_recorder_record_value_atomic(struct hdr_interval_recorder* r, int64_t value)
+{
+    int64_t val = hdr_phaser_writer_enter(&r->phaser);
+
+    struct hdr_histogram* active = __atomic_load_n(&r->active, __ATOMIC_SEQ_CST);
+
+    bool recorded = hdr_record_value_atomic(active, value);
+
+    hdr_phaser_writer_exit(&r->phaser, val);
+
+    return recorded;
+}
+
+int64_t hdr_interval_recorder_sample_into(struct hdr_interval_recorder* r, struct hdr_histogram* into)
+{
+    struct hdr_histogram* sample;
+    int64_t dropped;
+
+    hdr_phaser_reader_lock(&r->phaser);
+
+    sample = r->active;
+
+    // volatile write
+    __atomic_store_n(&r->active, r->inactive, __ATOMIC_SEQ_CST);
+    r->inactive = sample;
+
+    // Wait for the writers that may still be recording into the sample
+    hdr_phaser_flip_phase(&r->phaser, 0);
+
+    dropped = hdr_add(into, sample);
+    hdr_reset(sample);
+
+    hdr_phaser_reader_unlock(&r->phaser);
+
+    return dropped;
+}
@@ -8,6 +8,7 @@
 #define HDR_INTERVAL_RECORDER_H 1
 
 #include "hdr_writer_reader_phaser.h"
+#include "hdr_histogram.h"
 
 struct hdr_interval_recorder
 {
@@ -27,4 +28,48 @@ void hdr_interval_recorder_update(
 
 void* hdr_interval_recorder_sample(struct hdr_interval_recorder* r);
 
+/**
+ * Initialise the recorder with an active and an inactive histogram, both
+ * created with hdr_init and the given parameters.
+ *
+ * @return 0 on success, the error of hdr_init or of the phaser otherwise.
+ */
+int hdr_interval_recorder_init_all(
+    struct hdr_interval_recorder* r,
+    int64_t lowest_trackable_value,
+    int64_t highest_trackable_value,
+    int significant_figures);
+
+/**
+ * Destroy a recorder set up by hdr_interval_recorder_init_all and free its histograms.
+ */
+void hdr_interval_recorder_destroy_all(struct hdr_interval_recorder* r);
+
+/**
+ * Record a value in the active histogram.  Only a single thread may record
+ * into a recorder this way, giving each recording thread its own recorder
+ * keeps the hot path free of any cache line shared with other writers.
+ *
+ * @return false if the value can't be recorded, see hdr_record_value.
+ */
+bool hdr_interval_recorder_record_value(struct hdr_interval_recorder* r, int64_t value);
+
+/**
+ * Record a value in the active histogram, any number of threads may record
+ * into the same recorder concurrently.
+ *
+ * @return false if the value can't be recorded, see hdr_record_value.
+ */
+bool hdr_interval_recorder_record_value_atomic(struct hdr_interval_recorder* r, int64_t value);
+
+/**
+ * Swap the histograms and add everything recorded since the previous sample
+ * into 'into', then reset the sampled histogram.  The writers are not blocked,
+ * each value recorded ends up in exactly one sample.  Summing the per-thread
+ * recorders into a single histogram gives a consistent snapshot of all of them.
+ *
+ * @return The number of values dropped when adding, see hdr_add.
+ */
+int64_t hdr_interval_recorder_sample_into(struct hdr_interval_recorder* r, struct hdr_histogram* into);
+
 #endif
@@ -613,6 +613,95 @@ static char* log_reader_fails_with_incorrect_version()
     return 0;
 }
 
+static char* base64_encode_matches_block_encoding()
+{
+    uint8_t input[100];
+    char expected[140];
+    char output[140];
+    size_t len;
+    size_t i;
+
+    for (i = 0; i < sizeof(input); i++)
+    {
+        input[i] = (uint8_t) (i * 167 + 13);
+    }
+
+    for (len = 0; len <= sizeof(input); len++)
+    {
+        size_t encoded_len = hdr_base64_encoded_len(len);
+
+        memset(expected, 0, sizeof(expected));
+        memset(output, 0, sizeof(output));
+        for (i = 0; i + 3 <= len; i += 3)
+        {
+            hdr_base64_encode_block(&input[i], &expected[i / 3 * 4]);
+        }
+        if (i < len)
+        {
+            uint8_t last[3] = { 0, 0, 0 };
+            memcpy(last, &input[i], len - i);
+            hdr_base64_encode_block(last, &expected[i / 3 * 4]);
+            memset(&expected[encoded_len - (3 - (len - i))], '=', 3 - (len - i));
+        }
+
+        mu_assert("Should encode", hdr_base64_encode(input, len, output, encoded_len) == 0);
+        mu_assert("Encoding should match the block encoding", memcmp(expected, output, encoded_len) == 0);
+    }
+
+    return 0;
+}
+
+static char* encoder_round_trips_and_reuses_buffers()
+{
+    struct hdr_log_encoder encoder;
+    struct hdr_histogram* decoded = NULL;
+    const int levels[] = { -1, 0, 1, 9 };
+    const char* encoded;
+    size_t encoded_len;
+    char* expected;
+    size_t i;
+
+    load_histograms();
+
+    mu_assert("Invalid level should fail", hdr_log_encoder_init(&encoder, 10) == EINVAL);
+
+    for (i = 0; i < sizeof(levels) / sizeof(levels[0]); i++)
+    {
+        mu_assert("Should init", hdr_log_encoder_init(&encoder, levels[i]) == 0);
+
+        // Alternate the histograms so the buffers are reused at different sizes
+        mu_assert("Should encode", hdr_log_encoder_encode(&encoder, cor_histogram, &encoded, &encoded_len) == 0);
+        mu_assert("Length should match", strlen(encoded) == encoded_len);
+        mu_assert("Should decode", hdr_log_decode(&decoded, (char*) encoded, encoded_len) == 0);
+        mu_assert("Histograms should be the same", compare_histogram(cor_histogram, decoded));
+        free(decoded);
+        decoded = NULL;
+
+        mu_assert("Should encode", hdr_log_encoder_encode(&encoder, raw_histogram, &encoded, &encoded_len) == 0);
+        mu_assert("Should decode", hdr_log_decode(&decoded, (char*) encoded, encoded_len) == 0);
+        mu_assert("Histograms should be the same", compare_histogram(raw_histogram, decoded));
+        free(decoded);
+        decoded = NULL;
+
+        mu_assert("Should encode", hdr_log_encoder_encode(&encoder, cor_histogram, &encoded, &encoded_len) == 0);
+        mu_assert("Should decode", hdr_log_decode(&decoded, (char*) encoded, encoded_len) == 0);
+        mu_assert("Histograms should be the same", compare_histogram(cor_histogram, decoded));
+        free(decoded);
+        decoded = NULL;
+
+        if (levels[i] == -1)
+        {
+            mu_assert("Should encode", hdr_log_encode(cor_histogram, &expected) == 0);
+            mu_assert("Default level should match hdr_log_encode", strcmp(expected, encoded) == 0);
+            free(expected);
+        }
+
+        hdr_log_encoder_destroy(&encoder);
+    }
+
+    return 0;
+}
+
 static char* test_encode_decode_empty()
 {
     struct hdr_histogram *histogram, *hdr_new = NULL;
@@ -804,6 +893,8 @@ static struct mu_result all_tests()
     mu_run_test(base64_encode_fails_with_invalid_lengths);
     mu_run_test(base64_encode_encodes_without_padding);
     mu_run_test(base64_encode_encodes_with_padding);
+    mu_run_test(base64_encode_matches_block_encoding);
+    mu_run_test(encoder_round_trips_and_reuses_buffers);
 
     mu_run_test(writes_and_reads_log);
     mu_run_test(log_reader_aggregates_into_single_histogram);
@@ -8,6 +8,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <string.h>
 
 #include <stdio.h>
 #include <hdr_histogram.h>
@@ -435,6 +436,76 @@ static char* test_out_of_range_values()
     return 0;
 }
 
+static char* test_value_at_percentiles()
+{
+    const double percentiles[] = { 0.0, 30.0, 50.0, 50.0, 90.0, 99.0, 99.99, 100.0 };
+    const size_t length = sizeof(percentiles) / sizeof(percentiles[0]);
+    const double unsorted[] = { 50.0, 30.0 };
+    int64_t values[sizeof(percentiles) / sizeof(percentiles[0])];
+    struct hdr_histogram* h;
+    size_t i;
+
+    load_histograms();
+
+    mu_assert("Should succeed", hdr_value_at_percentiles(cor_histogram, percentiles, values, length) == 0);
+    for (i = 0; i < length; i++)
+    {
+        mu_assert(
+                "Value should match the single percentile query",
+                compare_int64(values[i], hdr_value_at_percentile(cor_histogram, percentiles[i])));
+    }
+
+    mu_assert("Should succeed", hdr_value_at_percentiles(raw_histogram, percentiles, values, length) == 0);
+    for (i = 0; i < length; i++)
+    {
+        mu_assert(
+                "Value should match the single percentile query",
+                compare_int64(values[i], hdr_value_at_percentile(raw_histogram, percentiles[i])));
+    }
+
+    mu_assert("Unsorted percentiles should fail", hdr_value_at_percentiles(raw_histogram, unsorted, values, 2) == EINVAL);
+
+    hdr_init(1, 1000, 3, &h);
+    mu_assert("Should succeed", hdr_value_at_percentiles(h, percentiles, values, length) == 0);
+    for (i = 0; i < length; i++)
+    {
+        mu_assert("Empty histogram values should be 0", values[i] == 0);
+    }
+    free(h);
+
+    return 0;
+}
+
+static char* test_record_value_atomic()
+{
+    struct hdr_histogram* h;
+    struct hdr_histogram* atomic_h;
+    int i;
+
+    load_histograms();
+    hdr_init(1, INT64_C(3600) * 1000 * 1000, 3, &h);
+    hdr_init(1, INT64_C(3600) * 1000 * 1000, 3, &atomic_h);
+
+    for (i = 0; i < 10000; i++)
+    {
+        hdr_record_value(h, i * 37);
+        hdr_record_value_atomic(atomic_h, i * 37);
+    }
+    hdr_record_values(h, 100000000, 5);
+    hdr_record_values_atomic(atomic_h, 100000000, 5);
+
+    mu_assert("Total count should match", compare_int64(h->total_count, atomic_h->total_count));
+    mu_assert("Min should match", compare_int64(hdr_min(h), hdr_min(atomic_h)));
+    mu_assert("Max should match", compare_int64(hdr_max(h), hdr_max(atomic_h)));
+    mu_assert("Counts should match", memcmp(h->counts, atomic_h->counts, h->counts_len * sizeof(int64_t)) == 0);
+    mu_assert("Should not record value", !hdr_record_value_atomic(atomic_h, INT64_C(3600) * 1000 * 1000 * 1000));
+
+    free(h);
+    free(atomic_h);
+
+    return 0;
+}
+
 static struct mu_result all_tests()
 {
     mu_run_test(test_create);
@@ -451,6 +522,8 @@ static struct mu_result all_tests()
     mu_run_test(test_reset);
     mu_run_test(test_scaling_equivalence);
     mu_run_test(test_out_of_range_values);
+    mu_run_test(test_value_at_percentiles);
+    mu_run_test(test_record_value_atomic);
 
     mu_ok;
 }
@@ -0,0 +1,184 @@
+/**
+ * hdr_interval_recorder_test.c
+ * Released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <hdr_histogram.h>
+#include <hdr_interval_recorder.h>
+
+#include "minunit.h"
+
+#define NUM_THREADS 4
+#define VALUES_PER_THREAD 200000
+
+int tests_run = 0;
+
+struct writer
+{
+    struct hdr_histogram* h;
+    struct hdr_interval_recorder* r;
+    int64_t base;
+    bool done;
+};
+
+static int64_t writer_value(const struct writer* w, int i)
+{
+    return w->base + (i % 1000) + 1;
+}
+
+static void* record_atomic(void* arg)
+{
+    struct writer* w = arg;
+    int i;
+
+    for (i = 0; i < VALUES_PER_THREAD; i++)
+    {
+        hdr_record_value_atomic(w->h, writer_value(w, i));
+    }
+
+    return NULL;
+}
+
+static void* record_recorder(void* arg)
+{
+    struct writer* w = arg;
+    int i;
+
+    for (i = 0; i < VALUES_PER_THREAD; i++)
+    {
+        hdr_interval_recorder_record_value(w->r, writer_value(w, i));
+    }
+    __atomic_store_n(&w->done, true, __ATOMIC_SEQ_CST);
+
+    return NULL;
+}
+
+static char* test_concurrent_atomic_record()
+{
+    struct hdr_histogram* h;
+    pthread_t threads[NUM_THREADS];
+    struct writer writers[NUM_THREADS];
+    int i;
+
+    hdr_init(1, INT64_C(3600) * 1000 * 1000, 3, &h);
+
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        writers[i].h = h;
+        writers[i].base = i * 1000;
+        pthread_create(&threads[i], NULL, record_atomic, &writers[i]);
+    }
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    mu_assert("Total count should include every value", compare_int64(h->total_count, NUM_THREADS * VALUES_PER_THREAD));
+    mu_assert("Min should be the smallest value", compare_int64(hdr_min(h), 1));
+    mu_assert("Max should be the largest value", hdr_values_are_equivalent(h, hdr_max(h), NUM_THREADS * 1000));
+    mu_assert("Count at a value should include every thread", compare_int64(hdr_count_at_value(h, 500), VALUES_PER_THREAD / 1000));
+
+    free(h);
+
+    return 0;
+}
+
+static char* test_per_thread_recorders_merge()
+{
+    struct hdr_interval_recorder recorders[NUM_THREADS];
+    struct writer writers[NUM_THREADS];
+    pthread_t threads[NUM_THREADS];
+    struct hdr_histogram* snapshot;
+    int64_t last_total = 0;
+    bool all_done = false;
+    int samples = 0;
+    int i;
+
+    hdr_init(1, INT64_C(3600) * 1000 * 1000, 3, &snapshot);
+
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        mu_assert("Recorder should init", hdr_interval_recorder_init_all(&recorders[i], 1, INT64_C(3600) * 1000 * 1000, 3) == 0);
+        writers[i].r = &recorders[i];
+        writers[i].base = i * 1000;
+        writers[i].done = false;
+        pthread_create(&threads[i], NULL, record_recorder, &writers[i]);
+    }
+
+    // Keep merging while the writers record, the snapshot only ever grows
+    while (!all_done)
+    {
+        all_done = true;
+        for (i = 0; i < NUM_THREADS; i++)
+        {
+            all_done &= __atomic_load_n(&writers[i].done, __ATOMIC_SEQ_CST);
+        }
+
+        for (i = 0; i < NUM_THREADS; i++)
+        {
+            mu_assert("Nothing should be dropped", hdr_interval_recorder_sample_into(&recorders[i], snapshot) == 0);
+        }
+        mu_assert("Snapshot should not go back", snapshot->total_count >= last_total);
+        last_total = snapshot->total_count;
+        samples++;
+    }
+
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        hdr_interval_recorder_sample_into(&recorders[i], snapshot);
+    }
+
+    mu_assert("Should have sampled at least once", samples > 0);
+    mu_assert("Total count should include every value", compare_int64(snapshot->total_count, NUM_THREADS * VALUES_PER_THREAD));
+    mu_assert("Min should be the smallest value", compare_int64(hdr_min(snapshot), 1));
+    mu_assert("Mean should match the values", compare_double(hdr_mean(snapshot), 2000.5, 2.0));
+    mu_assert("Count at a value should include every thread", compare_int64(hdr_count_at_value(snapshot, 500), VALUES_PER_THREAD / 1000));
+
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        mu_assert("Recorder should be empty once sampled", ((struct hdr_histogram*) recorders[i].active)->total_count == 0);
+        hdr_interval_recorder_destroy_all(&recorders[i]);
+    }
+    free(snapshot);
+
+    return 0;
+}
+
+static struct mu_result all_tests()
+{
+    mu_run_test(test_concurrent_atomic_record);
+    mu_run_test(test_per_thread_recorders_merge);
+
+    mu_ok;
+}
+
+static int hdr_interval_recorder_run_tests()
+{
+    struct mu_result result = all_tests();
+
+    if (result.message != 0)
+    {
+        printf("hdr_interval_recorder_test.%s(): %s\n", result.test, result.message);
+    }
+    else
+    {
+        printf("ALL TESTS PASSED\n");
+    }
+
+    printf("Tests run: %d\n", tests_run);
+
+    return result.message == NULL ? 0 : -1;
+}
+
+int main()
+{
+    return hdr_interval_recorder_run_tests();
+}
@@ -27,6 +27,9 @@ typedef struct {
 	sense_info_t info;
 	unsigned char sense[256];
 	unsigned sense_len;
+
+	bool device_time_valid;    /* The OS reported how long the command took in the device */
+	uint32_t device_time_msec;
 } io_result_t;
 
 typedef enum {
@@ -35,7 +38,14 @@ typedef enum {
 	DISK_MOUNTED_RW = 2,
 } disk_mount_e;
 
+typedef struct {
+	uint32_t max_transfer_bytes;   /* Largest transfer the OS will pass down, 0 if unknown */
+	uint32_t optimal_io_bytes;     /* Preferred transfer size reported by the device, 0 if unknown */
+	uint32_t physical_block_bytes; /* 0 if unknown */
+} disk_io_limits_t;
+
 disk_mount_e disk_dev_mount_state(const char *path);
+int disk_dev_io_limits(const char *path, disk_io_limits_t *limits);
 
 bool disk_dev_open(disk_dev_t *dev, const char *path);
 void disk_dev_close(disk_dev_t *dev);
@@ -45,6 +55,12 @@ void disk_dev_cdb_in(disk_dev_t *dev, unsigned char *cdb, unsigned cdb_len, unsi
 		unsigned char *sense, unsigned sense_size, unsigned *sense_read, io_result_t *io_res);
 
 ssize_t disk_dev_read(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res);
+/* Read from the media, bypassing the device cache where possible */
+ssize_t disk_dev_read_fua(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res);
+/* Issue the regular reads with FUA and DPO, from the media and without displacing cached data.
+ * Returns false if the backend can't pass these flags.
+ */
+bool disk_dev_read_bypass_cache(disk_dev_t *dev, bool bypass);
 ssize_t disk_dev_write(disk_dev_t *dev, uint64_t offset_bytes, uint32_t len_bytes, void *buf, io_result_t *io_res);
 int disk_dev_read_cap(disk_dev_t *dev, uint64_t *size_bytes, uint64_t *sector_size);
 int disk_dev_identify(disk_dev_t *dev, char *vendor, char *model, char *fw_rev, char *serial, bool *is_ata, unsigned char *ata_buf, unsigned *ata_buf_len);
@@ -4,6 +4,15 @@
 #include "arch.h"
 #include "libscsicmd/include/ata.h"
 
+typedef struct disk_capacity_t {
+	uint64_t max_lba;
+	uint32_t block_size;
+	unsigned logical_blocks_per_physical_block_exponent;
+	unsigned lowest_aligned_lba;
+	bool thin_provisioning_enabled;
+	bool thin_provisioning_zero;
+} disk_capacity_t;
+
 /** Check if the disk had a smart trip, only relevant for ATA disks.
  *
  * Returns -1 on error, 0 if there is no smart trip and 1 if there is a smart trip.
@@ -15,4 +24,61 @@ int disk_smart_trip(disk_dev_t *dev);
  */
 int disk_smart_attributes(disk_dev_t *dev, ata_smart_attr_t *attrs, int max_attrs);
 
+/** Read the SCT Error Recovery Control time limit of an ATA disk, in 100 msec units.
+ * Returns -1 on error, 0 on success.
+ */
+int disk_ata_sct_erc_get(disk_dev_t *dev, ata_sct_erc_e selection, uint16_t *time_limit);
+
+/** Set the SCT Error Recovery Control time limit of an ATA disk, in 100 msec units, 0 disables the limit.
+ * The setting is volatile, the disk drops it on a power cycle.
+ * Returns -1 on error, 0 on success.
+ */
+int disk_ata_sct_erc_set(disk_dev_t *dev, ata_sct_erc_e selection, uint16_t time_limit);
+
+/** Issue an ATA SET FEATURES command.
+ * Returns -1 on error, 0 on success.
+ */
+int disk_ata_set_features(disk_dev_t *dev, uint8_t feature, uint8_t sector_count);
+
+/** Read a LOG SENSE page with the cumulative values.
+ * Returns -1 on error, the length of the valid page data in buf on success.
+ */
+int disk_log_sense(disk_dev_t *dev, uint8_t page, uint8_t subpage, unsigned char *buf, unsigned buf_size);
+
+/** Read a single mode page, without the mode parameter header and block descriptors.
+ * The device specific parameter of the header is returned if device_specific_param isn't NULL.
+ * Returns -1 on error, the length of the page in buf on success.
+ */
+int disk_mode_page_read(disk_dev_t *dev, uint8_t page, page_control_e page_control, unsigned char *buf, unsigned buf_size, uint8_t *device_specific_param);
+
+/** Write a mode page as read by disk_mode_page_read, the change is not saved and is lost on a power cycle or reset.
+ * Returns -1 on error, 0 on success.
+ */
+int disk_mode_page_write(disk_dev_t *dev, const unsigned char *page, unsigned page_len);
+
+/** Read the full READ CAPACITY 16 data, the OS capacity query only gives the size.
+ * Returns -1 on error, 0 on success.
+ */
+int disk_read_capacity_16(disk_dev_t *dev, disk_capacity_t *cap);
+
+/** Get the provisioning status of the extents starting at start_lba, as many as fit in buf.
+ * Returns -1 on error, the length of the valid data in buf on success.
+ */
+int disk_get_lba_status(disk_dev_t *dev, uint64_t start_lba, unsigned char *buf, unsigned buf_size);
+
+/** Report the zones of a zoned disk starting from the zone that holds start_lba, as many as fit in buf.
+ * Returns -1 on error or when the disk isn't zoned, the length of the valid data in buf on success.
+ */
+int disk_report_zones(disk_dev_t *dev, uint64_t start_lba, unsigned char *buf, unsigned buf_size);
+
+/** Count the entries in the grown defect list, only the list header is read.
+ * Returns -1 on error, number of grown defects on success.
+ */
+int disk_grown_defects_count(disk_dev_t *dev);
+
+/** Read the grown defect list as LBAs sorted in ascending order, *plbas must be freed by the caller.
+ * Returns -1 on error or when the list isn't reported in an LBA format, number of defects on success.
+ */
+int disk_grown_defect_list(disk_dev_t *dev, uint64_t **plbas);
+
 #endif
@@ -6,6 +6,7 @@
 #include "arch.h"
 
 #include "libscsicmd/include/ata.h"
+#include "libscsicmd/include/parse_log_sense.h"
 #include "hdrhistogram/src/hdr_histogram.h"
 
 #define ARRAY_SIZE(a) (sizeof(a)/sizeof(a[0]))
@@ -24,16 +25,119 @@ enum conclusion {
 	CONCLUSION_FAILED_MAX_LATENCY,
 	CONCLUSION_FAILED_LATENCY_PERCENTILE,
 	CONCLUSION_FAILED_IO_ERRORS,
+	CONCLUSION_FAILED_MISCOMPARE,
 };
 
+/* Thresholds that decide the conclusion, defaults can be overridden per model from a policy file */
+typedef struct verdict_policy_t {
+	uint32_t max_latency_msec;
+	double latency_percentile;
+	uint32_t percentile_latency_msec;
+	uint64_t max_io_errors;
+	uint64_t max_miscompare_sectors;
+} verdict_policy_t;
+
+#define LATENCY_PERCENTILES_MAX 6
+
+/* Latency percentiles of the scan, with the policy percentile among them */
+typedef struct latency_percentiles_t {
+	unsigned len;
+	double percentile[LATENCY_PERCENTILES_MAX]; /* Ascending */
+	int64_t value_usec[LATENCY_PERCENTILES_MAX];
+} latency_percentiles_t;
+
+typedef enum stop_early_e {
+	STOP_EARLY_NONE,
+	STOP_EARLY_NOW,  /* Stop as soon as the disk is certain to fail */
+	STOP_EARLY_PASS, /* Finish the pass in progress first, in a burn-in the verify of the pattern being written */
+} stop_early_e;
+
+typedef enum pattern_type_e {
+	PATTERN_CONSTANT, /* A single byte value repeated */
+	PATTERN_LBA,      /* Every 64-bit word holds the LBA of its sector */
+	PATTERN_RANDOM,   /* Pseudorandom from a seed */
+} pattern_type_e;
+
+typedef struct pattern_t {
+	pattern_type_e type;
+	uint64_t value; /* Byte value for a constant pattern, seed for a random one */
+} pattern_t;
+
+#define MAX_BURN_IN_PATTERNS 8
+
+/* Destructive write and verify passes, one pair per pattern */
+typedef struct burn_in_t {
+	unsigned num_patterns;
+	pattern_t patterns[MAX_BURN_IN_PATTERNS];
+	uint64_t miscompare_sectors;
+} burn_in_t;
+
 typedef struct latency_t {
 	uint64_t start_sector;
 	uint64_t end_sector;
 	uint32_t latency_min_msec;
 	uint32_t latency_max_msec;
 	uint32_t latency_median_msec;
+	uint64_t bytes;
+	uint64_t io_nsec;
+	double throughput_mbps;
+	double model_mbps; /* Expected throughput from the fitted zone-rate curve */
+	bool throughput_dip;
+	unsigned grown_defects; /* Defects that were added to the grown list during the scan */
 } latency_t;
 
+/* Breakdown of the scan wall time, all values in nsec */
+typedef struct scan_profile_t {
+	uint64_t total_nsec;
+	uint64_t io_nsec;          /* Wall time of the read calls */
+	uint64_t io_timed_nsec;    /* Part of io_nsec for commands that had a device time reported */
+	uint64_t device_nsec;      /* Device time reported for the io_timed_nsec commands */
+	uint64_t logging_nsec;
+	uint64_t monitor_nsec;
+	uint64_t progress_nsec;
+	uint64_t throttle_nsec;    /* Pauses while the disk is too hot */
+	uint64_t retry_wait_nsec;  /* Backoff before retrying a busy or not ready disk */
+
+	/* Derived at the end of the scan */
+	uint64_t io_overhead_nsec; /* Syscall and OS overhead of the io_timed_nsec commands */
+	uint64_t io_untimed_nsec;  /* I/O time that can't be split into device and overhead */
+	uint64_t other_nsec;
+} scan_profile_t;
+
+/* Drive side error recovery time limits applied for the scan, 0 means no limit */
+typedef struct error_recovery_t {
+	bool active;          /* The limits were changed and must be restored on close */
+	uint32_t read_msec;
+	uint32_t write_msec;
+	uint32_t orig_read_msec;
+	uint32_t orig_write_msec;
+	unsigned char orig_mode_page[32]; /* SCSI Read-Write Error Recovery mode page to restore */
+	unsigned orig_mode_page_len;
+} error_recovery_t;
+
+/* Device cache settings in effect for the scan */
+typedef struct cache_control_t {
+	bool valid;              /* The settings could be read from the disk */
+	bool read_cache;
+	bool write_cache;
+	bool read_ahead;
+	bool fua_supported;
+	bool fua_dpo;            /* Reads are issued with FUA and DPO */
+	bool restore_read_ahead; /* Look-ahead was disabled for the scan and is enabled again on close */
+	unsigned char orig_mode_page[32]; /* SCSI Caching mode page to restore */
+	unsigned orig_mode_page_len;
+} cache_control_t;
+
+/* Outcome of the retry policy for failed I/O */
+typedef struct retry_stats_t {
+	uint64_t retries;     /* Commands reissued after a transient error */
+	uint64_t recovered;   /* Commands that succeeded on a retry */
+	uint64_t bisected;    /* Reads split to isolate a media error */
+	uint64_t bad_sectors; /* Sectors the bisection found unreadable */
+	uint64_t bad_phys_sectors; /* Physical sectors that hold them */
+	uint64_t corrected;   /* Reads the device recovered by its own error correction */
+} retry_stats_t;
+
 typedef struct data_log_raw_t {
 	FILE *f;
 	bool is_first;
@@ -56,8 +160,107 @@ typedef struct ata_state_t {
 } ata_state_t;
 
 typedef struct scsi_state_t {
+	/* Log pages found supported at the start, only these are polled */
+	bool has_temperature_page;
+	bool has_ie_page;
+	bool has_read_errors_page;
+	bool has_verify_errors_page;
+	bool has_grown_defects;
+	int last_temp;
+	uint8_t last_ie_asc;
+	uint8_t last_ie_ascq;
+	log_sense_error_counters_t last_read_errors;
+	log_sense_error_counters_t last_verify_errors;
+	int start_grown_defects;
+	int last_grown_defects;
 } scsi_state_t;
 
+typedef struct grown_defect_t {
+	uint64_t lba;
+	int latency_bucket; /* -1 when it is outside the scanned area */
+} grown_defect_t;
+
+/* Grown defect list snapshots, only available for SCSI disks that report the list in an LBA format */
+typedef struct grown_defects_t {
+	bool valid;
+	bool poll;              /* Diff the list on every monitor poll that sees the count change */
+	uint64_t *start_lbas;   /* Sorted, taken when the disk is opened */
+	unsigned start_len;
+	grown_defect_t *new_defects;
+	unsigned new_len;
+} grown_defects_t;
+
+/* An area the scan skipped over after consecutive read errors and backfilled at the end */
+typedef struct bad_area_t {
+	uint64_t start_sector;
+	uint64_t end_sector;
+	uint64_t unread_start_sector; /* The middle part the backfill found bad and left unread */
+	uint64_t unread_end_sector;
+} bad_area_t;
+
+typedef struct bad_areas_t {
+	bool skip;           /* Skip ahead over bad areas, sequential read scans only */
+	bad_area_t *areas;   /* Ascending order */
+	unsigned len;
+	unsigned size;
+	uint64_t unread_sectors;
+} bad_areas_t;
+
+/* A zone of a zoned (SMR) disk, only the part that holds data is read */
+typedef struct zone_t {
+	uint64_t start_sector;
+	uint64_t len_sectors;
+	uint64_t readable_sectors;
+	uint8_t type;
+	uint8_t cond;
+} zone_t;
+
+typedef struct zones_t {
+	bool zoned;              /* The scan goes zone by zone with one latency bucket per zone */
+	zone_t *zones;           /* Ascending order */
+	unsigned len;
+	uint64_t zone_sectors;   /* All zones have this length, the last one may be shorter */
+	uint64_t readable_sectors;
+	unsigned num_seq_required;
+	unsigned num_empty;
+	unsigned num_offline;
+} zones_t;
+
+typedef struct lba_extent_t {
+	uint64_t start_sector;
+	uint64_t len_sectors;
+} lba_extent_t;
+
+/* Mapped extents of a thin provisioned disk, reads of unmapped extents only measure the controller */
+typedef struct provisioning_t {
+	bool mapped_only;        /* Read only the mapped extents, thin provisioned disks only */
+	unsigned sample_percent; /* Percent of the reads of unmapped extents that are still done */
+	bool valid;              /* The mapped extents were loaded and the scan skips the unmapped ones */
+	lba_extent_t *mapped;    /* Ascending order, adjacent extents merged */
+	unsigned len;
+	uint64_t mapped_sectors;
+	uint64_t skipped_reads;
+	uint64_t sampled_reads;
+} provisioning_t;
+
+#define FINGERPRINT_MAX_REPORTED 1024
+
+/* Comparison of the scan content fingerprints with the ones from the previous scan */
+typedef struct fingerprint_report_t {
+	bool valid;                 /* Fingerprints were saved for this scan */
+	bool compared;              /* A previous fingerprint file for this disk was found */
+	int64_t previous_scan_time;
+	uint32_t chunk_size;
+	uint64_t num_compared;
+	uint64_t num_changed;
+	uint64_t *changed_offsets;  /* Byte offsets of the first FINGERPRINT_MAX_REPORTED changed chunks */
+	unsigned changed_offsets_len;
+} fingerprint_report_t;
+
+struct metrics;
+struct repair;
+struct fingerprint;
+
 typedef struct disk_t {
 	disk_dev_t dev;
 	char path[128];
@@ -74,25 +277,60 @@ typedef struct disk_t {
 	unsigned ata_buf_len;
 	uint64_t num_bytes;
 	uint64_t sector_size;
+	uint64_t phys_sector_size;  /* Larger than sector_size on 512e disks */
+	uint64_t phys_align_offset; /* Byte offset of the first physical sector boundary, from the lowest aligned LBA */
+	bool thin_provisioned;
 	int run;
 	int fix;
 
+	int io_cpu; /* CPU to pin the scan to, -1 to leave it to the scheduler */
+	unsigned jitter_calibration_sec;
+
 	uint64_t num_errors;
 	struct hdr_histogram *histogram;
+	struct hdr_histogram *device_histogram; /* Latencies as reported by the OS for the device alone */
+	struct hdr_histogram *jitter_histogram; /* Host scheduling jitter measured before the scan */
+	struct hdr_histogram *write_histogram;  /* Burn-in write latencies */
+	struct hdr_histogram *retry_histogram;  /* Latencies of retries and bisection reads, kept out of the first attempt latencies */
 	unsigned latency_graph_len;
 	latency_t *latency_graph;
+	latency_t *write_latency_graph;
+	unsigned num_throughput_dips;
+	grown_defects_t glist;
+	bad_areas_t bad_areas;
+	zones_t zones;
+	provisioning_t provisioning;
 	enum conclusion conclusion;
+	latency_percentiles_t latency_percentiles;
+	verdict_policy_t policy;
+	stop_early_e stop_early;
+	enum conclusion early_conclusion; /* Failure that can no longer change, CONCLUSION_PASSED until one is found */
+	bool stopped_early;
+	scan_profile_t profile;
+	burn_in_t burn_in;
+	retry_stats_t retry;
+	error_recovery_t recovery;
+	cache_control_t cache;
 
 	data_log_raw_t data_raw;
 	data_log_t data_log;
+	struct metrics *metrics;
+	struct repair *repair;
+	struct fingerprint *fingerprint;
+	fingerprint_report_t fingerprint_report;
 } disk_t;
 
 int disk_open(disk_t *disk, const char *path, int fix, unsigned latency_graph_len, disk_mount_e allowed_mount);
 int disk_scan(disk_t *disk, enum scan_mode mode, unsigned data_size);
+unsigned disk_scan_size_auto(disk_t *disk, bool *interrupted);
+uint64_t disk_phys_sector(const disk_t *disk, uint64_t offset);
+uint64_t disk_phys_align_down(const disk_t *disk, uint64_t offset);
 int disk_close(disk_t *disk);
 void disk_scan_stop(disk_t *disk);
 
 enum scan_mode str_to_scan_mode(const char *s);
+int str_to_pattern(const char *s, pattern_t *pattern);
+const char *pattern_to_str(const pattern_t *pattern, char *buf, unsigned buf_len);
 const char *conclusion_to_str(enum conclusion conclusion);
 
 /* Implemented by the user (gui/cli) */
@@ -107,4 +345,20 @@ void data_log_raw_end(data_log_raw_t *log_raw);
 void data_log_start(data_log_t *log, const char *filename, disk_t *disk);
 void data_log_end(data_log_t *log, disk_t *disk);
 
+/* Limit the time the disk spends recovering a weak sector until the disk is closed */
+int disk_recovery_limit_set(disk_t *disk, unsigned read_msec, unsigned write_msec);
+
+/* Disable read look-ahead and read with FUA and DPO where supported until the disk is closed */
+int disk_cache_bypass_set(disk_t *disk);
+
+/* Load verdict thresholds for the disk model from a policy file */
+int policy_load(disk_t *disk, const char *path);
+
+/* Keep content fingerprints of the scan in a file and compare them with the previous scan */
+int fingerprint_open(disk_t *disk, const char *path);
+
+/* Used to publish live metrics while the scan runs */
+int metrics_start(disk_t *disk, const char *socket_path, const char *textfile_path);
+void metrics_end(disk_t *disk);
+
 #endif
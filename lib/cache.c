@@ -0,0 +1,178 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+/* Device cache control for measuring the media latency.
+ *
+ * With read look-ahead a sequential scan mostly measures cache hits, a slow
+ * sector is read ahead with its neighbours and the delay is attributed to
+ * whichever read happened to wait for it. Look-ahead is disabled for the scan
+ * and reads are issued with FUA and DPO where the disk supports them.
+ */
+
+#include "cache.h"
+#include "disk.h"
+#include "verbose.h"
+#include "libscsicmd/include/parse_mode_sense.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int cache_mode_page_read(disk_t *disk, page_control_e page_control, unsigned char *page, unsigned page_size, uint8_t *device_specific_param)
+{
+	int page_len = disk_mode_page_read(&disk->dev, MODE_PAGE_CACHING, page_control, page, page_size, device_specific_param);
+	if (page_len < MODE_PAGE_CACHING_LEN)
+		return -1;
+	return page_len;
+}
+
+void cache_probe(disk_t *disk)
+{
+	cache_control_t *c = &disk->cache;
+	unsigned char page[sizeof(c->orig_mode_page)];
+	uint8_t device_specific_param = 0;
+	int page_len;
+
+	// An ATA disk reports its look-ahead state in IDENTIFY, the FUA support comes from the SAT mode header either way
+	page_len = cache_mode_page_read(disk, PAGE_CONTROL_CURRENT, page, sizeof(page), &device_specific_param);
+	c->fua_supported = device_specific_param & MODE_SENSE_DEVICE_DPOFUA;
+
+	if (disk->is_ata && disk->ata_buf_len >= 512) {
+		c->read_cache = true;
+		c->write_cache = ata_identify_write_cache_enabled(disk->ata_buf);
+		c->read_ahead = ata_identify_read_look_ahead_enabled(disk->ata_buf);
+		c->valid = true;
+	} else if (page_len > 0) {
+		uint8_t *param = mode_sense_data_param(page);
+		c->read_cache = !caching_read_cache_disabled(param);
+		c->write_cache = caching_write_cache_enabled(param);
+		c->read_ahead = !caching_read_ahead_disabled(param);
+		c->valid = true;
+	}
+
+	if (c->valid)
+		VERBOSE("Disk cache: read cache %s, write cache %s, read look-ahead %s, FUA %s",
+				c->read_cache ? "on" : "off", c->write_cache ? "on" : "off", c->read_ahead ? "on" : "off",
+				c->fua_supported ? "supported" : "not supported");
+}
+
+static int cache_read_ahead_disable_ata(disk_t *disk)
+{
+	if (!ata_identify_read_look_ahead_supported(disk->ata_buf)) {
+		ERROR("Disk doesn't support disabling the read look-ahead");
+		return -1;
+	}
+
+	return disk_ata_set_features(&disk->dev, ATA_SET_FEATURES_READ_LOOK_AHEAD_DISABLE, 0);
+}
+
+static int cache_read_ahead_disable_scsi(disk_t *disk)
+{
+	cache_control_t *c = &disk->cache;
+	unsigned char page[sizeof(c->orig_mode_page)];
+	unsigned char mask[sizeof(c->orig_mode_page)];
+	int page_len, mask_len;
+
+	page_len = cache_mode_page_read(disk, PAGE_CONTROL_CURRENT, page, sizeof(page), NULL);
+	mask_len = cache_mode_page_read(disk, PAGE_CONTROL_CHANGEABLE, mask, sizeof(mask), NULL);
+	if (page_len < 0 || mask_len != page_len) {
+		ERROR("Failed to read the Caching mode page");
+		return -1;
+	}
+
+	if (!caching_read_ahead_disabled(mode_sense_data_param(mask))) {
+		ERROR("Disk doesn't allow disabling the read look-ahead");
+		return -1;
+	}
+
+	memcpy(c->orig_mode_page, page, page_len);
+	c->orig_mode_page_len = page_len;
+	caching_set_read_ahead_disabled(mode_sense_data_param(page), true);
+	return disk_mode_page_write(&disk->dev, page, page_len);
+}
+
+/* An ATA disk behind a SAT layer may not support FUA on reads even if it does on writes, a test read confirms it */
+static bool cache_read_fua_works(disk_t *disk)
+{
+	io_result_t io_res;
+	void *buf;
+	ssize_t ret;
+
+	if (posix_memalign(&buf, 4096, disk->sector_size))
+		return false;
+	ret = disk_dev_read(&disk->dev, 0, disk->sector_size, buf, &io_res);
+	free(buf);
+	return ret == (ssize_t)disk->sector_size && io_res.data == DATA_FULL &&
+		(io_res.error == ERROR_NONE || io_res.error == ERROR_CORRECTED);
+}
+
+int disk_cache_bypass_set(disk_t *disk)
+{
+	cache_control_t *c = &disk->cache;
+
+	if (!c->valid) {
+		ERROR("Failed to read the disk cache settings, can't bypass the cache");
+		return -1;
+	}
+
+	if (c->read_ahead) {
+		if (disk->is_ata ? cache_read_ahead_disable_ata(disk) : cache_read_ahead_disable_scsi(disk)) {
+			ERROR("Failed to disable the read look-ahead");
+			return -1;
+		}
+		c->read_ahead = false;
+		c->restore_read_ahead = true;
+		INFO("Read look-ahead disabled for the scan");
+	}
+
+	if (c->fua_supported && disk_dev_read_bypass_cache(&disk->dev, true)) {
+		if (cache_read_fua_works(disk)) {
+			c->fua_dpo = true;
+			INFO("Reads are issued with FUA and DPO");
+		} else {
+			disk_dev_read_bypass_cache(&disk->dev, false);
+			INFO("Disk failed a read with FUA and DPO, reads may be served from the cache");
+		}
+	} else {
+		INFO("Disk doesn't support FUA, reads may be served from the cache");
+	}
+
+	return 0;
+}
+
+void cache_restore(disk_t *disk)
+{
+	cache_control_t *c = &disk->cache;
+	int ret;
+
+	if (!c->restore_read_ahead)
+		return;
+
+	if (disk->is_ata)
+		ret = disk_ata_set_features(&disk->dev, ATA_SET_FEATURES_READ_LOOK_AHEAD_ENABLE, 0);
+	else
+		ret = disk_mode_page_write(&disk->dev, c->orig_mode_page, c->orig_mode_page_len);
+
+	if (ret)
+		ERROR("Failed to re-enable the read look-ahead, it will be enabled again on the next power cycle");
+	else
+		VERBOSE("Read look-ahead enabled again");
+	c->restore_read_ahead = false;
+}
@@ -0,0 +1,119 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* CRC32C with the SSE4.2 crc32 instruction when the CPU has it and a
+ * slicing-by-8 table implementation otherwise. The hardware version is built
+ * with a target attribute so the rest of the program doesn't require SSE4.2.
+ */
+
+#include "crc32c.h"
+
+#include <string.h>
+
+#define CRC32C_POLY 0x82F63B78 /* Reversed Castagnoli polynomial */
+
+static uint32_t crc32c_table[8][256];
+static uint32_t (*crc32c_impl)(uint32_t crc, const unsigned char *buf, size_t len);
+
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *buf, size_t len)
+{
+	while (len && ((uintptr_t)buf & 7)) {
+		crc = crc32c_table[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+		len--;
+	}
+
+	while (len >= 8) {
+		uint64_t word;
+		memcpy(&word, buf, sizeof(word));
+		word ^= crc;
+		crc = crc32c_table[7][word & 0xFF] ^
+		      crc32c_table[6][(word >> 8) & 0xFF] ^
+		      crc32c_table[5][(word >> 16) & 0xFF] ^
+		      crc32c_table[4][(word >> 24) & 0xFF] ^
+		      crc32c_table[3][(word >> 32) & 0xFF] ^
+		      crc32c_table[2][(word >> 40) & 0xFF] ^
+		      crc32c_table[1][(word >> 48) & 0xFF] ^
+		      crc32c_table[0][word >> 56];
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len--)
+		crc = crc32c_table[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const unsigned char *buf, size_t len)
+{
+	uint64_t crc64 = crc;
+
+	while (len && ((uintptr_t)buf & 7)) {
+		crc64 = _mm_crc32_u8(crc64, *buf++);
+		len--;
+	}
+
+	while (len >= 8) {
+		uint64_t word;
+		memcpy(&word, buf, sizeof(word));
+		crc64 = _mm_crc32_u64(crc64, word);
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len--)
+		crc64 = _mm_crc32_u8(crc64, *buf++);
+
+	return crc64;
+}
+#endif
+
+void crc32c_init(void)
+{
+	unsigned i, j;
+
+	for (i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (crc & 1 ? CRC32C_POLY : 0);
+		crc32c_table[0][i] = crc;
+	}
+
+	for (i = 0; i < 256; i++) {
+		for (j = 1; j < 8; j++)
+			crc32c_table[j][i] = crc32c_table[0][crc32c_table[j-1][i] & 0xFF] ^ (crc32c_table[j-1][i] >> 8);
+	}
+
+	crc32c_impl = crc32c_sw;
+#if defined(__x86_64__) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.2"))
+		crc32c_impl = crc32c_hw;
+#endif
+}
+
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len)
+{
+	return ~crc32c_impl(~crc, buf, len);
+}
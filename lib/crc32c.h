@@ -0,0 +1,33 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_CRC32C_H
+#define DISKSCAN_CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Must be called once before crc32c is used, picks the hardware implementation when the CPU has one */
+void crc32c_init(void);
+
+/* Standard CRC32C (Castagnoli), pass 0 to start a new checksum or a previous result to continue it */
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len);
+
+#endif
@@ -22,6 +22,7 @@
 #include "data.h"
 #include "compiler.h"
 #include "system_id.h"
+#include "verbose.h"
 
 #include "hdrhistogram/src/hdr_histogram_log.h"
 
@@ -97,14 +98,17 @@ static void system_id_output(FILE *f)
 	}
 }
 
-static const char *sense_info_to_json(struct sense_info_t *info, unsigned char *sense, unsigned sense_len)
+// Fits the fixed fields and the hex of the largest sense buffer
+#define SENSE_JSON_LEN 1024
+
+static const char *sense_info_to_json(io_result_t *io_res, char *buf, unsigned buf_len)
 {
-	static char buf[2048];
-	unsigned char sense_hex[sizeof(sense) * 2 + 1];
+	const struct sense_info_t *info = &io_res->info;
+	unsigned char sense_hex[sizeof(io_res->sense) * 2 + 1];
 
-	buf_to_hex(sense, sense_len, sense_hex, sizeof(sense_hex));
+	buf_to_hex(io_res->sense, io_res->sense_len, sense_hex, sizeof(sense_hex));
 
-	snprintf(buf, 2048, "{\"SenseKey\": %u, \"Asc\": %u, \"Ascq\": %u, \"FruCode\": %u, \"VendorCode\": %u, \"Hex\": \"%s\"}",
+	snprintf(buf, buf_len, "{\"SenseKey\": %u, \"Asc\": %u, \"Ascq\": %u, \"FruCode\": %u, \"VendorCode\": %u, \"Hex\": \"%s\"}",
 			info->sense_key, info->asc, info->ascq,
 			info->fru_code_valid ? info->fru_code : 0,
 			info->vendor_unique_error,
@@ -132,6 +136,8 @@ static void disk_output(FILE *f, disk_t *disk, int indent)
 	add_indent(f, indent); fprintf(f, "\"Serial\": \"%s\",\n", disk->serial);
 	add_indent(f, indent); fprintf(f, "\"NumSectors\": %"PRIu64",\n", disk->num_bytes / disk->sector_size);
 	add_indent(f, indent); fprintf(f, "\"SectorSize\": %"PRIu64",\n", disk->sector_size);
+	add_indent(f, indent); fprintf(f, "\"PhysicalSectorSize\": %"PRIu64",\n", disk->phys_sector_size);
+	add_indent(f, indent); fprintf(f, "\"LowestAlignedLba\": %"PRIu64",\n", disk->phys_align_offset / disk->sector_size);
 	if (disk->is_ata && disk->ata_buf_len > 0) {
 		unsigned char ata_hex[512*2+1];
 		buf_to_hex(disk->ata_buf, disk->ata_buf_len, ata_hex, sizeof(ata_hex));
@@ -142,10 +148,12 @@ static void disk_output(FILE *f, disk_t *disk, int indent)
 
 static void data_log_event(FILE *f, int indent, uint64_t lba, uint32_t len, io_result_t *io_res, uint32_t t_nsec)
 {
+	char sense_json[SENSE_JSON_LEN];
+
 	add_indent(f, indent); fprintf(f, "{\"LBA\": %16"PRIu64", \"Len\": %8u, \"LatencyNSec\": %8u, ", lba, len, t_nsec);
 	fprintf(f, "\"Data\": \"%s\", ", result_data_to_name(io_res->data));
 	fprintf(f, "\"Error\": \"%s\", ", result_error_to_name(io_res->error));
-	fprintf(f, "\"Sense\": %s", sense_info_to_json(&io_res->info, io_res->sense, io_res->sense_len));
+	fprintf(f, "\"Sense\": %s", sense_info_to_json(io_res, sense_json, sizeof(sense_json)));
 	fprintf(f, "}");
 }
 
@@ -226,23 +234,31 @@ void data_log_start(data_log_t *log, const char *filename, disk_t *disk)
 	add_indent(log->f, 2); fprintf(log->f, "\"Events\": [\n");
 }
 
-static void histogram_output(FILE *f, struct hdr_histogram *histogram, int indent)
+static void histogram_output(FILE *f, struct hdr_log_encoder *encoder, const char *name, struct hdr_histogram *histogram, int indent)
 {
-	char *encoded_histogram;
+	const char *encoded_histogram;
+	size_t encoded_len;
 
-	hdr_log_encode(histogram, &encoded_histogram);
+	if (encoder == NULL || hdr_log_encoder_encode(encoder, histogram, &encoded_histogram, &encoded_len) != 0)
+		return;
 
 	add_indent(f, indent);
-	fprintf(f, "\"Histogram\": \"%s\",\n", encoded_histogram);
+	fprintf(f, "\"%s\": \"%s\",\n", name, encoded_histogram);
+}
 
-	free(encoded_histogram);
+static void latency_percentiles_output(FILE *f, const latency_percentiles_t *lp, int indent)
+{
+	unsigned i;
+
+	add_indent(f, indent); fprintf(f, "\"LatencyPercentilesUsec\": {");
+	for (i = 0; i < lp->len; i++)
+		fprintf(f, "%s\"%g\": %"PRId64, i ? ", " : "", lp->percentile[i], lp->value_usec[i]);
+	fprintf(f, "},\n");
 }
 
-static void latency_output(FILE *f, latency_t *latency, int latency_len, int indent)
+static void latency_output(FILE *f, const char *name, latency_t *latency, int latency_len, int indent)
 {
-	//unsigned latency_graph_len;
-	//latency_t *latency_graph;
-	add_indent(f, indent); fprintf(f, "\"Latencies\": [\n");
+	add_indent(f, indent); fprintf(f, "\"%s\": [\n", name);
 
 	int i;
 	for (i = 0; i < latency_len; i++) {
@@ -255,6 +271,12 @@ static void latency_output(FILE *f, latency_t *latency, int latency_len, int ind
 		fprintf(f, ", \"LatencyMinMsec\": %8u", latency[i].latency_min_msec);
 		fprintf(f, ", \"LatencyMaxMsec\": %8u", latency[i].latency_max_msec);
 		fprintf(f, ", \"LatencyMedianMsec\": %8u", latency[i].latency_median_msec);
+		fprintf(f, ", \"Bytes\": %12"PRIu64, latency[i].bytes);
+		fprintf(f, ", \"IoNsec\": %14"PRIu64, latency[i].io_nsec);
+		fprintf(f, ", \"ThroughputMBps\": %8.2f", latency[i].throughput_mbps);
+		fprintf(f, ", \"ZoneRateMBps\": %8.2f", latency[i].model_mbps);
+		fprintf(f, ", \"ThroughputDip\": %s", latency[i].throughput_dip ? "true" : "false");
+		fprintf(f, ", \"GrownDefects\": %4u", latency[i].grown_defects);
 		fprintf(f, "}");
 	}
 	fprintf(f, "\n");
@@ -262,11 +284,156 @@ static void latency_output(FILE *f, latency_t *latency, int latency_len, int ind
 	add_indent(f, indent); fprintf(f, "],\n");
 }
 
+static void burn_in_output(FILE *f, burn_in_t *burn_in, int indent)
+{
+	char pattern_str[64];
+	unsigned i;
+
+	add_indent(f, indent); fprintf(f, "\"BurnIn\": {\"Patterns\": [");
+	for (i = 0; i < burn_in->num_patterns; i++)
+		fprintf(f, "%s\"%s\"", i ? ", " : "", pattern_to_str(&burn_in->patterns[i], pattern_str, sizeof(pattern_str)));
+	fprintf(f, "], \"MiscompareSectors\": %"PRIu64"},\n", burn_in->miscompare_sectors);
+}
+
+static void grown_defects_output(FILE *f, grown_defects_t *glist, int indent)
+{
+	unsigned i;
+
+	add_indent(f, indent); fprintf(f, "\"GrownDefectsAtStart\": %u,\n", glist->start_len);
+	add_indent(f, indent); fprintf(f, "\"GrownDefects\": [");
+	for (i = 0; i < glist->new_len; i++) {
+		if (i != 0)
+			fprintf(f, ",");
+		fprintf(f, "\n");
+		add_indent(f, indent+1);
+		fprintf(f, "{\"Lba\": %"PRIu64", \"LatencyBucket\": %d}", glist->new_defects[i].lba, glist->new_defects[i].latency_bucket);
+	}
+	if (glist->new_len > 0) {
+		fprintf(f, "\n");
+		add_indent(f, indent);
+	}
+	fprintf(f, "],\n");
+}
+
+static void bad_areas_output(FILE *f, bad_areas_t *bad_areas, int indent)
+{
+	unsigned i;
+
+	add_indent(f, indent); fprintf(f, "\"BadAreas\": [");
+	for (i = 0; i < bad_areas->len; i++) {
+		const bad_area_t *area = &bad_areas->areas[i];
+
+		if (i != 0)
+			fprintf(f, ",");
+		fprintf(f, "\n");
+		add_indent(f, indent+1);
+		fprintf(f, "{\"StartLba\": %"PRIu64", \"EndLba\": %"PRIu64", \"UnreadStartLba\": %"PRIu64", \"UnreadEndLba\": %"PRIu64"}",
+				area->start_sector, area->end_sector, area->unread_start_sector, area->unread_end_sector);
+	}
+	if (bad_areas->len > 0) {
+		fprintf(f, "\n");
+		add_indent(f, indent);
+	}
+	fprintf(f, "],\n");
+}
+
+static void fingerprint_output(FILE *f, fingerprint_report_t *report, int indent)
+{
+	unsigned i;
+
+	add_indent(f, indent); fprintf(f, "\"Fingerprint\": {");
+	fprintf(f, "\"ChunkSize\": %u, \"Compared\": %s", report->chunk_size, report->compared ? "true" : "false");
+	if (report->compared) {
+		fprintf(f, ", \"PreviousScanTime\": %"PRId64, report->previous_scan_time);
+		fprintf(f, ", \"NumCompared\": %"PRIu64", \"NumChanged\": %"PRIu64, report->num_compared, report->num_changed);
+		fprintf(f, ", \"ChangedOffsets\": [");
+		for (i = 0; i < report->changed_offsets_len; i++)
+			fprintf(f, "%s%"PRIu64, i ? ", " : "", report->changed_offsets[i]);
+		fprintf(f, "]");
+	}
+	fprintf(f, "},\n");
+}
+
+static void policy_output(FILE *f, verdict_policy_t *policy, int indent)
+{
+	add_indent(f, indent); fprintf(f, "\"Policy\": {");
+	fprintf(f, "\"MaxLatencyMsec\": %u", policy->max_latency_msec);
+	fprintf(f, ", \"LatencyPercentile\": %g", policy->latency_percentile);
+	fprintf(f, ", \"PercentileLatencyMsec\": %u", policy->percentile_latency_msec);
+	fprintf(f, ", \"MaxIoErrors\": %"PRIu64, policy->max_io_errors);
+	fprintf(f, ", \"MaxMiscompareSectors\": %"PRIu64, policy->max_miscompare_sectors);
+	fprintf(f, "},\n");
+}
+
+static void error_recovery_output(FILE *f, error_recovery_t *recovery, int indent)
+{
+	add_indent(f, indent); fprintf(f, "\"ErrorRecoveryLimit\": {");
+	fprintf(f, "\"ReadMsec\": %u, \"WriteMsec\": %u", recovery->read_msec, recovery->write_msec);
+	fprintf(f, ", \"OriginalReadMsec\": %u, \"OriginalWriteMsec\": %u", recovery->orig_read_msec, recovery->orig_write_msec);
+	fprintf(f, "},\n");
+}
+
+static void cache_output(FILE *f, cache_control_t *cache, int indent)
+{
+	add_indent(f, indent); fprintf(f, "\"Cache\": {");
+	fprintf(f, "\"ReadCache\": %s", cache->read_cache ? "true" : "false");
+	fprintf(f, ", \"WriteCache\": %s", cache->write_cache ? "true" : "false");
+	fprintf(f, ", \"ReadAhead\": %s", cache->read_ahead ? "true" : "false");
+	fprintf(f, ", \"FuaSupported\": %s", cache->fua_supported ? "true" : "false");
+	fprintf(f, ", \"FuaDpo\": %s", cache->fua_dpo ? "true" : "false");
+	fprintf(f, "},\n");
+}
+
+static void zones_output(FILE *f, zones_t *zones, int indent)
+{
+	add_indent(f, indent); fprintf(f, "\"Zones\": {");
+	fprintf(f, "\"Count\": %u, \"ZoneSectors\": %"PRIu64", \"ReadableSectors\": %"PRIu64,
+			zones->len, zones->zone_sectors, zones->readable_sectors);
+	fprintf(f, ", \"SeqWriteRequired\": %u, \"Empty\": %u, \"Offline\": %u", zones->num_seq_required, zones->num_empty, zones->num_offline);
+	fprintf(f, "},\n");
+}
+
+static void provisioning_output(FILE *f, provisioning_t *provisioning, uint64_t num_sectors, int indent)
+{
+	add_indent(f, indent); fprintf(f, "\"Provisioning\": {");
+	fprintf(f, "\"MappedSectors\": %"PRIu64", \"UnmappedSectors\": %"PRIu64", \"MappedExtents\": %u",
+			provisioning->mapped_sectors, num_sectors - provisioning->mapped_sectors, provisioning->len);
+	fprintf(f, ", \"SamplePercent\": %u, \"SkippedReads\": %"PRIu64", \"SampledReads\": %"PRIu64,
+			provisioning->sample_percent, provisioning->skipped_reads, provisioning->sampled_reads);
+	fprintf(f, "},\n");
+}
+
+static void profile_output(FILE *f, scan_profile_t *profile, int indent)
+{
+	add_indent(f, indent); fprintf(f, "\"Profile\": {");
+	fprintf(f, "\"TotalNsec\": %"PRIu64, profile->total_nsec);
+	fprintf(f, ", \"DeviceNsec\": %"PRIu64, profile->device_nsec);
+	fprintf(f, ", \"IoOverheadNsec\": %"PRIu64, profile->io_overhead_nsec);
+	fprintf(f, ", \"IoUntimedNsec\": %"PRIu64, profile->io_untimed_nsec);
+	fprintf(f, ", \"LoggingNsec\": %"PRIu64, profile->logging_nsec);
+	fprintf(f, ", \"MonitorNsec\": %"PRIu64, profile->monitor_nsec);
+	fprintf(f, ", \"ProgressNsec\": %"PRIu64, profile->progress_nsec);
+	fprintf(f, ", \"ThrottleNsec\": %"PRIu64, profile->throttle_nsec);
+	fprintf(f, ", \"RetryWaitNsec\": %"PRIu64, profile->retry_wait_nsec);
+	fprintf(f, ", \"OtherNsec\": %"PRIu64, profile->other_nsec);
+	fprintf(f, "},\n");
+}
+
 void data_log_end(data_log_t *log, disk_t *disk)
 {
+	struct hdr_log_encoder encoder_buf;
+	struct hdr_log_encoder *encoder = &encoder_buf;
+
 	if (log == NULL || log->f == NULL)
 		return;
 
+	// All the histograms are encoded through the same buffers and compression stream,
+	// without it the histograms are left out and the rest of the log is still complete
+	if (hdr_log_encoder_init(encoder, -1) != 0) {
+		ERROR("Failed to initialize the histogram encoder, histograms are not logged");
+		encoder = NULL;
+	}
+
 	fprintf(log->f, "\n");
 	add_indent(log->f, 2); fprintf(log->f, "],\n");
 	// TODO: Output SMART Information
@@ -274,12 +441,53 @@ void data_log_end(data_log_t *log, disk_t *disk)
 
 	add_indent(log->f, 2); time_output(log->f, "EndTime"); fprintf(log->f, ",\n");
 
-	histogram_output(log->f, disk->histogram, 2);
-	latency_output(log->f, disk->latency_graph, disk->latency_graph_len, 2);
+	histogram_output(log->f, encoder, "Histogram", disk->histogram, 2);
+	latency_percentiles_output(log->f, &disk->latency_percentiles, 2);
+	if (disk->device_histogram->total_count > 0) {
+		// The device reports whole msecs, a read faster than that is recorded as 0
+		histogram_output(log->f, encoder, "DeviceHistogram", disk->device_histogram, 2);
+		add_indent(log->f, 2); fprintf(log->f, "\"DeviceHistogramResolutionUsec\": 1000,\n");
+	}
+	if (disk->jitter_histogram->total_count > 0)
+		histogram_output(log->f, encoder, "HostJitterHistogram", disk->jitter_histogram, 2);
+	latency_output(log->f, "Latencies", disk->latency_graph, disk->latency_graph_len, 2);
+	if (disk->retry_histogram->total_count > 0)
+		histogram_output(log->f, encoder, "RetryHistogram", disk->retry_histogram, 2);
+	add_indent(log->f, 2);
+	fprintf(log->f, "\"Retries\": {\"Retries\": %"PRIu64", \"Recovered\": %"PRIu64", \"Bisected\": %"PRIu64", \"BadSectors\": %"PRIu64", \"BadPhysicalSectors\": %"PRIu64", \"Corrected\": %"PRIu64"},\n",
+			disk->retry.retries, disk->retry.recovered, disk->retry.bisected, disk->retry.bad_sectors, disk->retry.bad_phys_sectors,
+			disk->retry.corrected);
+	if (disk->burn_in.num_patterns) {
+		histogram_output(log->f, encoder, "WriteHistogram", disk->write_histogram, 2);
+		latency_output(log->f, "WriteLatencies", disk->write_latency_graph, disk->latency_graph_len, 2);
+		burn_in_output(log->f, &disk->burn_in, 2);
+	}
+	add_indent(log->f, 2); fprintf(log->f, "\"ThroughputDips\": %u,\n", disk->num_throughput_dips);
+	if (disk->glist.valid)
+		grown_defects_output(log->f, &disk->glist, 2);
+	if (disk->bad_areas.skip)
+		bad_areas_output(log->f, &disk->bad_areas, 2);
+	if (disk->zones.zoned)
+		zones_output(log->f, &disk->zones, 2);
+	add_indent(log->f, 2); fprintf(log->f, "\"ThinProvisioned\": %s,\n", disk->thin_provisioned ? "true" : "false");
+	if (disk->provisioning.valid)
+		provisioning_output(log->f, &disk->provisioning, disk->num_bytes / disk->sector_size, 2);
+	if (disk->fingerprint_report.valid)
+		fingerprint_output(log->f, &disk->fingerprint_report, 2);
+	if (disk->recovery.active)
+		error_recovery_output(log->f, &disk->recovery, 2);
+	if (disk->cache.valid)
+		cache_output(log->f, &disk->cache, 2);
+	profile_output(log->f, &disk->profile, 2);
+	policy_output(log->f, &disk->policy, 2);
+	add_indent(log->f, 2); fprintf(log->f, "\"StoppedEarly\": %s,\n", disk->stopped_early ? "true" : "false");
 	add_indent(log->f, 2); fprintf(log->f, "\"Conclusion\": \"%s\"\n", conclusion_to_str(disk->conclusion));
 
 	add_indent(log->f, 1); fprintf(log->f, "}\n");
 	fprintf(log->f, "}\n");
+
+	if (encoder)
+		hdr_log_encoder_destroy(encoder);
 }
 
 void data_log(data_log_t *log, uint64_t lba, uint32_t len, io_result_t *io_res, uint32_t t_nsec)
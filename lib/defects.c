@@ -0,0 +1,139 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Grown defect list tracking.
+ *
+ * The disk adds an entry to its grown defect list whenever it remaps a
+ * sector, so diffing the list from before and after the scan tells exactly
+ * which LBAs the disk gave up on while we were reading it. This catches disks
+ * that remap quietly without ever returning an error to the host.
+ */
+
+#include "defects.h"
+#include "disk.h"
+#include "verbose.h"
+
+#include <stdlib.h>
+#include <inttypes.h>
+
+void grown_defects_start(disk_t *disk)
+{
+	grown_defects_t *g = &disk->glist;
+	int num;
+
+	num = disk_grown_defect_list(&disk->dev, &g->start_lbas);
+	if (num < 0) {
+		VERBOSE("Grown defect list is not available in an LBA format, not tracking new defects");
+		return;
+	}
+
+	g->start_len = num;
+	g->valid = true;
+}
+
+/* Both lists are sorted so a single merge pass finds the LBAs that are only in the current list */
+static unsigned grown_defects_diff(const uint64_t *start, unsigned start_len, const uint64_t *cur, unsigned cur_len, grown_defect_t *new_defects)
+{
+	unsigned i = 0, j = 0, n = 0;
+
+	for (j = 0; j < cur_len; j++) {
+		while (i < start_len && start[i] < cur[j])
+			i++;
+		if (i < start_len && start[i] == cur[j])
+			continue;
+		if (n > 0 && new_defects[n-1].lba == cur[j])
+			continue;
+		new_defects[n].lba = cur[j];
+		new_defects[n].latency_bucket = -1;
+		n++;
+	}
+
+	return n;
+}
+
+void grown_defects_update(disk_t *disk)
+{
+	grown_defects_t *g = &disk->glist;
+	uint64_t *cur_lbas;
+	int num;
+
+	if (!g->valid)
+		return;
+
+	num = disk_grown_defect_list(&disk->dev, &cur_lbas);
+	if (num < 0) {
+		ERROR("Failed to read the grown defect list");
+		return;
+	}
+
+	grown_defect_t *new_defects = malloc(sizeof(grown_defect_t) * (num ? num : 1));
+	if (new_defects == NULL) {
+		free(cur_lbas);
+		return;
+	}
+
+	unsigned new_len = grown_defects_diff(g->start_lbas, g->start_len, cur_lbas, num, new_defects);
+	free(cur_lbas);
+
+	// Report only the defects that weren't seen on the previous update
+	unsigned i, j = 0;
+	for (i = 0; i < new_len; i++) {
+		while (j < g->new_len && g->new_defects[j].lba < new_defects[i].lba)
+			j++;
+		if (j < g->new_len && g->new_defects[j].lba == new_defects[i].lba)
+			continue;
+		INFO("New grown defect at LBA %"PRIu64, new_defects[i].lba);
+	}
+
+	free(g->new_defects);
+	g->new_defects = new_defects;
+	g->new_len = new_len;
+}
+
+void grown_defects_finish(disk_t *disk, uint64_t latency_stride)
+{
+	grown_defects_t *g = &disk->glist;
+	unsigned i;
+
+	if (!g->valid)
+		return;
+
+	grown_defects_update(disk);
+
+	for (i = 0; i < g->new_len; i++) {
+		const uint64_t bucket = g->new_defects[i].lba / latency_stride;
+
+		if (bucket < disk->latency_graph_len) {
+			g->new_defects[i].latency_bucket = bucket;
+			disk->latency_graph[bucket].grown_defects++;
+		}
+	}
+
+	if (g->new_len > 0)
+		INFO("%u new grown defects were added during the scan", g->new_len);
+}
+
+void grown_defects_free(disk_t *disk)
+{
+	free(disk->glist.start_lbas);
+	free(disk->glist.new_defects);
+	disk->glist.start_lbas = NULL;
+	disk->glist.new_defects = NULL;
+}
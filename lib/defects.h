@@ -0,0 +1,31 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_DEFECTS_H
+#define DISKSCAN_DEFECTS_H
+
+#include "diskscan.h"
+
+void grown_defects_start(disk_t *disk);
+void grown_defects_update(disk_t *disk);
+void grown_defects_finish(disk_t *disk, uint64_t latency_stride);
+void grown_defects_free(disk_t *disk);
+
+#endif
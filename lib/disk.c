@@ -1,6 +1,14 @@
 #include "disk.h"
 
 #include "libscsicmd/include/ata.h"
+#include "libscsicmd/include/parse_log_sense.h"
+#include "libscsicmd/include/parse_mode_sense.h"
+#include "libscsicmd/include/parse_read_defect_data.h"
+#include "libscsicmd/include/parse_report_zones.h"
+#include "libscsicmd/include/parse_get_lba_status.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 int disk_smart_trip(disk_dev_t *dev)
 {
@@ -40,3 +48,326 @@ int disk_smart_attributes(disk_dev_t *dev, ata_smart_attr_t *attrs, int max_attr
 
 	return ata_parse_ata_smart_read_data(buf, attrs, max_attrs);
 }
+
+int disk_ata_sct_erc_get(disk_dev_t *dev, ata_sct_erc_e selection, uint16_t *time_limit)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char buf[512];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	cdb_len = cdb_ata_sct_erc(cdb, buf, false, selection, 0);
+	disk_dev_cdb_out(dev, cdb, cdb_len, buf, sizeof(buf), &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (!ata_sct_erc_get_result(sense, sense_read, time_limit))
+		return -1;
+
+	return 0;
+}
+
+int disk_ata_sct_erc_set(disk_dev_t *dev, ata_sct_erc_e selection, uint16_t time_limit)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char buf[512];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	cdb_len = cdb_ata_sct_erc(cdb, buf, true, selection, time_limit);
+	disk_dev_cdb_out(dev, cdb, cdb_len, buf, sizeof(buf), &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED)
+		return -1;
+
+	return 0;
+}
+
+int disk_ata_set_features(disk_dev_t *dev, uint8_t feature, uint8_t sector_count)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	cdb_len = cdb_ata_set_features(cdb, feature, sector_count);
+	disk_dev_cdb_out(dev, cdb, cdb_len, NULL, 0, &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED)
+		return -1;
+
+	return 0;
+}
+
+int disk_log_sense(disk_dev_t *dev, uint8_t page, uint8_t subpage, unsigned char *buf, unsigned buf_size)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	if (buf_size > 0xFFFF)
+		buf_size = 0xFFFF;
+
+	cdb_len = cdb_log_sense(cdb, page, subpage, buf_size);
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, buf_size, &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (io_res.data == DATA_NONE || (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED))
+		return -1;
+	if (buf_read < LOG_SENSE_MIN_LEN)
+		return -1;
+
+	// The device may return less than the page claims, and the parser refuses data beyond the page
+	unsigned page_len = LOG_SENSE_MIN_LEN + log_sense_data_len(buf);
+	if (page_len > buf_read)
+		page_len = buf_read;
+
+	if (log_sense_page_code(buf) != page || !log_sense_is_valid(buf, page_len))
+		return -1;
+
+	return page_len;
+}
+
+int disk_mode_page_read(disk_dev_t *dev, uint8_t page, page_control_e page_control, unsigned char *buf, unsigned buf_size, uint8_t *device_specific_param)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char data[512];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+	uint8_t *mode_page;
+	int remaining_len;
+
+	cdb_len = cdb_mode_sense_10(cdb, false, true, page_control, page, 0, sizeof(data));
+	disk_dev_cdb_in(dev, cdb, cdb_len, data, sizeof(data), &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (io_res.data == DATA_NONE || (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED))
+		return -1;
+	if (buf_read < MODE_SENSE_10_MIN_LEN || !mode_sense_10_is_valid_header(data, buf_read))
+		return -1;
+	if (device_specific_param)
+		*device_specific_param = mode_sense_10_device_specific_param(data);
+
+	for_all_mode_sense_10_pages(data, buf_read, mode_page, remaining_len) {
+		if (mode_sense_data_page_code(mode_page) != page || mode_sense_data_subpage_format(mode_page))
+			continue;
+
+		unsigned page_len = mode_sense_data_page_len(mode_page);
+		if (page_len > buf_size)
+			return -1;
+		memcpy(buf, mode_page, page_len);
+		return page_len;
+	}
+
+	return -1;
+}
+
+int disk_mode_page_write(disk_dev_t *dev, const unsigned char *page, unsigned page_len)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char data[512];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	if (page_len + MODE_SENSE_10_MIN_LEN > sizeof(data))
+		return -1;
+
+	// The header is all reserved fields on a select, no block descriptor is sent
+	memset(data, 0, MODE_SENSE_10_MIN_LEN);
+	memcpy(data + MODE_SENSE_10_MIN_LEN, page, page_len);
+	data[MODE_SENSE_10_MIN_LEN] &= 0x7F; // The PS bit is reserved on a select
+
+	cdb_len = cdb_mode_select_10(cdb, true, false, MODE_SENSE_10_MIN_LEN + page_len);
+	disk_dev_cdb_out(dev, cdb, cdb_len, data, MODE_SENSE_10_MIN_LEN + page_len, &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED)
+		return -1;
+
+	return 0;
+}
+
+int disk_read_capacity_16(disk_dev_t *dev, disk_capacity_t *cap)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char buf[32];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	cdb_len = cdb_read_capacity_16(cdb, sizeof(buf));
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, sizeof(buf), &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (io_res.data == DATA_NONE || (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED))
+		return -1;
+
+	if (!parse_read_capacity_16(buf, buf_read, &cap->max_lba, &cap->block_size, NULL, NULL, NULL,
+				&cap->logical_blocks_per_physical_block_exponent, &cap->thin_provisioning_enabled,
+				&cap->thin_provisioning_zero, &cap->lowest_aligned_lba))
+		return -1;
+
+	return 0;
+}
+
+int disk_get_lba_status(disk_dev_t *dev, uint64_t start_lba, unsigned char *buf, unsigned buf_size)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	cdb_len = cdb_get_lba_status(cdb, start_lba, buf_size);
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, buf_size, &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (io_res.data == DATA_NONE || (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED))
+		return -1;
+	if (!get_lba_status_is_valid(buf, buf_read))
+		return -1;
+
+	return buf_read;
+}
+
+int disk_report_zones(disk_dev_t *dev, uint64_t start_lba, unsigned char *buf, unsigned buf_size)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	cdb_len = cdb_report_zones(cdb, start_lba, buf_size, REPORT_ZONES_ALL, true);
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, buf_size, &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if (io_res.data == DATA_NONE || (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED))
+		return -1;
+	if (!report_zones_is_valid(buf, buf_read))
+		return -1;
+
+	return buf_read;
+}
+
+/* Read the grown defect list into buf, READ DEFECT DATA 12 is preferred as it can report long lists */
+static int disk_read_glist(disk_dev_t *dev, unsigned char *buf, unsigned buf_size, uint8_t *fmt, uint32_t *list_len, unsigned *hdr_len)
+{
+	int cdb_len;
+	unsigned char cdb[32];
+	unsigned char sense[128];
+	unsigned buf_read = 0;
+	unsigned sense_read = 0;
+	io_result_t io_res;
+
+	cdb_len = cdb_read_defect_data_12(cdb, false, true, ADDRESS_FORMAT_LONG, buf_size);
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, buf_size, &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if ((io_res.error == ERROR_NONE || io_res.error == ERROR_CORRECTED) &&
+	    read_defect_data_12_hdr_is_valid(buf, buf_read) && read_defect_data_12_is_glist_valid(buf))
+	{
+		*fmt = read_defect_data_12_list_format(buf);
+		*list_len = read_defect_data_12_len(buf);
+		*hdr_len = READ_DEFECT_DATA_12_MIN_LEN;
+		return buf_read;
+	}
+
+	if (buf_size > 0xFFFF)
+		buf_size = 0xFFFF;
+
+	buf_read = sense_read = 0;
+	cdb_len = cdb_read_defect_data_10(cdb, false, true, ADDRESS_FORMAT_LONG, buf_size);
+	disk_dev_cdb_in(dev, cdb, cdb_len, buf, buf_size, &buf_read, sense, sizeof(sense), &sense_read, &io_res);
+	if ((io_res.error == ERROR_NONE || io_res.error == ERROR_CORRECTED) &&
+	    read_defect_data_10_hdr_is_valid(buf, buf_read) && read_defect_data_10_is_glist_valid(buf))
+	{
+		*fmt = read_defect_data_10_list_format(buf);
+		*list_len = read_defect_data_10_len(buf);
+		*hdr_len = READ_DEFECT_DATA_10_MIN_LEN;
+		return buf_read;
+	}
+
+	return -1;
+}
+
+int disk_grown_defects_count(disk_dev_t *dev)
+{
+	unsigned char buf[READ_DEFECT_DATA_12_MIN_LEN];
+	uint8_t fmt;
+	uint32_t list_len;
+	unsigned hdr_len;
+
+	if (disk_read_glist(dev, buf, sizeof(buf), &fmt, &list_len, &hdr_len) < 0)
+		return -1;
+
+	unsigned fmt_len = read_defect_data_fmt_len(fmt);
+	if (fmt_len == 0)
+		return -1;
+	return list_len / fmt_len;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	const uint64_t va = *(const uint64_t *)a;
+	const uint64_t vb = *(const uint64_t *)b;
+
+	if (va < vb)
+		return -1;
+	return va > vb;
+}
+
+int disk_grown_defect_list(disk_dev_t *dev, uint64_t **plbas)
+{
+	unsigned char hdr[READ_DEFECT_DATA_12_MIN_LEN];
+	unsigned char *buf;
+	uint8_t fmt;
+	uint32_t list_len;
+	unsigned hdr_len;
+	int buf_read;
+
+	*plbas = NULL;
+
+	if (disk_read_glist(dev, hdr, sizeof(hdr), &fmt, &list_len, &hdr_len) < 0)
+		return -1;
+	// Only address formats that carry an LBA can be mapped back onto the scan
+	if (fmt != ADDRESS_FORMAT_LONG && fmt != ADDRESS_FORMAT_SHORT)
+		return -1;
+	if (list_len == 0)
+		return 0;
+
+	buf = malloc(READ_DEFECT_DATA_12_MIN_LEN + list_len);
+	if (buf == NULL)
+		return -1;
+
+	buf_read = disk_read_glist(dev, buf, READ_DEFECT_DATA_12_MIN_LEN + list_len, &fmt, &list_len, &hdr_len);
+	if (buf_read < 0 || (fmt != ADDRESS_FORMAT_LONG && fmt != ADDRESS_FORMAT_SHORT)) {
+		free(buf);
+		return -1;
+	}
+
+	// The list may have grown or been truncated between the two reads, use what we actually got
+	if (list_len > (unsigned)buf_read - hdr_len)
+		list_len = buf_read - hdr_len;
+
+	const unsigned fmt_len = read_defect_data_fmt_len(fmt);
+	const unsigned num_defects = list_len / fmt_len;
+	uint64_t *lbas = malloc(sizeof(uint64_t) * (num_defects ? num_defects : 1));
+	if (lbas == NULL) {
+		free(buf);
+		return -1;
+	}
+
+	unsigned i;
+	for (i = 0; i < num_defects; i++) {
+		uint8_t *desc = buf + hdr_len + i * fmt_len;
+		lbas[i] = fmt == ADDRESS_FORMAT_LONG ? format_address_long_lba(desc) : format_address_short_lba(desc);
+	}
+	free(buf);
+
+	qsort(lbas, num_defects, sizeof(uint64_t), cmp_u64);
+	*plbas = lbas;
+	return num_defects;
+}
@@ -25,6 +25,18 @@
 #include "median.h"
 #include "compiler.h"
 #include "data.h"
+#include "metrics.h"
+#include "throughput.h"
+#include "defects.h"
+#include "repair.h"
+#include "fingerprint.h"
+#include "retry.h"
+#include "policy.h"
+#include "recovery.h"
+#include "cache.h"
+#include "zones.h"
+#include "provisioning.h"
+#include "pattern.h"
 #include "libscsicmd/include/smartdb.h"
 #include "libscsicmd/include/ata_smart.h"
 
@@ -43,18 +55,55 @@
 
 #define TEMP_THRESHOLD 65
 
+/* Transfer size auto tuning */
+#define SIZE_PROBE_MIN (32*1024)
+#define SIZE_PROBE_DEFAULT_MAX (1024*1024)
+#define SIZE_PROBE_MAX (32*1024*1024)
+#define SIZE_PROBE_BYTES (32*1024*1024)
+#define SIZE_PROBE_NSEC (1000ULL*1000*1000)
+#define SIZE_PROBE_GOOD_ENOUGH_PERCENT 95
+#define SIZE_PROBE_LATENCY_FACTOR 8 /* Max latency allowed over that of the smallest size */
+
+/* Skipping over bad areas, the skip doubles on every failed read until a read succeeds */
+#define BAD_AREA_ERRORS 2           /* Consecutive failed reads that start skipping */
+#define BAD_AREA_SKIP_READS 16      /* First skip in reads */
+#define BAD_AREA_SKIP_MAX_PERMILLE 10
+#define BAD_AREA_BACKFILL_DIV 16    /* Backfill reads are smaller than the scan reads */
+
 struct scan_state {
+	latency_t *latency_graph;
 	uint32_t latency_bucket;
 	uint64_t latency_stride;
 	uint32_t latency_count;
 	uint32_t *latency;
 	void *data;
+	const pattern_t *pattern; /* Burn-in pattern to write or verify, NULL for a plain read scan */
+	bool write;
 	uint64_t progress_bytes;
+	uint64_t progress_total;
 	int progress_part;
 	int progress_full;
 	unsigned num_unknown_errors;
+	unsigned consecutive_errors;
+
+	/* Incremental verdict */
+	uint64_t verdict_reads;          /* Upper bound on the reads of the whole scan, 0 when unknown */
+	uint64_t verdict_over_reads;     /* Reads slower than the percentile latency threshold */
+	uint64_t verdict_over_bound;     /* More reads than this over the threshold fail the percentile */
+
+	/* Skipping over bad areas */
+	uint64_t read_size; /* Full scan transfer size, the last read of a stride may be shorter */
+	bool skip_bad_areas;
+	bool backfill;
+	uint64_t skip_bytes;
+	uint64_t skip_until;
 };
 
+static inline uint64_t ts_diff_nsec(const struct timespec *end, const struct timespec *start)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000000ULL + end->tv_nsec - start->tv_nsec;
+}
+
 typedef int spinner_t;
 
 static char spinner_form[] = {'|', '/', '-', '\\', '|', '/', '-', '\\'};
@@ -84,8 +133,9 @@ const char *conclusion_to_str(enum conclusion conclusion)
 {
 	switch (conclusion) {
 		case CONCLUSION_FAILED_IO_ERRORS: return "failed due to IO errors";
+		case CONCLUSION_FAILED_MISCOMPARE: return "failed due to data miscompare";
 		case CONCLUSION_FAILED_MAX_LATENCY: return "failed due to a high max latency";
-		case CONCLUSION_FAILED_LATENCY_PERCENTILE: return "failed to to a high latency in the 99.99%'ile";
+		case CONCLUSION_FAILED_LATENCY_PERCENTILE: return "failed due to a high latency percentile";
 		case CONCLUSION_PASSED: return "passed";
 		case CONCLUSION_SCAN_PROBLEM: return "scan_problem";
 		case CONCLUSION_ABORTED: return "scan_aborted";
@@ -144,6 +194,47 @@ static void disk_ata_monitor_start(disk_t *disk)
 	}
 }
 
+/* Pause the scan while the disk is too hot, read_temp returns -1 when the temperature can't be read */
+static void disk_temp_throttle(disk_t *disk, int temp, int (*read_temp)(disk_t *disk))
+{
+	spinner_t spinner;
+	struct timespec ts_start;
+	struct timespec ts_end;
+
+	if (temp < TEMP_THRESHOLD)
+		return;
+
+	INFO("Pausing scan due to high disk temperature");
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	spinner_init(&spinner);
+	while (temp >= TEMP_THRESHOLD) {
+		sleep(1);
+		spinner_update(&spinner);
+		temp = read_temp(disk);
+		if (temp < 0) {
+			ERROR("Failed to read temperature while paused!");
+			break;
+		}
+	}
+	spinner_done();
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	disk->profile.throttle_nsec += ts_diff_nsec(&ts_end, &ts_start);
+	INFO("Finished pause, temperature is now %d", temp);
+}
+
+static int ata_read_temp(disk_t *disk)
+{
+	ata_smart_attr_t smart[MAX_SMART_ATTRS];
+	int smart_num;
+	int min_temp = -1;
+	int max_temp = -1;
+
+	smart_num = disk_smart_attributes(&disk->dev, smart, ARRAY_SIZE(smart));
+	if (smart_num <= 0)
+		return -1;
+	return ata_smart_get_temperature(smart, smart_num, disk->state.ata.smart_table, &min_temp, &max_temp);
+}
+
 static void ata_test_temp(disk_t *disk, ata_smart_attr_t *smart, int smart_num)
 {
 	int min_temp = -1;
@@ -155,24 +246,7 @@ static void ata_test_temp(disk_t *disk, ata_smart_attr_t *smart, int smart_num)
 		disk->state.ata.last_temp = temp;
 	}
 
-	if (temp >= TEMP_THRESHOLD) {
-		spinner_t spinner;
-		INFO("Pausing scan due to high disk temperature");
-		spinner_init(&spinner);
-		while (temp >= TEMP_THRESHOLD) {
-			sleep(1);
-			spinner_update(&spinner);
-			smart_num = disk_smart_attributes(&disk->dev, smart, smart_num);
-			if (smart_num > 0) {
-				temp = ata_smart_get_temperature(smart, smart_num, disk->state.ata.smart_table, &min_temp, &max_temp);
-			} else {
-				ERROR("Failed to read temperature while paused!");
-				break;
-			}
-		}
-		spinner_done();
-		INFO("Finished pause, temperature is now %d", temp);
-	}
+	disk_temp_throttle(disk, temp, ata_read_temp);
 }
 
 static void ata_test_reallocs(disk_t *disk, ata_smart_attr_t *smart, int smart_num)
@@ -254,19 +328,244 @@ static void disk_ata_monitor_end(disk_t *disk)
 	}
 }
 
+/* Values read from the disk in a single monitoring poll, one LOG SENSE per supported page */
+struct scsi_poll {
+	int temp;
+	bool ie_valid;
+	uint8_t ie_asc;
+	uint8_t ie_ascq;
+	bool read_errors_valid;
+	log_sense_error_counters_t read_errors;
+	bool verify_errors_valid;
+	log_sense_error_counters_t verify_errors;
+	int grown_defects;
+};
+
+static int scsi_temp_from_page(unsigned char *buf, int buf_len)
+{
+	uint8_t temp;
+	uint8_t ref_temp;
+
+	if (buf_len < 0 || !log_sense_page_temperature(buf, buf_len, &temp, &ref_temp))
+		return -1;
+	if (temp == LOG_SENSE_TEMPERATURE_INVALID)
+		return -1;
+	return temp;
+}
+
+static bool scsi_ie_from_page(unsigned char *buf, int buf_len, uint8_t *asc, uint8_t *ascq, int *temp)
+{
+	uint8_t ie_temp;
+
+	if (buf_len < 0 || !log_sense_page_informational_exceptions(buf, buf_len, asc, ascq, &ie_temp))
+		return false;
+	// The IE page temperature is optional, zero and 0xFF mean it is not reported
+	if (ie_temp != 0 && ie_temp != LOG_SENSE_TEMPERATURE_INVALID)
+		*temp = ie_temp;
+	return true;
+}
+
+static int scsi_read_temp(disk_t *disk)
+{
+	unsigned char buf[512];
+	int temp = -1;
+	uint8_t asc, ascq;
+
+	if (disk->state.scsi.has_temperature_page)
+		return scsi_temp_from_page(buf, disk_log_sense(&disk->dev, LOG_SENSE_PAGE_TEMPERATURE, 0, buf, sizeof(buf)));
+	if (disk->state.scsi.has_ie_page)
+		scsi_ie_from_page(buf, disk_log_sense(&disk->dev, LOG_SENSE_PAGE_INFORMATIONAL_EXCEPTIONS, 0, buf, sizeof(buf)), &asc, &ascq, &temp);
+	return temp;
+}
+
+static void scsi_poll(disk_t *disk, struct scsi_poll *poll)
+{
+	scsi_state_t *state = &disk->state.scsi;
+	unsigned char buf[512];
+	int temp_ie = -1;
+
+	memset(poll, 0, sizeof(*poll));
+	poll->temp = -1;
+	poll->grown_defects = -1;
+
+	if (state->has_temperature_page)
+		poll->temp = scsi_temp_from_page(buf, disk_log_sense(&disk->dev, LOG_SENSE_PAGE_TEMPERATURE, 0, buf, sizeof(buf)));
+
+	if (state->has_ie_page)
+		poll->ie_valid = scsi_ie_from_page(buf, disk_log_sense(&disk->dev, LOG_SENSE_PAGE_INFORMATIONAL_EXCEPTIONS, 0, buf, sizeof(buf)),
+				&poll->ie_asc, &poll->ie_ascq, &temp_ie);
+	if (poll->temp < 0)
+		poll->temp = temp_ie;
+
+	if (state->has_read_errors_page) {
+		int len = disk_log_sense(&disk->dev, LOG_SENSE_PAGE_READ_ERRORS, 0, buf, sizeof(buf));
+		poll->read_errors_valid = len > 0 && log_sense_page_error_counters(buf, len, &poll->read_errors);
+	}
+
+	if (state->has_verify_errors_page) {
+		int len = disk_log_sense(&disk->dev, LOG_SENSE_PAGE_VERIFY_ERRORS, 0, buf, sizeof(buf));
+		poll->verify_errors_valid = len > 0 && log_sense_page_error_counters(buf, len, &poll->verify_errors);
+	}
+
+	if (state->has_grown_defects)
+		poll->grown_defects = disk_grown_defects_count(&disk->dev);
+}
+
+static void scsi_supported_pages(disk_t *disk)
+{
+	scsi_state_t *state = &disk->state.scsi;
+	unsigned char buf[512];
+	int len;
+
+	len = disk_log_sense(&disk->dev, LOG_SENSE_PAGE_SUPPORTED, 0, buf, sizeof(buf));
+	if (len > 0) {
+		uint8_t page;
+		for_all_log_sense_pg_0_supported_pages(buf, len, page) {
+			switch (page & 0x3F) {
+				case LOG_SENSE_PAGE_TEMPERATURE: state->has_temperature_page = true; break;
+				case LOG_SENSE_PAGE_INFORMATIONAL_EXCEPTIONS: state->has_ie_page = true; break;
+				case LOG_SENSE_PAGE_READ_ERRORS: state->has_read_errors_page = true; break;
+				case LOG_SENSE_PAGE_VERIFY_ERRORS: state->has_verify_errors_page = true; break;
+			}
+		}
+	} else {
+		// Some devices don't list the supported pages, probe them one by one
+		state->has_temperature_page = disk_log_sense(&disk->dev, LOG_SENSE_PAGE_TEMPERATURE, 0, buf, sizeof(buf)) > 0;
+		state->has_ie_page = disk_log_sense(&disk->dev, LOG_SENSE_PAGE_INFORMATIONAL_EXCEPTIONS, 0, buf, sizeof(buf)) > 0;
+		state->has_read_errors_page = disk_log_sense(&disk->dev, LOG_SENSE_PAGE_READ_ERRORS, 0, buf, sizeof(buf)) > 0;
+		state->has_verify_errors_page = disk_log_sense(&disk->dev, LOG_SENSE_PAGE_VERIFY_ERRORS, 0, buf, sizeof(buf)) > 0;
+	}
+
+	state->has_grown_defects = disk_grown_defects_count(&disk->dev) >= 0;
+}
+
+static void scsi_test_temp(disk_t *disk, struct scsi_poll *poll)
+{
+	if (poll->temp < 0)
+		return;
+
+	if (poll->temp != disk->state.scsi.last_temp) {
+		INFO("Disk temperature changed from %d to %d", disk->state.scsi.last_temp, poll->temp);
+		disk->state.scsi.last_temp = poll->temp;
+	}
+
+	disk_temp_throttle(disk, poll->temp, scsi_read_temp);
+}
+
+static void scsi_test_ie(disk_t *disk, struct scsi_poll *poll)
+{
+	scsi_state_t *state = &disk->state.scsi;
+	char asc_name[ASC_NUM_NAME_LEN];
+
+	if (!poll->ie_valid)
+		return;
+	if (poll->ie_asc == state->last_ie_asc && poll->ie_ascq == state->last_ie_ascq)
+		return;
+
+	if (poll->ie_asc != 0)
+		ERROR("Disk reports an informational exception in the middle of the test: %s (asc 0x%02X ascq 0x%02X)",
+				asc_num_to_name_r(poll->ie_asc, poll->ie_ascq, asc_name, sizeof(asc_name)), poll->ie_asc, poll->ie_ascq);
+	else
+		INFO("Disk informational exception cleared");
+	state->last_ie_asc = poll->ie_asc;
+	state->last_ie_ascq = poll->ie_ascq;
+}
+
+static void scsi_test_error_counters(const char *name, bool valid, log_sense_error_counters_t *last, log_sense_error_counters_t *cur)
+{
+	if (!valid)
+		return;
+
+	if (cur->total_uncorrected > last->total_uncorrected) {
+		ERROR("Uncorrected %s errors increased from %"PRIu64" to %"PRIu64, name, last->total_uncorrected, cur->total_uncorrected);
+	}
+
+	if (cur->total_corrected > last->total_corrected) {
+		INFO("Corrected %s errors increased from %"PRIu64" to %"PRIu64, name, last->total_corrected, cur->total_corrected);
+	}
+
+	*last = *cur;
+}
+
+static void scsi_test_grown_defects(disk_t *disk, struct scsi_poll *poll)
+{
+	if (poll->grown_defects < 0)
+		return;
+
+	if (poll->grown_defects > disk->state.scsi.last_grown_defects) {
+		INFO("Number of grown defects increased from %d to %d", disk->state.scsi.last_grown_defects, poll->grown_defects);
+		if (disk->glist.poll)
+			grown_defects_update(disk);
+	}
+	disk->state.scsi.last_grown_defects = poll->grown_defects;
+}
+
 static void disk_scsi_monitor_start(disk_t *disk)
 {
-	(void)disk;
+	scsi_state_t *state = &disk->state.scsi;
+	struct scsi_poll poll;
+
+	scsi_supported_pages(disk);
+	scsi_poll(disk, &poll);
+
+	if (state->has_grown_defects)
+		grown_defects_start(disk);
+
+	state->last_temp = poll.temp;
+	if (poll.temp >= 0)
+		INFO("Disk start temperature is %d", poll.temp);
+
+	if (poll.ie_valid) {
+		char asc_name[ASC_NUM_NAME_LEN];
+
+		state->last_ie_asc = poll.ie_asc;
+		state->last_ie_ascq = poll.ie_ascq;
+		if (poll.ie_asc != 0)
+			ERROR("Disk reports an informational exception at the start of the test, it should be discarded anyhow: %s (asc 0x%02X ascq 0x%02X)",
+					asc_num_to_name_r(poll.ie_asc, poll.ie_ascq, asc_name, sizeof(asc_name)), poll.ie_asc, poll.ie_ascq);
+	}
+
+	if (poll.read_errors_valid)
+		state->last_read_errors = poll.read_errors;
+	if (poll.verify_errors_valid)
+		state->last_verify_errors = poll.verify_errors;
+
+	state->start_grown_defects = state->last_grown_defects = poll.grown_defects;
+	if (poll.grown_defects >= 0)
+		INFO("Disk has %d grown defects at the start of the test", poll.grown_defects);
+
+	if (!state->has_temperature_page && !state->has_ie_page && !state->has_read_errors_page && !state->has_verify_errors_page)
+		ERROR("Failed to find any supported log page to monitor the device");
 }
 
 static void disk_scsi_monitor(disk_t *disk)
 {
-	(void)disk;
+	struct scsi_poll poll;
+
+	scsi_poll(disk, &poll);
+	scsi_test_ie(disk, &poll);
+	scsi_test_error_counters("read", poll.read_errors_valid, &disk->state.scsi.last_read_errors, &poll.read_errors);
+	scsi_test_error_counters("verify", poll.verify_errors_valid, &disk->state.scsi.last_verify_errors, &poll.verify_errors);
+	scsi_test_grown_defects(disk, &poll);
+	scsi_test_temp(disk, &poll);
 }
 
 static void disk_scsi_monitor_end(disk_t *disk)
 {
-	(void)disk;
+	scsi_state_t *state = &disk->state.scsi;
+
+	disk_scsi_monitor(disk);
+
+	if (state->last_ie_asc != 0)
+		ERROR("Disk reports an informational exception at the end of the test, it should be discarded!");
+
+	if (state->start_grown_defects >= 0 && state->last_grown_defects > state->start_grown_defects)
+		INFO("Disk grew %d defects during the test, it has %d grown defects in total", state->last_grown_defects - state->start_grown_defects,
+				state->last_grown_defects);
+
+	if (state->last_grown_defects > 1000) {
+		INFO("Number of grown defects is above 1000, you should probably stop using this disk!");
+	}
 }
 
 static const char *disk_mount_str(disk_mount_e mount)
@@ -299,6 +598,9 @@ int disk_open(disk_t *disk, const char *path, int fix, unsigned latency_graph_le
 {
 	memset(disk, 0, sizeof(*disk));
 	disk->fix = fix;
+	disk->io_cpu = -1;
+	// Only disk_scan_stop() clears it so a stop requested before the scan starts is not lost
+	disk->run = 1;
 
 	INFO("Validating path %s", path);
 	if (access(path, F_OK)) {
@@ -352,11 +654,37 @@ int disk_open(disk_t *disk, const char *path, int fix, unsigned latency_graph_le
 	strncpy(disk->path, path, sizeof(disk->path));
 	disk->path[sizeof(disk->path)-1] = 0;
 
+	disk_capacity_t cap;
+	disk_io_limits_t limits;
+	disk->phys_sector_size = disk->sector_size;
+	disk->phys_align_offset = 0;
+	if (disk_read_capacity_16(&disk->dev, &cap) == 0) {
+		disk->thin_provisioned = cap.thin_provisioning_enabled;
+		if (cap.block_size == disk->sector_size && cap.logical_blocks_per_physical_block_exponent < 8) {
+			disk->phys_sector_size = disk->sector_size << cap.logical_blocks_per_physical_block_exponent;
+			disk->phys_align_offset = cap.lowest_aligned_lba * disk->sector_size % disk->phys_sector_size;
+		}
+	} else if (disk_dev_io_limits(path, &limits) == 0 &&
+		   limits.physical_block_bytes > disk->sector_size && limits.physical_block_bytes % disk->sector_size == 0) {
+		disk->phys_sector_size = limits.physical_block_bytes;
+	}
+
+	policy_defaults(&disk->policy);
+
 	hdr_init(1, 60*1000*1000, 3, &disk->histogram);
+	hdr_init(1, 60*1000*1000, 3, &disk->device_histogram);
+	hdr_init(1, 60*1000*1000, 3, &disk->jitter_histogram);
+	hdr_init(1, 60*1000*1000, 3, &disk->write_histogram);
+	hdr_init(1, 60*1000*1000, 3, &disk->retry_histogram);
+	if (!disk->histogram || !disk->device_histogram || !disk->jitter_histogram || !disk->write_histogram || !disk->retry_histogram) {
+		ERROR("Failed to allocate memory for latency histograms");
+		goto Error;
+	}
 
 	disk->latency_graph_len = latency_graph_len;
 	disk->latency_graph = calloc(latency_graph_len, sizeof(latency_t));
-	if (disk->latency_graph == NULL) {
+	disk->write_latency_graph = calloc(latency_graph_len, sizeof(latency_t));
+	if (disk->latency_graph == NULL || disk->write_latency_graph == NULL) {
 		ERROR("Failed to allocate memory for latency graph data");
 		goto Error;
 	}
@@ -365,8 +693,12 @@ int disk_open(disk_t *disk, const char *path, int fix, unsigned latency_graph_le
 		disk_ata_monitor_start(disk);
 	else
 		disk_scsi_monitor_start(disk);
+	cache_probe(disk);
 
 	INFO("Opened disk %s sector size %"PRIu64" num bytes %"PRIu64, path, disk->sector_size, disk->num_bytes);
+	if (disk->phys_sector_size != disk->sector_size)
+		INFO("Physical sector size %"PRIu64", lowest aligned LBA %"PRIu64", transfers are aligned to physical sectors",
+				disk->phys_sector_size, disk->phys_align_offset / disk->sector_size);
 	return 0;
 
 Error:
@@ -381,12 +713,28 @@ int disk_close(disk_t *disk)
 	else
 		disk_scsi_monitor_end(disk);
 
+	recovery_limit_restore(disk);
+	cache_restore(disk);
 	INFO("Closed disk %s", disk->path);
 	disk_dev_close(&disk->dev);
 	if (disk->latency_graph) {
 		free(disk->latency_graph);
 		disk->latency_graph = NULL;
 	}
+	free(disk->histogram);
+	free(disk->device_histogram);
+	free(disk->jitter_histogram);
+	free(disk->write_histogram);
+	free(disk->retry_histogram);
+	disk->histogram = disk->device_histogram = disk->jitter_histogram = disk->write_histogram = disk->retry_histogram = NULL;
+	free(disk->write_latency_graph);
+	disk->write_latency_graph = NULL;
+	grown_defects_free(disk);
+	fingerprint_free(disk);
+	free(disk->bad_areas.areas);
+	disk->bad_areas.areas = NULL;
+	zones_free(disk);
+	provisioning_free(disk);
 	return 0;
 }
 
@@ -412,39 +760,56 @@ static void free_buffer(void *buf, int buf_size)
 static void latency_bucket_prepare(disk_t *disk, struct scan_state *state, uint64_t offset)
 {
 	assert(state->latency_bucket < disk->latency_graph_len);
-	latency_t *l = &disk->latency_graph[state->latency_bucket];
+	latency_t *l = &state->latency_graph[state->latency_bucket];
 	const uint64_t start_sector = offset / disk->sector_size;
 
 	VVERBOSE("bucket prepare bucket=%u", state->latency_bucket);
 
 	l->start_sector = start_sector;
-	l->latency_min_msec = UINT32_MAX;
+	// Burn-in passes over the same bucket several times, keep the minimum of all of them
+	if (l->bytes == 0)
+		l->latency_min_msec = UINT32_MAX;
 	state->latency_count = 0;
 }
 
 static void latency_bucket_finish(disk_t *disk, struct scan_state *state, uint64_t offset)
 {
-	latency_t *l = &disk->latency_graph[state->latency_bucket];
+	latency_t *l = &state->latency_graph[state->latency_bucket];
 	const uint64_t end_sector = offset / disk->sector_size;
 
 	VVERBOSE("bucket finish bucket=%d", state->latency_bucket);
 
 	l->end_sector = end_sector;
-	l->latency_median_msec = median(state->latency, state->latency_count);
+	// A bucket that was skipped entirely has nothing to take the median of
+	if (state->latency_count)
+		l->latency_median_msec = median(state->latency, state->latency_count);
+	else if (l->bytes == 0)
+		l->latency_min_msec = l->latency_median_msec = 0;
 
 	state->latency_count = 0;
 	state->latency_bucket++;
 }
 
-static void latency_bucket_add(disk_t *disk, uint64_t latency, struct scan_state *state)
+static void latency_bucket_add(uint64_t latency, uint32_t data_size, uint64_t t_nsec, struct scan_state *state)
 {
-	latency_t *l = &disk->latency_graph[state->latency_bucket];
+	latency_t *l = &state->latency_graph[state->latency_bucket];
+	const bool first = l->bytes == 0;
+
+	l->bytes += data_size;
+	l->io_nsec += t_nsec;
 
-	if (latency < l->latency_min_msec)
+	if (first || latency < l->latency_min_msec)
 		l->latency_min_msec = latency;
 	if (l->latency_max_msec < latency)
 		l->latency_max_msec = latency;
 
+	// The bucket is long finished when it is backfilled, its median stays unless it had none
+	if (state->backfill) {
+		if (first)
+			l->latency_median_msec = latency;
+		return;
+	}
+
 	// Collect info for median calculation later
 	state->latency[state->latency_count++] = latency;
 }
@@ -476,6 +841,155 @@ static const char *data_to_str(enum result_data_e data)
 	return "unknown";
 }
 
+/* The first physical sector is partial when the lowest aligned LBA isn't 0 */
+uint64_t disk_phys_sector(const disk_t *disk, uint64_t offset)
+{
+	return (offset + (disk->phys_sector_size - disk->phys_align_offset) % disk->phys_sector_size) / disk->phys_sector_size;
+}
+
+uint64_t disk_phys_align_down(const disk_t *disk, uint64_t offset)
+{
+	const uint64_t lead = (disk->phys_sector_size - disk->phys_align_offset) % disk->phys_sector_size;
+	const uint64_t start = disk_phys_sector(disk, offset) * disk->phys_sector_size;
+
+	return start > lead ? start - lead : 0;
+}
+
+static void disk_scan_verify(disk_t *disk, uint64_t offset, void *data, int data_size, struct scan_state *state)
+{
+	const uint64_t lba = offset / disk->sector_size;
+	uint64_t first_bad_lba = 0;
+	unsigned num_bad;
+
+	num_bad = pattern_verify(state->pattern, data, lba, data_size / disk->sector_size, disk->sector_size, &first_bad_lba);
+	if (num_bad) {
+		char pattern_str[64];
+		ERROR("Data miscompare of %u sectors starting at LBA %"PRIu64" (physical sector %"PRIu64") in the read at offset %"PRIu64" size %d, pattern %s",
+				num_bad, first_bad_lba, disk_phys_sector(disk, first_bad_lba * disk->sector_size), offset, data_size,
+				pattern_to_str(state->pattern, pattern_str, sizeof(pattern_str)));
+		disk->burn_in.miscompare_sectors += num_bad;
+	}
+}
+
+/* The verdict is monotone, error counts and slow reads only ever grow. Once a
+ * threshold is crossed the disk fails whatever the rest of the scan finds, for
+ * the percentile that is when more reads were slow than the percentile allows
+ * out of all the reads the scan will do.
+ */
+static void verdict_update(disk_t *disk, struct scan_state *state, uint64_t t_usec)
+{
+	const verdict_policy_t *policy = &disk->policy;
+	enum conclusion conclusion = CONCLUSION_PASSED;
+
+	if (disk->early_conclusion != CONCLUSION_PASSED)
+		return;
+
+	if (!state->write && t_usec > (uint64_t)policy->percentile_latency_msec * 1000)
+		state->verdict_over_reads++;
+
+	if (disk->burn_in.miscompare_sectors > policy->max_miscompare_sectors)
+		conclusion = CONCLUSION_FAILED_MISCOMPARE;
+	else if (disk->num_errors > policy->max_io_errors)
+		conclusion = CONCLUSION_FAILED_IO_ERRORS;
+	else if (!state->write && t_usec > (uint64_t)policy->max_latency_msec * 1000)
+		conclusion = CONCLUSION_FAILED_MAX_LATENCY;
+	else if (state->verdict_reads && state->verdict_over_reads > state->verdict_over_bound)
+		conclusion = CONCLUSION_FAILED_LATENCY_PERCENTILE;
+	else
+		return;
+
+	disk->early_conclusion = conclusion;
+	ERROR("Disk is certain to fail: %s", conclusion_to_str(conclusion));
+	if (disk->stop_early == STOP_EARLY_NOW) {
+		INFO("Stopping the scan early");
+		disk->stopped_early = true;
+		disk->run = 0;
+	}
+}
+
+static void bad_area_add(disk_t *disk, uint64_t start, uint64_t end, uint64_t merge_gap)
+{
+	bad_areas_t *b = &disk->bad_areas;
+	const uint64_t start_sector = start / disk->sector_size;
+	const uint64_t end_sector = end / disk->sector_size;
+
+	// The failed reads between two skips of the same area are backfilled with it
+	if (b->len && b->areas[b->len-1].end_sector + merge_gap / disk->sector_size >= start_sector) {
+		b->areas[b->len-1].end_sector = b->areas[b->len-1].unread_end_sector = end_sector;
+		return;
+	}
+
+	if (b->len == b->size) {
+		unsigned size = b->size ? b->size * 2 : 16;
+		bad_area_t *areas = realloc(b->areas, size * sizeof(*areas));
+		if (areas == NULL) {
+			ERROR("Failed to allocate memory for the bad areas, the area at %"PRIu64" will not be backfilled", start_sector);
+			return;
+		}
+		b->areas = areas;
+		b->size = size;
+	}
+
+	bad_area_t *area = &b->areas[b->len++];
+	area->start_sector = start_sector;
+	area->end_sector = end_sector;
+	// All of it is unread until it is backfilled
+	area->unread_start_sector = start_sector;
+	area->unread_end_sector = end_sector;
+}
+
+/* The end of the part of the zone at the offset that holds data, the end of the disk when it isn't zoned */
+static uint64_t zone_readable_end(const disk_t *disk, uint64_t offset)
+{
+	if (!disk->zones.zoned)
+		return disk->num_bytes;
+
+	const uint64_t index = offset / disk->sector_size / disk->zones.zone_sectors;
+	const zone_t *zone = &disk->zones.zones[index < disk->zones.len ? index : disk->zones.len - 1];
+	return (zone->start_sector + zone->readable_sectors) * disk->sector_size;
+}
+
+/* Jump ahead over a run of failed reads with an exponentially growing skip to
+ * find the end of the bad area quickly, the skipped parts are backfilled once
+ * the rest of the disk was scanned.
+ */
+static void bad_area_track(disk_t *disk, struct scan_state *state, uint64_t offset, int data_size, bool error)
+{
+	uint64_t skip_max;
+
+	if (!error) {
+		state->skip_bytes = 0;
+		return;
+	}
+
+	if (state->consecutive_errors < BAD_AREA_ERRORS)
+		return;
+
+	if (state->skip_bytes == 0)
+		state->skip_bytes = state->read_size * BAD_AREA_SKIP_READS;
+	else
+		state->skip_bytes *= 2;
+	skip_max = disk->num_bytes / 1000 * BAD_AREA_SKIP_MAX_PERMILLE / disk->sector_size * disk->sector_size;
+	if (skip_max < state->read_size * BAD_AREA_SKIP_READS)
+		skip_max = state->read_size * BAD_AREA_SKIP_READS;
+	if (state->skip_bytes > skip_max)
+		state->skip_bytes = skip_max;
+
+	const uint64_t start = offset + data_size;
+	uint64_t end = start + state->skip_bytes;
+	// A skip never goes past the data of the zone, the scan doesn't read beyond it
+	const uint64_t readable_end = zone_readable_end(disk, offset);
+	if (end > readable_end)
+		end = readable_end;
+	if (start >= end)
+		return;
+
+	VERBOSE("Skipping bad area from offset %"PRIu64" to %"PRIu64, start, end);
+	// Reads restart at the next offset in the scan order, up to one read past the skip
+	bad_area_add(disk, start, end, 2 * state->read_size);
+	state->skip_until = end;
+}
+
 static bool disk_scan_part(disk_t *disk, uint64_t offset, void *data, int data_size, struct scan_state *state)
 {
 	ssize_t ret;
@@ -484,29 +998,64 @@ static bool disk_scan_part(disk_t *disk, uint64_t offset, void *data, int data_s
 	uint64_t t;
 	int error = 0;
 	io_result_t io_res;
+	const char *op = state->write ? "writing" : "reading";
 
+	if (state->write)
+		pattern_fill(state->pattern, data, offset / disk->sector_size, data_size / disk->sector_size, disk->sector_size);
+
+	repair_io_begin(disk);
 	clock_gettime(CLOCK_MONOTONIC, &t_start);
-	ret = disk_dev_read(&disk->dev, offset, data_size, data, &io_res);
+	if (state->write)
+		ret = disk_dev_write(&disk->dev, offset, data_size, data, &io_res);
+	else
+		ret = disk_dev_read(&disk->dev, offset, data_size, data, &io_res);
 	clock_gettime(CLOCK_MONOTONIC, &t_end);
 
-	t = (t_end.tv_sec - t_start.tv_sec) * 1000000000 +
-		t_end.tv_nsec - t_start.tv_nsec;
+	t = ts_diff_nsec(&t_end, &t_start);
 	const uint64_t t_msec = t / 1000000;
 
-	// Perform logging
-	data_log_raw(&disk->data_raw, offset/disk->sector_size, data_size/disk->sector_size, &io_res, t);
-	data_log(&disk->data_log, offset/disk->sector_size, data_size/disk->sector_size, &io_res, t);
+	disk->profile.io_nsec += t;
+	if (io_res.device_time_valid) {
+		disk->profile.io_timed_nsec += t;
+		disk->profile.device_nsec += (uint64_t)io_res.device_time_msec * 1000000;
+		if (!state->write)
+			hdr_record_value(disk->device_histogram, (uint64_t)io_res.device_time_msec * 1000);
+	}
+
+	// Perform logging, the logs describe the reads
+	if (!state->write && (disk->data_raw.f || disk->data_log.f)) {
+		struct timespec t_logged;
+
+		data_log_raw(&disk->data_raw, offset/disk->sector_size, data_size/disk->sector_size, &io_res, t);
+		data_log(&disk->data_log, offset/disk->sector_size, data_size/disk->sector_size, &io_res, t);
+
+		clock_gettime(CLOCK_MONOTONIC, &t_logged);
+		disk->profile.logging_nsec += ts_diff_nsec(&t_logged, &t_end);
+	}
+
+	// Transient errors are retried and media errors bisected, the first attempt is what the latencies describe
+	retry_action_e action = RETRY_ACTION_NONE;
+	const int s_errno = errno;
+	if (io_res.data != DATA_FULL || (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED))
+		action = retry_io(disk, state->write, offset, data_size, data, &io_res, state->consecutive_errors == 0);
+	repair_io_end(disk);
+
+	// A recovered error returned all the data, it is only counted and does not affect the verdict.
+	// A read recovered by bisection is counted by the retry policy.
+	if (action != RETRY_ACTION_BISECT && io_res.data == DATA_FULL && io_res.error == ERROR_CORRECTED) {
+		VERBOSE("Recovered error when %s at offset %" PRIu64 " size %d", op, offset, data_size);
+		disk->retry.corrected++;
+	}
 
 	// Handle error or incomplete data
-	if (io_res.data != DATA_FULL || io_res.error != ERROR_NONE) {
-		int s_errno = errno;
-		ERROR("Error when reading at offset %" PRIu64 " size %d read %zd, errno=%d: %s", offset, data_size, ret, errno, strerror(errno));
+	if (io_res.data != DATA_FULL || (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED)) {
+		ERROR("Error when %s at offset %" PRIu64 " size %d done %zd, errno=%d: %s", op, offset, data_size, ret, s_errno, strerror(s_errno));
 		ERROR("Details: error=%s data=%s %02X/%02X/%02X", error_to_str(io_res.error), data_to_str(io_res.data),
 				io_res.info.sense_key, io_res.info.asc, io_res.info.ascq);
 		report_scan_error(disk, offset, data_size, t);
 		disk->num_errors++;
 		error = 1;
-		if (io_res.error == ERROR_FATAL) {
+		if (action == RETRY_ACTION_ABORT) {
 			ERROR("Fatal error occurred, bailing out.");
 			return false;
 		}
@@ -522,55 +1071,216 @@ static bool disk_scan_part(disk_t *disk, uint64_t offset, void *data, int data_s
 	else {
 		state->num_unknown_errors = 0; // Clear non-consecutive unknown errors
 		report_scan_success(disk, offset, data_size, t);
+		if (state->pattern && !state->write)
+			disk_scan_verify(disk, offset, data, data_size, state);
 	}
 
-	hdr_record_value(disk->histogram, t / 1000);
-	latency_bucket_add(disk, t_msec, state);
+	// Checksumming continues in the background while the next read goes to another buffer
+	if (!state->write)
+		state->data = fingerprint_submit(disk, offset, data, data_size, !error);
+
+	hdr_record_value(state->write ? disk->write_histogram : disk->histogram, t / 1000);
+	verdict_update(disk, state, t / 1000);
+	latency_bucket_add(t_msec, data_size, t, state);
+	metrics_io(disk, data_size, io_res.error);
+	metrics_update(disk, state->latency_bucket, &t_end);
 
 	if (t_msec > 1000) {
 		VERBOSE("Scanning at offset %" PRIu64 " took %"PRIu64" msec", offset, t_msec);
 	}
 
-	if (disk->fix && (t_msec > 3000 || error)) {
-		if (io_res.error != ERROR_UNCORRECTED) {
-			INFO("Fixing region by rewriting, offset=%"PRIu64" size=%d", offset, data_size);
-			ret = disk_dev_write(&disk->dev, offset, data_size, data, &io_res);
-			if (ret != data_size) {
-				ERROR("Error while attempting to rewrite the data! ret=%zd errno=%d: %s", ret, errno, strerror(errno));
-			}
-		} else {
-			// When we correct uncorrectable errors we want to zero it out, this should reduce any confusion later on when the data is read
-			unsigned fix_offset = 0;
-			int fix_size = 4096;
-
-			if (data_size < fix_size)
-				fix_size = data_size;
-
-			for (; data_size >= (int)(fix_offset + fix_size); fix_offset += fix_size) {
-				disk_dev_read(&disk->dev, offset+fix_offset, fix_size, data, &io_res);
-				if (io_res.error == ERROR_UNCORRECTED) {
-					INFO("Fixing uncorrectable region by writing zeros, offset=%"PRIu64" size=%d", offset+fix_offset, fix_size);
-					memset(data, 0, fix_size);
-					ret = disk_dev_write(&disk->dev, offset+fix_offset, fix_size, data, &io_res);
-					if (ret != data_size) {
-						ERROR("Error while attempting to overwrite uncorrectable data! ret=%zd errno=%d: %s", ret, errno, strerror(errno));
-					}
-				}
-			}
+	if (disk->fix && !state->write && (t_msec > 3000 || error))
+		repair_queue(disk, offset, data_size);
+
+	state->consecutive_errors = error ? state->consecutive_errors + 1 : 0;
+	if (state->skip_bad_areas && !state->backfill)
+		bad_area_track(disk, state, offset, data_size, error);
+
+	return true;
+}
+
+struct size_probe {
+	uint32_t size;
+	double throughput_mbps;
+	uint64_t max_latency_nsec;
+	bool failed;
+	bool slow;
+};
+
+static void size_probe_run(disk_t *disk, struct size_probe *probe, uint64_t offset, void *buf)
+{
+	io_result_t io_res;
+	struct timespec t_start;
+	struct timespec t_end;
+	uint64_t bytes = 0;
+	uint64_t total_nsec = 0;
+	bool first = true;
+
+	while (disk->run && bytes < SIZE_PROBE_BYTES && total_nsec < SIZE_PROBE_NSEC) {
+		if (offset + probe->size > disk->num_bytes)
+			offset = 0;
+
+		clock_gettime(CLOCK_MONOTONIC, &t_start);
+		disk_dev_read(&disk->dev, offset, probe->size, buf, &io_res);
+		clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+		if (io_res.data != DATA_FULL || (io_res.error != ERROR_NONE && io_res.error != ERROR_CORRECTED)) {
+			probe->failed = true;
+			return;
+		}
+
+		offset += probe->size;
+
+		// The first read pays for the seek to the probe region
+		if (first) {
+			first = false;
+			continue;
 		}
+
+		const uint64_t t = ts_diff_nsec(&t_end, &t_start);
+		bytes += probe->size;
+		total_nsec += t;
+		if (t > probe->max_latency_nsec)
+			probe->max_latency_nsec = t;
 	}
 
-	return true;
+	if (total_nsec)
+		probe->throughput_mbps = bytes * 1000.0 / total_nsec;
+}
+
+static unsigned size_probe_add(struct size_probe *probes, unsigned num_probes, uint32_t size)
+{
+	unsigned i;
+
+	for (i = 0; i < num_probes; i++) {
+		if (probes[i].size == size)
+			return num_probes;
+		if (probes[i].size > size)
+			break;
+	}
+
+	memmove(&probes[i+1], &probes[i], sizeof(*probes) * (num_probes - i));
+	memset(&probes[i], 0, sizeof(*probes));
+	probes[i].size = size;
+	return num_probes + 1;
+}
+
+unsigned disk_scan_size_auto(disk_t *disk, bool *interrupted)
+{
+	disk_io_limits_t limits;
+	struct size_probe probes[16];
+	unsigned num_probes = 0;
+	uint32_t align = disk->phys_sector_size;
+	uint32_t max_size = SIZE_PROBE_DEFAULT_MAX;
+	uint32_t size;
+	unsigned i;
+
+	*interrupted = false;
+
+	if (disk_dev_io_limits(disk->path, &limits) == 0) {
+		INFO("Device I/O limits: max transfer %u KB, optimal I/O size %u KB, physical block %u bytes",
+				limits.max_transfer_bytes / 1024, limits.optimal_io_bytes / 1024, limits.physical_block_bytes);
+		if (limits.max_transfer_bytes)
+			max_size = limits.max_transfer_bytes;
+		if (limits.physical_block_bytes > align && limits.physical_block_bytes % align == 0)
+			align = limits.physical_block_bytes;
+	} else {
+		INFO("Device I/O limits are unknown, probing transfer sizes up to %u KB", max_size / 1024);
+	}
+
+	if (max_size > SIZE_PROBE_MAX)
+		max_size = SIZE_PROBE_MAX;
+
+	for (size = SIZE_PROBE_MIN; size <= max_size && num_probes < ARRAY_SIZE(probes) - 1; size *= 2) {
+		if (size % align == 0)
+			num_probes = size_probe_add(probes, num_probes, size);
+	}
+
+	// RAID LUNs report their full stripe which need not be a power of two
+	if (limits.optimal_io_bytes && limits.optimal_io_bytes <= max_size && limits.optimal_io_bytes % align == 0)
+		num_probes = size_probe_add(probes, num_probes, limits.optimal_io_bytes);
+
+	if (num_probes == 0) {
+		ERROR("No transfer size to probe between %u and %u bytes", SIZE_PROBE_MIN, max_size);
+		return 0;
+	}
+
+	void *buf = allocate_buffer(probes[num_probes-1].size);
+	if (buf == NULL) {
+		ERROR("Failed to allocate probe buffer, errno=%d: %s", errno, strerror(errno));
+		return 0;
+	}
+
+	for (i = 0; disk->run && i < num_probes; i++) {
+		// Each size reads its own region so no probe benefits from the disk cache of another
+		size_probe_run(disk, &probes[i], (uint64_t)i * (SIZE_PROBE_BYTES + max_size), buf);
+
+		if (probes[i].failed) {
+			INFO("Probe %6u KB: read failed, not considered", probes[i].size / 1024);
+			continue;
+		}
+
+		INFO("Probe %6u KB: %8.1f MB/s, max latency %"PRIu64" msec", probes[i].size / 1024,
+				probes[i].throughput_mbps, probes[i].max_latency_nsec / 1000000);
+	}
+
+	free_buffer(buf, probes[num_probes-1].size);
+
+	if (!disk->run) {
+		INFO("Transfer size probe interrupted");
+		*interrupted = true;
+		return 0;
+	}
+
+	// Throughput bought with a much longer wait for each read would hide slow sectors in the latencies
+	const struct size_probe *smallest = NULL;
+	double best_mbps = 0.0;
+	for (i = 0; i < num_probes; i++) {
+		if (probes[i].failed || probes[i].throughput_mbps <= 0.0)
+			continue;
+
+		if (smallest == NULL) {
+			smallest = &probes[i];
+		} else if (probes[i].max_latency_nsec > smallest->max_latency_nsec * SIZE_PROBE_LATENCY_FACTOR) {
+			INFO("Probe %6u KB: max latency %"PRIu64" msec is over %u times the %"PRIu64" msec of %u KB, not considered",
+					probes[i].size / 1024, probes[i].max_latency_nsec / 1000000, SIZE_PROBE_LATENCY_FACTOR,
+					smallest->max_latency_nsec / 1000000, smallest->size / 1024);
+			probes[i].slow = true;
+			continue;
+		}
+
+		if (probes[i].throughput_mbps > best_mbps)
+			best_mbps = probes[i].throughput_mbps;
+	}
+
+	// Larger transfers only make each I/O slower, take the smallest size that is about as fast as the best
+	for (i = 0; i < num_probes; i++) {
+		if (!probes[i].failed && !probes[i].slow && probes[i].throughput_mbps > 0.0 &&
+		    probes[i].throughput_mbps * 100 >= best_mbps * SIZE_PROBE_GOOD_ENOUGH_PERCENT)
+		{
+			INFO("Selected scan size of %u KB", probes[i].size / 1024);
+			return probes[i].size;
+		}
+	}
+
+	ERROR("Transfer size probing failed");
+	return 0;
 }
 
 static uint64_t calc_latency_stride(disk_t *disk)
 {
+	// A zoned disk has a latency bucket per zone
+	if (disk->zones.zoned)
+		return disk->zones.zone_sectors;
+
 	const uint64_t num_sectors = disk->num_bytes / disk->sector_size;
 	const uint64_t stride_size = num_sectors / disk->latency_graph_len;
+	const uint64_t phys_sectors = disk->phys_sector_size / disk->sector_size;
 	// At this stage stride_size may have a reminder, we need to distribute the
 	// latencies a bit more to avoid it Since the remainder can never be more
-	// than the latency_graph_len we can just add one entry to all the buckets
-	return stride_size + 1;
+	// than the latency_graph_len we can just add one entry to all the buckets.
+	// Strides are whole physical sectors so the reads in them stay aligned.
+	return (stride_size + phys_sectors) / phys_sectors * phys_sectors;
 }
 
 static uint32_t *calc_scan_order_seq(disk_t *disk, uint64_t stride_size, int read_size_sectors)
@@ -630,7 +1340,7 @@ static void progress_calc(disk_t *disk, struct scan_state *state, uint64_t add)
 
 	if (add != 0) {
 		state->progress_bytes += add;
-		int progress_part_new = state->progress_bytes * state->progress_full / disk->num_bytes;
+		int progress_part_new = state->progress_bytes * state->progress_full / state->progress_total;
 		do_update = progress_part_new != state->progress_part;
 		state->progress_part = progress_part_new;
 	} else {
@@ -638,37 +1348,213 @@ static void progress_calc(disk_t *disk, struct scan_state *state, uint64_t add)
 	}
 
 	if (do_update) {
+		struct timespec ts_start;
+		struct timespec ts_end;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts_start);
 		report_progress(disk, state->progress_part, state->progress_full);
+		clock_gettime(CLOCK_MONOTONIC, &ts_end);
+		disk->profile.progress_nsec += ts_diff_nsec(&ts_end, &ts_start);
 	}
 }
 
 static bool disk_scan_latency_stride(disk_t *disk, struct scan_state *state, uint64_t base_offset, uint64_t data_size, uint32_t *scan_order)
 {
 	unsigned i;
-	uint64_t stride_end = base_offset + state->latency_stride * disk->sector_size;
+	// Reads are shifted to the physical sector boundaries, zones always start on one
+	const uint64_t align = disk->zones.zoned ? 0 : disk->phys_align_offset;
+	uint64_t stride_end = base_offset + state->latency_stride * disk->sector_size + align;
 	if (stride_end > disk->num_bytes)
 		stride_end = disk->num_bytes;
+	// Only the part of a zone that holds data is read
+	if (disk->zones.zoned)
+		stride_end = base_offset + disk->zones.zones[state->latency_bucket].readable_sectors * disk->sector_size;
+
+	// The sectors before the lowest aligned LBA are read on their own
+	if (base_offset == 0 && align && state->skip_until == 0 && provisioning_read_wanted(disk, 0, align)) {
+		progress_calc(disk, state, align);
+		if (!disk_scan_part(disk, 0, state->data, align, state))
+			return false;
+	}
 
 	for (i = 0; disk->run && scan_order[i] != UINT32_MAX; i++) {
-		uint64_t offset = base_offset + scan_order[i];
+		uint64_t offset = base_offset + scan_order[i] + align;
+		uint64_t size = data_size;
+
+		if (offset >= stride_end)
+			continue;
 
 		progress_calc(disk, state, data_size);
 
 		VVVERBOSE("Scanning at offset %"PRIu64" index %u", offset, i);
-		int64_t remainder = stride_end - offset;
-		if (remainder < (int64_t)data_size) {
-			data_size = remainder;
-			VERBOSE("Last part scanning size %"PRIu64, data_size);
+		if (stride_end - offset < size) {
+			size = stride_end - offset;
+			VERBOSE("Last part scanning size %"PRIu64, size);
 		}
-		if (offset > disk->num_bytes || (offset+remainder) > disk->num_bytes)
+		if (offset < state->skip_until)
+			continue;
+		if (!provisioning_read_wanted(disk, offset, size))
 			continue;
-		if (!disk_scan_part(disk, offset, state->data, data_size, state))
+		if (!disk_scan_part(disk, offset, state->data, size, state))
 			return false;
 	}
 
 	return true;
 }
 
+static void disk_monitor(disk_t *disk)
+{
+	struct timespec ts_start;
+	struct timespec ts_end;
+	const uint64_t throttle_nsec = disk->profile.throttle_nsec;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+	if (disk->is_ata)
+		disk_ata_monitor(disk);
+	else
+		disk_scsi_monitor(disk);
+
+	// Pauses for temperature are accounted on their own
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	disk->profile.monitor_nsec += ts_diff_nsec(&ts_end, &ts_start) - (disk->profile.throttle_nsec - throttle_nsec);
+}
+
+/* One pass over the whole disk, reading or writing in the scan order */
+static bool disk_scan_pass(disk_t *disk, struct scan_state *state, uint64_t data_size, uint32_t *scan_order)
+{
+	const uint64_t latency_stride = state->latency_stride;
+	uint64_t offset;
+
+	state->latency_bucket = 0;
+	state->latency_count = 0;
+	state->latency_graph = state->write ? disk->write_latency_graph : disk->latency_graph;
+
+	for (offset = 0; disk->run && offset < disk->num_bytes; offset += latency_stride * disk->sector_size) {
+		VERBOSE("Scanning stride starting at %"PRIu64" done %"PRIu64"%%", offset, offset*100/disk->num_bytes);
+		progress_calc(disk, state, 0);
+		latency_bucket_prepare(disk, state, offset);
+		if (!disk_scan_latency_stride(disk, state, offset, data_size, scan_order))
+			return false;
+		latency_bucket_finish(disk, state, offset + latency_stride * disk->sector_size);
+		disk_monitor(disk);
+	}
+
+	return disk->run;
+}
+
+/* Size of a backfill read at the offset, 0 when the scan would not read there as it is past the
+ * data of the zone or in an unmapped extent
+ */
+static uint64_t backfill_read_size(disk_t *disk, uint64_t offset, uint64_t size)
+{
+	const uint64_t readable_end = zone_readable_end(disk, offset);
+
+	if (offset >= readable_end)
+		return 0;
+	if (offset + size > readable_end)
+		size = readable_end - offset;
+	if (!provisioning_read_wanted(disk, offset, size))
+		return 0;
+	return size;
+}
+
+/* Read toward the bad middle of the area from both of its ends, stops at the first error from each side */
+static bool disk_scan_backfill_area(disk_t *disk, struct scan_state *state, bad_area_t *area, uint64_t read_size)
+{
+	const uint64_t bucket_bytes = state->latency_stride * disk->sector_size;
+	const uint64_t start = area->start_sector * disk->sector_size;
+	uint64_t low = start;
+	uint64_t high = area->end_sector * disk->sector_size;
+	uint64_t num_errors;
+
+	VERBOSE("Backfilling bad area from offset %"PRIu64" to %"PRIu64, low, high);
+
+	num_errors = disk->num_errors;
+	while (disk->run && high > low && disk->num_errors == num_errors) {
+		const uint64_t size = high - low < read_size ? high - low : read_size;
+
+		high -= size;
+		const uint64_t wanted = backfill_read_size(disk, high, size);
+		state->latency_bucket = high / bucket_bytes;
+		if (wanted && !disk_scan_part(disk, high, state->data, wanted, state))
+			return false;
+	}
+
+	num_errors = disk->num_errors;
+	while (disk->run && low < high && disk->num_errors == num_errors) {
+		const uint64_t size = high - low < read_size ? high - low : read_size;
+
+		const uint64_t wanted = backfill_read_size(disk, low, size);
+		state->latency_bucket = low / bucket_bytes;
+		if (wanted && !disk_scan_part(disk, low, state->data, wanted, state))
+			return false;
+		low += size;
+	}
+
+	area->unread_start_sector = low / disk->sector_size;
+	area->unread_end_sector = high / disk->sector_size;
+	disk->bad_areas.unread_sectors += area->unread_end_sector - area->unread_start_sector;
+	if (low < high)
+		ERROR("Bad area from LBA %"PRIu64" to %"PRIu64" left unread", area->unread_start_sector, area->unread_end_sector);
+	return true;
+}
+
+/* Backfill the skipped areas in reverse, the small reads find the edges of the bad part of each area */
+static bool disk_scan_backfill(disk_t *disk, struct scan_state *state, uint64_t data_size)
+{
+	uint64_t read_size = data_size / BAD_AREA_BACKFILL_DIV / disk->phys_sector_size * disk->phys_sector_size;
+	unsigned i;
+
+	if (read_size == 0)
+		read_size = disk->phys_sector_size;
+
+	if (disk->bad_areas.len)
+		INFO("Backfilling %u skipped bad areas", disk->bad_areas.len);
+
+	state->backfill = true;
+	for (i = disk->bad_areas.len; disk->run && i > 0; i--) {
+		if (!disk_scan_backfill_area(disk, state, &disk->bad_areas.areas[i-1], read_size))
+			return false;
+		disk_monitor(disk);
+	}
+	state->backfill = false;
+
+	if (disk->bad_areas.unread_sectors)
+		ERROR("%"PRIu64" sectors in %u bad areas were left unread", disk->bad_areas.unread_sectors, disk->bad_areas.len);
+	return disk->run;
+}
+
+static void scan_profile_finish(scan_profile_t *p)
+{
+	const uint64_t accounted = p->io_nsec + p->logging_nsec + p->monitor_nsec + p->progress_nsec + p->throttle_nsec + p->retry_wait_nsec;
+
+	// The device time has a msec granularity so it can slightly exceed the wall time
+	p->io_overhead_nsec = p->io_timed_nsec > p->device_nsec ? p->io_timed_nsec - p->device_nsec : 0;
+	p->io_untimed_nsec = p->io_nsec - p->io_timed_nsec;
+	p->other_nsec = p->total_nsec > accounted ? p->total_nsec - accounted : 0;
+}
+
+static void scan_profile_line(const char *name, uint64_t nsec, uint64_t total_nsec)
+{
+	INFO("    %-14s %10.1f sec %5.1f%%", name, nsec / 1e9, total_nsec ? nsec * 100.0 / total_nsec : 0.0);
+}
+
+static void scan_profile_report(const scan_profile_t *p)
+{
+	INFO("Scan time profile:");
+	scan_profile_line("device", p->device_nsec, p->total_nsec);
+	scan_profile_line("io overhead", p->io_overhead_nsec, p->total_nsec);
+	if (p->io_untimed_nsec)
+		scan_profile_line("io (untimed)", p->io_untimed_nsec, p->total_nsec);
+	scan_profile_line("logging", p->logging_nsec, p->total_nsec);
+	scan_profile_line("monitoring", p->monitor_nsec, p->total_nsec);
+	scan_profile_line("progress", p->progress_nsec, p->total_nsec);
+	scan_profile_line("throttle", p->throttle_nsec, p->total_nsec);
+	scan_profile_line("retry wait", p->retry_wait_nsec, p->total_nsec);
+	scan_profile_line("other", p->other_nsec, p->total_nsec);
+}
+
 static void set_realtime(bool realtime)
 {
 	struct sched_param param;
@@ -681,15 +1567,131 @@ static void set_realtime(bool realtime)
 		sched_setscheduler(0, SCHED_OTHER, &param);
 }
 
+static bool set_cpu(int cpu, cpu_set_t *old_cpus)
+{
+	cpu_set_t cpus;
+
+	if (sched_getaffinity(0, sizeof(*old_cpus), old_cpus) < 0) {
+		ERROR("Failed to get the current CPU affinity, errno=%d: %s", errno, strerror(errno));
+		return false;
+	}
+
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+		ERROR("Failed to pin the scan to CPU %d, errno=%d: %s", cpu, errno, strerror(errno));
+		return false;
+	}
+
+	INFO("Scan pinned to CPU %d", cpu);
+	return true;
+}
+
+/* Measure how late the host wakes us up from a short sleep, in the same
+ * conditions as the scan itself. This is the noise floor of the latency
+ * measurements, modelled after hdrhistogram/examples/hiccup.c.
+ */
+static void jitter_calibrate(disk_t *disk)
+{
+	const struct timespec interval = {.tv_sec = 0, .tv_nsec = 1000*1000};
+	struct timespec ts_start;
+	struct timespec t0;
+	struct timespec t1;
+
+	INFO("Measuring host jitter for %u seconds", disk->jitter_calibration_sec);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		clock_nanosleep(CLOCK_MONOTONIC, 0, &interval, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		const int64_t late_usec = ((int64_t)ts_diff_nsec(&t1, &t0) - interval.tv_nsec) / 1000;
+		hdr_record_value(disk->jitter_histogram, late_usec > 0 ? late_usec : 0);
+	} while (disk->run && t1.tv_sec - ts_start.tv_sec < disk->jitter_calibration_sec);
+
+	static const double percentiles[] = {50.0, 99.0, 99.99};
+	int64_t values[ARRAY_SIZE(percentiles)];
+
+	hdr_value_at_percentiles(disk->jitter_histogram, percentiles, values, ARRAY_SIZE(percentiles));
+	INFO("Host jitter: median %"PRId64" usec, 99%% %"PRId64" usec, 99.99%% %"PRId64" usec, max %"PRId64" usec",
+			values[0], values[1], values[2], hdr_max(disk->jitter_histogram));
+}
+
+/* Every stride goes over the whole scan order, some entries past the end of the disk are skipped */
+static uint64_t verdict_reads_bound(disk_t *disk, uint64_t latency_stride, const uint32_t *scan_order, uint64_t read_size)
+{
+	const uint64_t stride_bytes = latency_stride * disk->sector_size;
+	const uint64_t num_strides = (disk->num_bytes + stride_bytes - 1) / stride_bytes;
+	const unsigned read_passes = disk->burn_in.num_patterns ? disk->burn_in.num_patterns : 1;
+	uint64_t num_entries = 0;
+
+	if (disk->zones.zoned) {
+		// Reads start at every read size step and end at the data in the zone
+		uint64_t num_reads = 0;
+		unsigned i;
+
+		for (i = 0; i < disk->zones.len; i++)
+			num_reads += (disk->zones.zones[i].readable_sectors * disk->sector_size + read_size - 1) / read_size;
+		return num_reads * read_passes;
+	}
+
+	while (scan_order[num_entries] != UINT32_MAX)
+		num_entries++;
+
+	return num_strides * num_entries * read_passes;
+}
+
+static const double latency_report_percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+
+/* All the percentiles are taken in one pass over the histogram */
+static void latency_percentiles_calc(disk_t *disk)
+{
+	latency_percentiles_t *lp = &disk->latency_percentiles;
+	const double policy_percentile = disk->policy.latency_percentile;
+	bool policy_added = false;
+	unsigned i;
+
+	lp->len = 0;
+	for (i = 0; i < ARRAY_SIZE(latency_report_percentiles); i++) {
+		if (!policy_added && policy_percentile <= latency_report_percentiles[i]) {
+			if (policy_percentile < latency_report_percentiles[i])
+				lp->percentile[lp->len++] = policy_percentile;
+			policy_added = true;
+		}
+		lp->percentile[lp->len++] = latency_report_percentiles[i];
+	}
+	if (!policy_added)
+		lp->percentile[lp->len++] = policy_percentile;
+
+	hdr_value_at_percentiles(disk->histogram, lp->percentile, lp->value_usec, lp->len);
+}
+
+static int64_t latency_percentile_value(const latency_percentiles_t *lp, double percentile)
+{
+	unsigned i;
+
+	for (i = 0; i < lp->len; i++) {
+		if (lp->percentile[i] == percentile)
+			return lp->value_usec[i];
+	}
+	return 0;
+}
+
 static enum conclusion conclusion_calc(disk_t *disk)
 {
-	if (disk->num_errors > 0)
+	const verdict_policy_t *policy = &disk->policy;
+
+	if (disk->burn_in.miscompare_sectors > policy->max_miscompare_sectors)
+		return CONCLUSION_FAILED_MISCOMPARE;
+
+	if (disk->num_errors > policy->max_io_errors)
 		return CONCLUSION_FAILED_IO_ERRORS;
 
-	if (hdr_max(disk->histogram) > 10000000)
+	if (hdr_max(disk->histogram) > (int64_t)policy->max_latency_msec * 1000)
 		return CONCLUSION_FAILED_MAX_LATENCY;
 
-	if (hdr_value_at_percentile(disk->histogram, 99.99) > 8000000)
+	if (latency_percentile_value(&disk->latency_percentiles, policy->latency_percentile) > (int64_t)policy->percentile_latency_msec * 1000)
 		return CONCLUSION_FAILED_LATENCY_PERCENTILE;
 
 	VERBOSE("Disk has passed the test");
@@ -698,16 +1700,19 @@ static enum conclusion conclusion_calc(disk_t *disk)
 
 int disk_scan(disk_t *disk, enum scan_mode mode, unsigned data_size)
 {
-	disk->run = 1;
-	void *data = allocate_buffer(data_size);
+	void *data;
 	uint32_t *scan_order = NULL;
 	int result = 0;
 	struct scan_state state = {.latency = NULL, .progress_bytes = 0, .progress_full = 1000};
 	struct timespec ts_start;
 	struct timespec ts_end;
 	time_t scan_time;
+	cpu_set_t old_cpus;
+	bool cpu_pinned = false;
+	bool mem_locked = false;
 
 	disk->conclusion = CONCLUSION_SCAN_PROBLEM;
+	memset(&disk->profile, 0, sizeof(disk->profile));
 
 	if (data_size % disk->sector_size != 0) {
 		data_size -= data_size % disk->sector_size;
@@ -716,7 +1721,20 @@ int disk_scan(disk_t *disk, enum scan_mode mode, unsigned data_size)
 		ERROR("Cannot scan data not in multiples of the sector size, adjusted scan size to %u", data_size);
 	}
 
+	// A partial physical sector costs the disk a read-modify-write or an extra media read
+	if (data_size % disk->phys_sector_size != 0) {
+		data_size -= data_size % disk->phys_sector_size;
+		if (data_size == 0)
+			data_size = disk->phys_sector_size;
+		INFO("Aligned the scan size to the physical sector size, scan size is %u", data_size);
+	}
+
+	// Allocated with the final size, it is freed with it
+	data = allocate_buffer(data_size);
+
 	set_realtime(true);
+	if (disk->io_cpu >= 0)
+		cpu_pinned = set_cpu(disk->io_cpu, &old_cpus);
 	clock_gettime(CLOCK_MONOTONIC, &ts_start);
 
 	INFO("Scanning disk %s in %u byte steps", disk->path, data_size);
@@ -730,8 +1748,21 @@ int disk_scan(disk_t *disk, enum scan_mode mode, unsigned data_size)
 		goto Exit;
 	}
 
-	uint64_t offset;
-	const uint64_t disk_size_bytes = disk->num_bytes;
+	if (zones_load(disk) != 0) {
+		result = 1;
+		goto Exit;
+	}
+	if (disk->zones.zoned && disk->zones.num_seq_required && (disk->burn_in.num_patterns || disk->fix)) {
+		ERROR("Sequential write required zones can't be rewritten in place, a burn-in or fix is not possible on this disk");
+		result = 1;
+		goto Exit;
+	}
+
+	if (provisioning_load(disk) != 0) {
+		result = 1;
+		goto Exit;
+	}
+
 	const uint64_t latency_stride = calc_latency_stride(disk);
 	VVERBOSE("latency stride is %"PRIu64, latency_stride);
 
@@ -740,6 +1771,16 @@ int disk_scan(disk_t *disk, enum scan_mode mode, unsigned data_size)
 	state.latency_count = 0;
 	state.latency = malloc(sizeof(uint32_t) * latency_stride);
 	state.data = data;
+	// The skip needs to know where the bad area ends, that is only meaningful when reading in order
+	state.read_size = data_size;
+	state.skip_bad_areas = disk->bad_areas.skip && mode == SCAN_MODE_SEQ && disk->burn_in.num_patterns == 0;
+	if (disk->bad_areas.skip && !state.skip_bad_areas)
+		INFO("Skipping bad areas is only done in a sequential read scan");
+	// A burn-in writes and then verifies every pattern
+	state.progress_total = disk->zones.zoned ? disk->zones.readable_sectors * disk->sector_size : disk->num_bytes;
+	state.progress_total *= disk->burn_in.num_patterns ? 2 * disk->burn_in.num_patterns : 1;
+	if (state.progress_total == 0)
+		state.progress_total = 1;
 
 	scan_order = calc_scan_order(disk, mode, latency_stride, data_size);
 	if (!scan_order) {
@@ -748,32 +1789,94 @@ int disk_scan(disk_t *disk, enum scan_mode mode, unsigned data_size)
 		goto Exit;
 	}
 
+	disk->early_conclusion = CONCLUSION_PASSED;
+	disk->stopped_early = false;
+	// The backfill of bad areas adds reads that can't be known in advance
+	if (!state.skip_bad_areas) {
+		state.verdict_reads = verdict_reads_bound(disk, latency_stride, scan_order, data_size);
+		state.verdict_over_bound = state.verdict_reads * (100.0 - disk->policy.latency_percentile) / 100.0 + 1e-9;
+	}
+
+	if (disk->fix && repair_start(disk) != 0) {
+		result = 1;
+		goto Exit;
+	}
+
+	if (fingerprint_scan_start(disk, data_size) != 0) {
+		result = 1;
+		goto Exit;
+	}
+
+	// Avoid page faults during the scan, only the current memory is locked
+	// as locking future allocations could fail them on a low RLIMIT_MEMLOCK
+	if (mlockall(MCL_CURRENT) == 0)
+		mem_locked = true;
+	else
+		VERBOSE("Failed to lock memory, errno=%d: %s", errno, strerror(errno));
+
+	if (disk->jitter_calibration_sec) {
+		jitter_calibrate(disk);
+		clock_gettime(CLOCK_MONOTONIC, &ts_start); // Calibration is not part of the scan time
+	}
+
 	verbose_extra_newline = 1;
-	for (offset = 0; disk->run && offset < disk_size_bytes; offset += latency_stride * disk->sector_size) {
-		VERBOSE("Scanning stride starting at %"PRIu64" done %"PRIu64"%%", offset, offset*100/disk_size_bytes);
-		progress_calc(disk, &state, 0);
-		latency_bucket_prepare(disk, &state, offset);
-		if (!disk_scan_latency_stride(disk, &state, offset, data_size, scan_order))
-			break;
-		latency_bucket_finish(disk, &state, offset + latency_stride * disk->sector_size);
+	if (disk->burn_in.num_patterns == 0) {
+		if (disk_scan_pass(disk, &state, data_size, scan_order) && state.skip_bad_areas)
+			disk_scan_backfill(disk, &state, data_size);
+	} else {
+		unsigned i;
+		for (i = 0; i < disk->burn_in.num_patterns; i++) {
+			char pattern_str[64];
 
-		if (disk->is_ata)
-			disk_ata_monitor(disk);
-		else
-			disk_scsi_monitor(disk);
+			state.pattern = &disk->burn_in.patterns[i];
+			pattern_to_str(state.pattern, pattern_str, sizeof(pattern_str));
+
+			INFO("Burn-in writing pattern %s", pattern_str);
+			state.write = true;
+			if (!disk_scan_pass(disk, &state, data_size, scan_order))
+				break;
+
+			INFO("Burn-in verifying pattern %s", pattern_str);
+			state.write = false;
+			if (!disk_scan_pass(disk, &state, data_size, scan_order))
+				break;
+
+			if (disk->early_conclusion != CONCLUSION_PASSED && disk->stop_early == STOP_EARLY_PASS &&
+			    i + 1 < disk->burn_in.num_patterns)
+			{
+				INFO("Stopping the burn-in early after the verify pass");
+				disk->stopped_early = true;
+				break;
+			}
+		}
+		if (disk->burn_in.miscompare_sectors)
+			ERROR("Burn-in found %"PRIu64" sectors that did not read back what was written", disk->burn_in.miscompare_sectors);
 	}
 	verbose_extra_newline = 0;
-
-	if (!disk->run) {
+	fingerprint_scan_end(disk, disk->run);
+	// Repairs may add grown defects, let them finish before the results are collected
+	repair_end(disk);
+
+	latency_percentiles_calc(disk);
+	if (disk->stopped_early) {
+		disk->conclusion = disk->early_conclusion;
+	} else if (!disk->run) {
 		INFO("Disk scan interrupted");
 		disk->conclusion = CONCLUSION_ABORTED;
 	} else {
 		disk->conclusion = conclusion_calc(disk);
 	}
+	throughput_analyze(disk);
+	grown_defects_finish(disk, latency_stride);
 	report_scan_done(disk);
 
 Exit:
+	repair_end(disk);
 	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	if (mem_locked)
+		munlockall();
+	if (cpu_pinned)
+		sched_setaffinity(0, sizeof(old_cpus), &old_cpus);
 	set_realtime(false);
 	free(scan_order);
 	free_buffer(data, data_size);
@@ -782,5 +1885,8 @@ Exit:
 	scan_time = time(NULL);
 	INFO("Scan ended at: %s", ctime(&scan_time));
 	INFO("Scan took %d second", (int)(ts_end.tv_sec - ts_start.tv_sec));
+	disk->profile.total_nsec = ts_diff_nsec(&ts_end, &ts_start);
+	scan_profile_finish(&disk->profile);
+	scan_profile_report(&disk->profile);
 	return result;
 }
@@ -0,0 +1,425 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Content fingerprints.
+ *
+ * A read that succeeds may still return data that changed behind our back. We
+ * keep a CRC32C per 1MB chunk of the disk in a file and compare it with the
+ * file from the previous scan, for a disk that was idle in between any change
+ * is silent corruption.
+ *
+ * The checksum runs in its own thread on the buffer of the previous read while
+ * the scan reads the next one into a second buffer, so it only slows the scan
+ * down if it can't keep up with the disk.
+ *
+ * The new fingerprints are written into a temporary file that is mapped into
+ * memory and renamed over the old file at the end of the scan. Chunks that
+ * weren't read in this scan keep their previous fingerprint.
+ */
+
+#include "fingerprint.h"
+#include "crc32c.h"
+#include "verbose.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct fingerprint_job {
+	uint64_t offset;
+	void *data;
+	uint32_t size;
+	bool ok;
+};
+
+struct fingerprint {
+	char *path;
+	char *tmp_path;
+	uint64_t num_chunks;
+	uint32_t sector_size;
+
+	/* Previous scan, NULL if there is none to compare with */
+	void *prev_map;
+	size_t prev_map_size;
+	const struct fingerprint_entry *prev;
+	int64_t prev_scan_time;
+
+	/* This scan */
+	void *map;
+	size_t map_size;
+	struct fingerprint_entry *cur;
+
+	/* Double buffering with the checksum thread */
+	pthread_t thread;
+	bool thread_running;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct fingerprint_job job;
+	bool job_pending;
+	bool stop;
+	void *spare;
+	void *own_buf;
+	uint32_t buf_size;
+};
+
+static size_t fingerprint_file_size(uint64_t num_chunks)
+{
+	return sizeof(struct fingerprint_hdr) + num_chunks * sizeof(struct fingerprint_entry);
+}
+
+static uint32_t chunk_sectors(const struct fingerprint *fp, const disk_t *disk, uint64_t chunk)
+{
+	uint64_t chunk_end = (chunk + 1) * FINGERPRINT_CHUNK_SIZE;
+
+	if (chunk_end > disk->num_bytes)
+		chunk_end = disk->num_bytes;
+	return (chunk_end - chunk * FINGERPRINT_CHUNK_SIZE) / fp->sector_size;
+}
+
+static void fingerprint_load_previous(disk_t *disk, struct fingerprint *fp)
+{
+	struct stat st;
+	int fd;
+
+	fd = open(fp->path, O_RDONLY);
+	if (fd < 0) {
+		if (errno != ENOENT)
+			ERROR("Failed to open previous fingerprint file %s, errno=%d: %s", fp->path, errno, strerror(errno));
+		return;
+	}
+
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size != fingerprint_file_size(fp->num_chunks)) {
+		INFO("Previous fingerprint file %s doesn't match this disk, not comparing", fp->path);
+		close(fd);
+		return;
+	}
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		ERROR("Failed to map previous fingerprint file %s, errno=%d: %s", fp->path, errno, strerror(errno));
+		return;
+	}
+
+	const struct fingerprint_hdr *hdr = map;
+	if (memcmp(hdr->magic, FINGERPRINT_MAGIC, sizeof(hdr->magic)) != 0 ||
+	    hdr->version != FINGERPRINT_VERSION ||
+	    hdr->chunk_size != FINGERPRINT_CHUNK_SIZE ||
+	    hdr->num_bytes != disk->num_bytes ||
+	    hdr->sector_size != disk->sector_size ||
+	    hdr->num_chunks != fp->num_chunks ||
+	    strncmp(hdr->serial, disk->serial, sizeof(hdr->serial)) != 0)
+	{
+		INFO("Previous fingerprint file %s is of a different disk, not comparing", fp->path);
+		munmap(map, st.st_size);
+		return;
+	}
+
+	fp->prev_map = map;
+	fp->prev_map_size = st.st_size;
+	fp->prev = (const struct fingerprint_entry *)(hdr + 1);
+	fp->prev_scan_time = hdr->scan_time;
+}
+
+int fingerprint_open(disk_t *disk, const char *path)
+{
+	struct fingerprint *fp;
+	int fd;
+
+	crc32c_init();
+
+	fp = calloc(1, sizeof(*fp));
+	if (fp == NULL)
+		return -1;
+
+	fp->sector_size = disk->sector_size;
+	fp->num_chunks = (disk->num_bytes + FINGERPRINT_CHUNK_SIZE - 1) / FINGERPRINT_CHUNK_SIZE;
+	fp->path = strdup(path);
+	if (fp->path == NULL || asprintf(&fp->tmp_path, "%s.tmp", path) < 0) {
+		fp->tmp_path = NULL;
+		goto Error;
+	}
+
+	fingerprint_load_previous(disk, fp);
+
+	fp->map_size = fingerprint_file_size(fp->num_chunks);
+	fd = open(fp->tmp_path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+	if (fd < 0) {
+		ERROR("Failed to create fingerprint file %s, errno=%d: %s", fp->tmp_path, errno, strerror(errno));
+		goto Error;
+	}
+	if (ftruncate(fd, fp->map_size) < 0) {
+		ERROR("Failed to size fingerprint file %s, errno=%d: %s", fp->tmp_path, errno, strerror(errno));
+		close(fd);
+		goto Error;
+	}
+	fp->map = mmap(NULL, fp->map_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (fp->map == MAP_FAILED) {
+		fp->map = NULL;
+		ERROR("Failed to map fingerprint file %s, errno=%d: %s", fp->tmp_path, errno, strerror(errno));
+		goto Error;
+	}
+	fp->cur = (struct fingerprint_entry *)((struct fingerprint_hdr *)fp->map + 1);
+
+	pthread_mutex_init(&fp->lock, NULL);
+	pthread_cond_init(&fp->cond, NULL);
+
+	disk->fingerprint = fp;
+	return 0;
+
+Error:
+	if (fp->tmp_path)
+		unlink(fp->tmp_path);
+	if (fp->prev_map)
+		munmap(fp->prev_map, fp->prev_map_size);
+	free(fp->tmp_path);
+	free(fp->path);
+	free(fp);
+	return -1;
+}
+
+static void fingerprint_job_run(struct fingerprint *fp, const struct fingerprint_job *job)
+{
+	const uint32_t sector_size = fp->sector_size;
+	uint64_t lba = job->offset / sector_size;
+	uint32_t done;
+
+	for (done = 0; done + sector_size <= job->size; done += sector_size, lba++) {
+		struct fingerprint_entry *e = &fp->cur[(job->offset + done) / FINGERPRINT_CHUNK_SIZE];
+
+		if (!job->ok) {
+			e->sectors = FINGERPRINT_SECTORS_ERROR;
+			continue;
+		}
+		if (e->sectors == FINGERPRINT_SECTORS_ERROR)
+			continue;
+
+		// Seeding with the LBA makes identical sectors at different places count differently
+		e->crc += crc32c((uint32_t)lba, (const char *)job->data + done, sector_size);
+		e->sectors++;
+	}
+}
+
+static void *fingerprint_thread(void *arg)
+{
+	struct fingerprint *fp = arg;
+
+	pthread_mutex_lock(&fp->lock);
+	while (1) {
+		while (!fp->job_pending && !fp->stop)
+			pthread_cond_wait(&fp->cond, &fp->lock);
+		if (!fp->job_pending)
+			break;
+
+		struct fingerprint_job job = fp->job;
+		pthread_mutex_unlock(&fp->lock);
+
+		fingerprint_job_run(fp, &job);
+
+		pthread_mutex_lock(&fp->lock);
+		fp->job_pending = false;
+		pthread_cond_broadcast(&fp->cond);
+	}
+	pthread_mutex_unlock(&fp->lock);
+
+	return NULL;
+}
+
+int fingerprint_scan_start(disk_t *disk, uint32_t buf_size)
+{
+	struct fingerprint *fp = disk->fingerprint;
+
+	if (fp == NULL)
+		return 0;
+
+	fp->own_buf = mmap(NULL, buf_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (fp->own_buf == MAP_FAILED) {
+		fp->own_buf = NULL;
+		ERROR("Failed to allocate fingerprint buffer, errno=%d: %s", errno, strerror(errno));
+		return -1;
+	}
+	fp->buf_size = buf_size;
+	fp->spare = fp->own_buf;
+
+	if (pthread_create(&fp->thread, NULL, fingerprint_thread, fp) != 0) {
+		ERROR("Failed to start the fingerprint thread");
+		return -1;
+	}
+	fp->thread_running = true;
+	return 0;
+}
+
+void *fingerprint_submit(disk_t *disk, uint64_t offset, void *data, uint32_t size, bool ok)
+{
+	struct fingerprint *fp = disk->fingerprint;
+	void *next;
+
+	if (fp == NULL || !fp->thread_running)
+		return data;
+
+	pthread_mutex_lock(&fp->lock);
+	while (fp->job_pending)
+		pthread_cond_wait(&fp->cond, &fp->lock);
+	fp->job.offset = offset;
+	fp->job.data = data;
+	fp->job.size = size;
+	fp->job.ok = ok;
+	fp->job_pending = true;
+	pthread_cond_broadcast(&fp->cond);
+	pthread_mutex_unlock(&fp->lock);
+
+	// The thread is done with the buffer of the previous job, it is free for the next read
+	next = fp->spare;
+	fp->spare = data;
+	return next;
+}
+
+static void fingerprint_compare(disk_t *disk, struct fingerprint *fp)
+{
+	fingerprint_report_t *r = &disk->fingerprint_report;
+	uint64_t chunk;
+
+	r->chunk_size = FINGERPRINT_CHUNK_SIZE;
+	r->compared = fp->prev != NULL;
+	r->previous_scan_time = fp->prev_scan_time;
+	if (r->compared && r->changed_offsets == NULL)
+		r->changed_offsets = calloc(FINGERPRINT_MAX_REPORTED, sizeof(uint64_t));
+
+	for (chunk = 0; chunk < fp->num_chunks; chunk++) {
+		struct fingerprint_entry *cur = &fp->cur[chunk];
+		const uint32_t sectors = chunk_sectors(fp, disk, chunk);
+
+		if (cur->sectors != sectors) {
+			// Not fully read in this scan, keep whatever we knew before
+			if (fp->prev)
+				*cur = fp->prev[chunk];
+			else
+				cur->sectors = FINGERPRINT_SECTORS_ERROR;
+			continue;
+		}
+
+		if (fp->prev == NULL || fp->prev[chunk].sectors != sectors)
+			continue;
+
+		r->num_compared++;
+		if (fp->prev[chunk].crc != cur->crc) {
+			if (r->num_changed < 10)
+				ERROR("Content changed since the previous scan in the chunk at offset %"PRIu64, chunk * FINGERPRINT_CHUNK_SIZE);
+			if (r->changed_offsets && r->changed_offsets_len < FINGERPRINT_MAX_REPORTED)
+				r->changed_offsets[r->changed_offsets_len++] = chunk * FINGERPRINT_CHUNK_SIZE;
+			r->num_changed++;
+		}
+	}
+
+	if (r->compared) {
+		time_t prev_time = fp->prev_scan_time;
+		char time_str[64];
+
+		strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", localtime(&prev_time));
+		if (r->num_changed)
+			ERROR("%"PRIu64" of %"PRIu64" compared chunks changed since the previous scan at %s", r->num_changed, r->num_compared, time_str);
+		else
+			INFO("All %"PRIu64" compared chunks are unchanged since the previous scan at %s", r->num_compared, time_str);
+	}
+}
+
+void fingerprint_scan_end(disk_t *disk, bool complete)
+{
+	struct fingerprint *fp = disk->fingerprint;
+
+	if (fp == NULL || fp->map == NULL)
+		return;
+
+	if (fp->thread_running) {
+		pthread_mutex_lock(&fp->lock);
+		fp->stop = true;
+		pthread_cond_broadcast(&fp->cond);
+		pthread_mutex_unlock(&fp->lock);
+		pthread_join(fp->thread, NULL);
+		fp->thread_running = false;
+	}
+
+	fingerprint_compare(disk, fp);
+
+	struct fingerprint_hdr *hdr = fp->map;
+	memcpy(hdr->magic, FINGERPRINT_MAGIC, sizeof(hdr->magic));
+	hdr->version = FINGERPRINT_VERSION;
+	hdr->chunk_size = FINGERPRINT_CHUNK_SIZE;
+	hdr->num_bytes = disk->num_bytes;
+	hdr->sector_size = disk->sector_size;
+	hdr->num_chunks = fp->num_chunks;
+	hdr->scan_time = complete || fp->prev == NULL ? time(NULL) : fp->prev_scan_time;
+	strncpy(hdr->serial, disk->serial, sizeof(hdr->serial));
+	strncpy(hdr->model, disk->model, sizeof(hdr->model));
+
+	if (msync(fp->map, fp->map_size, MS_SYNC) < 0 || rename(fp->tmp_path, fp->path) < 0) {
+		ERROR("Failed to save fingerprint file %s, errno=%d: %s", fp->path, errno, strerror(errno));
+	} else {
+		disk->fingerprint_report.valid = true;
+		VERBOSE("Saved fingerprints to %s", fp->path);
+	}
+
+	munmap(fp->map, fp->map_size);
+	fp->map = NULL;
+}
+
+void fingerprint_free(disk_t *disk)
+{
+	struct fingerprint *fp = disk->fingerprint;
+
+	free(disk->fingerprint_report.changed_offsets);
+	disk->fingerprint_report.changed_offsets = NULL;
+
+	if (fp == NULL)
+		return;
+
+	if (fp->thread_running) {
+		pthread_mutex_lock(&fp->lock);
+		fp->stop = true;
+		pthread_cond_broadcast(&fp->cond);
+		pthread_mutex_unlock(&fp->lock);
+		pthread_join(fp->thread, NULL);
+	}
+
+	if (fp->map) {
+		// The scan never finished, don't leave a partial file around
+		munmap(fp->map, fp->map_size);
+		unlink(fp->tmp_path);
+	}
+	if (fp->prev_map)
+		munmap(fp->prev_map, fp->prev_map_size);
+	if (fp->own_buf)
+		munmap(fp->own_buf, fp->buf_size);
+	pthread_cond_destroy(&fp->cond);
+	pthread_mutex_destroy(&fp->lock);
+	free(fp->tmp_path);
+	free(fp->path);
+	free(fp);
+	disk->fingerprint = NULL;
+}
@@ -0,0 +1,55 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_FINGERPRINT_H
+#define DISKSCAN_FINGERPRINT_H
+
+#include "diskscan.h"
+
+#define FINGERPRINT_MAGIC "DSCANFP1"
+#define FINGERPRINT_VERSION 1
+/* Fixed so fingerprints compare across scans with different transfer sizes and orders */
+#define FINGERPRINT_CHUNK_SIZE (1024*1024)
+
+struct fingerprint_hdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t chunk_size;
+	uint64_t num_bytes;
+	uint64_t sector_size;
+	uint64_t num_chunks;
+	int64_t scan_time;
+	char serial[64];
+	char model[64];
+};
+
+struct fingerprint_entry {
+	uint32_t crc;     /* Sum of the CRC32C of every sector, so the sectors can be added in any order */
+	uint32_t sectors; /* Sectors added, the entry is complete when the whole chunk was read */
+};
+#define FINGERPRINT_SECTORS_ERROR UINT32_MAX
+
+int fingerprint_scan_start(disk_t *disk, uint32_t buf_size);
+/* Hands the buffer to the checksum thread and returns the buffer to use for the next read */
+void *fingerprint_submit(disk_t *disk, uint64_t offset, void *data, uint32_t size, bool ok);
+void fingerprint_scan_end(disk_t *disk, bool complete);
+void fingerprint_free(disk_t *disk);
+
+#endif
@@ -0,0 +1,452 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Live scan metrics in the Prometheus text exposition format.
+ *
+ * The scan thread keeps plain counters and once a second copies them, along
+ * with the latency histogram, into a snapshot. A publisher thread serves the
+ * snapshot to anyone connecting to a unix socket and/or rewrites a
+ * node_exporter textfile. The scan thread only ever tries to take the
+ * snapshot lock so a slow scrape can never stall the scan.
+ */
+
+#include "metrics.h"
+#include "verbose.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#define METRICS_TEXTFILE_INTERVAL_MSEC (10*1000)
+#define METRICS_CLIENT_WAIT_MSEC 100
+
+static const char *error_class_name(enum result_error_e err)
+{
+	switch (err) {
+		case ERROR_NONE: return "none";
+		case ERROR_CORRECTED: return "corrected";
+		case ERROR_UNCORRECTED: return "uncorrected";
+		case ERROR_NEED_RETRY: return "need_retry";
+		case ERROR_FATAL: return "fatal";
+		case ERROR_UNKNOWN: return "unknown";
+	}
+
+	return "unknown";
+}
+
+static uint64_t monotonic_msec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void text_add(struct metrics *m, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+static void text_add(struct metrics *m, const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	while (1) {
+		va_start(ap, fmt);
+		len = vsnprintf(m->text + m->text_len, m->text_size - m->text_len, fmt, ap);
+		va_end(ap);
+
+		if (len < 0)
+			return;
+		if (m->text_len + len < m->text_size)
+			break;
+
+		char *text = realloc(m->text, m->text_size * 2);
+		if (text == NULL) {
+			m->text[m->text_len] = 0;
+			return;
+		}
+		m->text = text;
+		m->text_size *= 2;
+	}
+
+	m->text_len += len;
+}
+
+static void metric_header(struct metrics *m, const char *name, const char *type, const char *help)
+{
+	text_add(m, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/* Must be called with the snapshot lock held */
+static void metrics_format(struct metrics *m)
+{
+	static const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+	int64_t values[ARRAY_SIZE(percentiles)];
+	const struct metrics_snapshot *s = &m->snap;
+	unsigned i;
+
+	m->text_len = 0;
+	m->text[0] = 0;
+
+	metric_header(m, "diskscan_scan_running", "gauge", "Whether the scan is still in progress");
+	text_add(m, "diskscan_scan_running{%s} %d\n", m->labels, s->running ? 1 : 0);
+
+	metric_header(m, "diskscan_scanned_bytes_total", "counter", "Bytes read by the scan so far");
+	text_add(m, "diskscan_scanned_bytes_total{%s} %"PRIu64"\n", m->labels, s->bytes_scanned);
+
+	metric_header(m, "diskscan_io_total", "counter", "Number of I/Os issued by the scan");
+	text_add(m, "diskscan_io_total{%s} %"PRIu64"\n", m->labels, s->num_io);
+
+	metric_header(m, "diskscan_io_errors_total", "counter", "Number of I/Os that returned an error, by error class");
+	for (i = ERROR_CORRECTED; i <= ERROR_UNKNOWN; i++)
+		text_add(m, "diskscan_io_errors_total{%s,class=\"%s\"} %"PRIu64"\n", m->labels, error_class_name(i), s->num_errors[i]);
+
+	metric_header(m, "diskscan_throughput_bytes_per_second", "gauge", "Scan throughput over the last second");
+	text_add(m, "diskscan_throughput_bytes_per_second{%s} %"PRIu64"\n", m->labels, s->throughput);
+
+	metric_header(m, "diskscan_latency_bucket", "gauge", "Index of the latency graph bucket currently being scanned");
+	text_add(m, "diskscan_latency_bucket{%s} %u\n", m->labels, s->latency_bucket);
+
+	metric_header(m, "diskscan_latency_microseconds", "summary", "I/O latency as recorded in the scan histogram");
+	hdr_value_at_percentiles(s->histogram, percentiles, values, ARRAY_SIZE(percentiles));
+	for (i = 0; i < ARRAY_SIZE(percentiles); i++)
+		text_add(m, "diskscan_latency_microseconds{%s,quantile=\"%g\"} %"PRId64"\n", m->labels, percentiles[i] / 100.0, values[i]);
+	text_add(m, "diskscan_latency_microseconds{%s,quantile=\"1\"} %"PRId64"\n", m->labels, hdr_max(s->histogram));
+	text_add(m, "diskscan_latency_microseconds_sum{%s} %.0f\n", m->labels, hdr_mean(s->histogram) * s->histogram->total_count);
+	text_add(m, "diskscan_latency_microseconds_count{%s} %"PRId64"\n", m->labels, s->histogram->total_count);
+
+	if (s->temperature > 0) {
+		metric_header(m, "diskscan_temperature_celsius", "gauge", "Latest disk temperature reported by the disk");
+		text_add(m, "diskscan_temperature_celsius{%s} %d\n", m->labels, s->temperature);
+	}
+}
+
+static bool send_all(int fd, const char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t ret = send(fd, buf, len, MSG_NOSIGNAL);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		buf += ret;
+		len -= ret;
+	}
+	return true;
+}
+
+static void metrics_serve_client(struct metrics *m, int fd)
+{
+	struct pollfd pfd = {.fd = fd, .events = POLLIN};
+	bool is_http = false;
+	char req[512];
+
+	// Plain readers (socat, nc) just get the text, HTTP clients (curl --unix-socket) send a request first
+	if (poll(&pfd, 1, METRICS_CLIENT_WAIT_MSEC) == 1) {
+		ssize_t len = recv(fd, req, sizeof(req) - 1, MSG_DONTWAIT);
+		if (len > 0) {
+			req[len] = 0;
+			is_http = strncmp(req, "GET ", 4) == 0;
+		}
+	}
+
+	pthread_mutex_lock(&m->lock);
+	metrics_format(m);
+	pthread_mutex_unlock(&m->lock);
+
+	if (is_http) {
+		char hdr[256];
+		int hdr_len = snprintf(hdr, sizeof(hdr), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n", m->text_len);
+		if (!send_all(fd, hdr, hdr_len))
+			return;
+	}
+
+	send_all(fd, m->text, m->text_len);
+}
+
+static void metrics_write_textfile(struct metrics *m)
+{
+	char tmp_path[4096];
+	int fd;
+
+	// node_exporter may read the file at any time, write a temp file and atomically rename it into place
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", m->textfile_path);
+	fd = open(tmp_path, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+	if (fd < 0) {
+		ERROR("Failed to open metrics file %s, errno=%d: %s", tmp_path, errno, strerror(errno));
+		return;
+	}
+
+	pthread_mutex_lock(&m->lock);
+	metrics_format(m);
+	pthread_mutex_unlock(&m->lock);
+
+	ssize_t ret = write(fd, m->text, m->text_len);
+	close(fd);
+
+	if (ret != (ssize_t)m->text_len || rename(tmp_path, m->textfile_path) < 0) {
+		ERROR("Failed to write metrics file %s, errno=%d: %s", m->textfile_path, errno, strerror(errno));
+		unlink(tmp_path);
+	}
+}
+
+static void *metrics_thread(void *arg)
+{
+	struct metrics *m = arg;
+	struct pollfd pfd[2];
+	uint64_t next_textfile = monotonic_msec() + METRICS_TEXTFILE_INTERVAL_MSEC;
+
+	pfd[0].fd = m->stop_fd[0];
+	pfd[0].events = POLLIN;
+	pfd[1].fd = m->listen_fd; // poll ignores a negative fd when there is no socket
+	pfd[1].events = POLLIN;
+
+	while (1) {
+		int timeout = -1;
+
+		if (m->textfile_path) {
+			const uint64_t now = monotonic_msec();
+			timeout = next_textfile > now ? (int)(next_textfile - now) : 0;
+		}
+
+		int ret = poll(pfd, 2, timeout);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			ERROR("Metrics publisher failed to poll, errno=%d: %s", errno, strerror(errno));
+			break;
+		}
+
+		if (pfd[0].revents)
+			break;
+
+		if (pfd[1].revents & POLLIN) {
+			int fd = accept(m->listen_fd, NULL, NULL);
+			if (fd >= 0) {
+				metrics_serve_client(m, fd);
+				close(fd);
+			}
+		}
+
+		if (m->textfile_path && monotonic_msec() >= next_textfile) {
+			metrics_write_textfile(m);
+			next_textfile = monotonic_msec() + METRICS_TEXTFILE_INTERVAL_MSEC;
+		}
+	}
+
+	return NULL;
+}
+
+static int metrics_listen(struct metrics *m, const char *path)
+{
+	struct sockaddr_un addr;
+	struct stat st;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		ERROR("Metrics socket path %s is too long", path);
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	m->listen_fd = socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0);
+	if (m->listen_fd < 0) {
+		ERROR("Failed to create metrics socket, errno=%d: %s", errno, strerror(errno));
+		return -1;
+	}
+
+	// A socket left behind by a previous run would make the bind fail, anything else is not ours to remove
+	if (lstat(path, &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			ERROR("Metrics socket path %s exists and is not a socket", path);
+			return -1;
+		}
+		unlink(path);
+	}
+
+	if (bind(m->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(m->listen_fd, 4) < 0) {
+		ERROR("Failed to listen on metrics socket %s, errno=%d: %s", path, errno, strerror(errno));
+		return -1;
+	}
+
+	m->socket_path = strdup(path);
+	return 0;
+}
+
+static void labels_escape(char *out, size_t out_len, const char *in)
+{
+	size_t i = 0;
+
+	for (; *in && i + 2 < out_len; in++) {
+		if (*in == '"' || *in == '\\' || *in == '\n')
+			out[i++] = '\\';
+		out[i++] = *in == '\n' ? 'n' : *in;
+	}
+	out[i] = 0;
+}
+
+static void metrics_free(struct metrics *m)
+{
+	if (m->listen_fd >= 0)
+		close(m->listen_fd);
+	if (m->socket_path) {
+		unlink(m->socket_path);
+		free(m->socket_path);
+	}
+	if (m->stop_fd[0] >= 0) {
+		close(m->stop_fd[0]);
+		close(m->stop_fd[1]);
+	}
+	pthread_mutex_destroy(&m->lock);
+	free(m->textfile_path);
+	free(m->snap.histogram);
+	free(m->text);
+	free(m);
+}
+
+void metrics_publish(disk_t *disk, unsigned latency_bucket, uint64_t now_nsec, bool force)
+{
+	struct metrics *m = disk->metrics;
+	struct metrics_snapshot *s = &m->snap;
+
+	if (force)
+		pthread_mutex_lock(&m->lock);
+	else if (pthread_mutex_trylock(&m->lock) != 0)
+		return; // A scrape is formatting the snapshot, try again on the next I/O
+
+	s->bytes_scanned = m->bytes_scanned;
+	s->num_io = m->num_io;
+	memcpy(s->num_errors, m->num_errors, sizeof(s->num_errors));
+	if (m->last_publish_nsec && now_nsec > m->last_publish_nsec)
+		s->throughput = (m->bytes_scanned - m->last_publish_bytes) * 1e9 / (now_nsec - m->last_publish_nsec);
+	s->latency_bucket = latency_bucket;
+	s->temperature = disk->is_ata ? disk->state.ata.last_temp : disk->state.scsi.last_temp;
+	s->running = disk->run;
+	memcpy(s->histogram, disk->histogram, hdr_get_memory_size(disk->histogram));
+
+	pthread_mutex_unlock(&m->lock);
+
+	m->last_publish_nsec = now_nsec;
+	m->last_publish_bytes = m->bytes_scanned;
+	m->next_publish_nsec = now_nsec + METRICS_PUBLISH_NSEC;
+}
+
+int metrics_start(disk_t *disk, const char *socket_path, const char *textfile_path)
+{
+	struct metrics *m;
+	char disk_label[192];
+	char serial_label[64];
+	sigset_t all_signals;
+	sigset_t old_signals;
+	struct timespec now;
+
+	m = calloc(1, sizeof(*m));
+	if (m == NULL) {
+		ERROR("Failed to allocate memory for metrics");
+		return -1;
+	}
+	m->listen_fd = -1;
+	m->stop_fd[0] = m->stop_fd[1] = -1;
+	pthread_mutex_init(&m->lock, NULL);
+
+	m->text_size = 8192;
+	m->text = malloc(m->text_size);
+	// The snapshot histogram is a bitwise copy of the scan histogram so it must match in size
+	m->snap.histogram = malloc(hdr_get_memory_size(disk->histogram));
+	if (m->text == NULL || m->snap.histogram == NULL) {
+		ERROR("Failed to allocate memory for metrics");
+		goto Error;
+	}
+
+	labels_escape(disk_label, sizeof(disk_label), disk->path);
+	labels_escape(serial_label, sizeof(serial_label), disk->serial);
+	snprintf(m->labels, sizeof(m->labels), "disk=\"%s\",serial=\"%s\"", disk_label, serial_label);
+
+	if (socket_path && metrics_listen(m, socket_path) < 0)
+		goto Error;
+
+	if (textfile_path)
+		m->textfile_path = strdup(textfile_path);
+
+	if (pipe2(m->stop_fd, O_CLOEXEC) < 0) {
+		ERROR("Failed to create metrics pipe, errno=%d: %s", errno, strerror(errno));
+		goto Error;
+	}
+
+	disk->metrics = m;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	metrics_publish(disk, 0, (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec, true);
+
+	// Signals should keep going to the main thread that knows to stop the scan
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_BLOCK, &all_signals, &old_signals);
+	int ret = pthread_create(&m->thread, NULL, metrics_thread, m);
+	pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+	if (ret != 0) {
+		ERROR("Failed to start metrics publisher thread, error=%d: %s", ret, strerror(ret));
+		disk->metrics = NULL;
+		goto Error;
+	}
+
+	if (socket_path)
+		INFO("Publishing metrics on unix socket %s", socket_path);
+	if (textfile_path)
+		INFO("Publishing metrics to file %s", textfile_path);
+	return 0;
+
+Error:
+	metrics_free(m);
+	return -1;
+}
+
+void metrics_end(disk_t *disk)
+{
+	struct metrics *m = disk->metrics;
+	struct timespec now;
+	char c = 0;
+
+	if (m == NULL)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	metrics_publish(disk, m->snap.latency_bucket, (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec, true);
+
+	if (write(m->stop_fd[1], &c, 1) != 1)
+		ERROR("Failed to stop metrics publisher thread, errno=%d: %s", errno, strerror(errno));
+	else
+		pthread_join(m->thread, NULL);
+
+	// Leave the final state for the textfile collector
+	if (m->textfile_path)
+		metrics_write_textfile(m);
+
+	disk->metrics = NULL;
+	metrics_free(m);
+}
@@ -0,0 +1,97 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_METRICS_H
+#define DISKSCAN_METRICS_H
+
+#include "diskscan.h"
+
+#include <pthread.h>
+#include <time.h>
+
+/* How often the scan thread refreshes the snapshot seen by the scrapers */
+#define METRICS_PUBLISH_NSEC (1000ULL*1000*1000)
+
+struct metrics_snapshot {
+	uint64_t bytes_scanned;
+	uint64_t num_io;
+	uint64_t num_errors[ERROR_UNKNOWN+1];
+	uint64_t throughput; /* bytes per second over the last publish interval */
+	unsigned latency_bucket;
+	int temperature;
+	bool running;
+	struct hdr_histogram *histogram;
+};
+
+struct metrics {
+	/* Owned by the scan thread, never touched by the publisher thread */
+	uint64_t bytes_scanned;
+	uint64_t num_io;
+	uint64_t num_errors[ERROR_UNKNOWN+1];
+	uint64_t next_publish_nsec;
+	uint64_t last_publish_nsec;
+	uint64_t last_publish_bytes;
+
+	/* Shared with the publisher thread, protected by lock */
+	pthread_mutex_t lock;
+	struct metrics_snapshot snap;
+
+	/* Owned by the publisher thread */
+	pthread_t thread;
+	int listen_fd;
+	int stop_fd[2];
+	char *socket_path;
+	char *textfile_path;
+	char labels[320];
+	char *text;
+	size_t text_size;
+	size_t text_len;
+};
+
+void metrics_publish(disk_t *disk, unsigned latency_bucket, uint64_t now_nsec, bool force);
+
+static inline void metrics_io(disk_t *disk, uint32_t bytes, enum result_error_e error)
+{
+	struct metrics *m = disk->metrics;
+
+	if (m == NULL)
+		return;
+
+	m->bytes_scanned += bytes;
+	m->num_io++;
+	m->num_errors[error]++;
+}
+
+/* Cheap enough to call after every I/O, the snapshot is only refreshed once per METRICS_PUBLISH_NSEC */
+static inline void metrics_update(disk_t *disk, unsigned latency_bucket, const struct timespec *now)
+{
+	struct metrics *m = disk->metrics;
+
+	if (m == NULL)
+		return;
+
+	const uint64_t now_nsec = (uint64_t)now->tv_sec * 1000000000 + now->tv_nsec;
+	if (now_nsec < m->next_publish_nsec)
+		return;
+
+	metrics_publish(disk, latency_bucket, now_nsec, false);
+}
+
+#endif
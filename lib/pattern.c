@@ -0,0 +1,170 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Burn-in data patterns.
+ *
+ * Every pattern is a pure function of the LBA, so the verify pass regenerates
+ * the expected data on the fly and compares it in the same loop instead of
+ * keeping a copy. The loops use the GCC vector extensions at the 128-bit
+ * width every target has (SSE2 on x86-64, NEON on arm64), the compiler
+ * unrolls and widens them further when built for a newer instruction set.
+ *
+ * The random pattern is splitmix64 indexed by the 64-bit word position on the
+ * disk, so any part of it can be generated without generating what comes
+ * before it.
+ */
+
+#include "pattern.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>
+#include <time.h>
+
+typedef uint64_t v2u64 __attribute__((vector_size(PATTERN_ALIGN)));
+
+#define WORDS_PER_VEC (sizeof(v2u64) / sizeof(uint64_t))
+#define SPLITMIX_GAMMA 0x9E3779B97F4A7C15ULL
+
+static inline v2u64 splitmix64_mix(v2u64 z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static inline v2u64 vec_splat(uint64_t val)
+{
+	v2u64 v = {val, val};
+	return v;
+}
+
+/* The splitmix64 state of the first words in the sector, the state advances by a gamma per word */
+static inline v2u64 random_state(const pattern_t *pattern, uint64_t lba, unsigned sector_size)
+{
+	const uint64_t word = lba * (sector_size / sizeof(uint64_t));
+	v2u64 idx = {word, word + 1};
+	return vec_splat(pattern->value) + idx * SPLITMIX_GAMMA;
+}
+
+static inline v2u64 fixed_vec(const pattern_t *pattern, uint64_t lba)
+{
+	if (pattern->type == PATTERN_LBA)
+		return vec_splat(lba);
+	return vec_splat(pattern->value * 0x0101010101010101ULL);
+}
+
+void pattern_fill(const pattern_t *pattern, void *buf, uint64_t lba, unsigned num_sectors, unsigned sector_size)
+{
+	const unsigned vecs_per_sector = sector_size / sizeof(v2u64);
+	v2u64 *out = buf;
+	unsigned s, i;
+
+	for (s = 0; s < num_sectors; s++, lba++) {
+		if (pattern->type == PATTERN_RANDOM) {
+			const v2u64 step = vec_splat(WORDS_PER_VEC * SPLITMIX_GAMMA);
+			v2u64 state = random_state(pattern, lba, sector_size);
+
+			for (i = 0; i < vecs_per_sector; i++, state += step)
+				*out++ = splitmix64_mix(state);
+		} else {
+			const v2u64 val = fixed_vec(pattern, lba);
+
+			for (i = 0; i < vecs_per_sector; i++)
+				*out++ = val;
+		}
+	}
+}
+
+unsigned pattern_verify(const pattern_t *pattern, const void *buf, uint64_t lba, unsigned num_sectors, unsigned sector_size, uint64_t *first_bad_lba)
+{
+	const unsigned vecs_per_sector = sector_size / sizeof(v2u64);
+	const v2u64 *in = buf;
+	unsigned num_bad = 0;
+	unsigned s, i;
+
+	for (s = 0; s < num_sectors; s++, lba++) {
+		v2u64 diff = vec_splat(0);
+
+		// Accumulate the differences and check once per sector to keep the inner loop branch free
+		if (pattern->type == PATTERN_RANDOM) {
+			const v2u64 step = vec_splat(WORDS_PER_VEC * SPLITMIX_GAMMA);
+			v2u64 state = random_state(pattern, lba, sector_size);
+
+			for (i = 0; i < vecs_per_sector; i++, state += step)
+				diff |= *in++ ^ splitmix64_mix(state);
+		} else {
+			const v2u64 val = fixed_vec(pattern, lba);
+
+			for (i = 0; i < vecs_per_sector; i++)
+				diff |= *in++ ^ val;
+		}
+
+		if ((diff[0] | diff[1]) != 0) {
+			if (num_bad == 0)
+				*first_bad_lba = lba;
+			num_bad++;
+		}
+	}
+
+	return num_bad;
+}
+
+int str_to_pattern(const char *s, pattern_t *pattern)
+{
+	char *endptr;
+
+	memset(pattern, 0, sizeof(*pattern));
+
+	if (strcasecmp(s, "lba") == 0) {
+		pattern->type = PATTERN_LBA;
+		return 0;
+	}
+
+	if (strncasecmp(s, "random", 6) == 0) {
+		pattern->type = PATTERN_RANDOM;
+		if (s[6] == 0) {
+			pattern->value = (uint64_t)time(NULL) * SPLITMIX_GAMMA;
+			return 0;
+		}
+		if (s[6] != ':' || s[7] == 0)
+			return -1;
+		pattern->value = strtoull(s + 7, &endptr, 0);
+		return *endptr == 0 ? 0 : -1;
+	}
+
+	pattern->type = PATTERN_CONSTANT;
+	pattern->value = strtoul(s, &endptr, 0);
+	if (*s == 0 || *endptr != 0 || pattern->value > 0xFF)
+		return -1;
+	return 0;
+}
+
+const char *pattern_to_str(const pattern_t *pattern, char *buf, unsigned buf_len)
+{
+	switch (pattern->type) {
+		case PATTERN_CONSTANT: snprintf(buf, buf_len, "0x%02"PRIX64, pattern->value); break;
+		case PATTERN_LBA: snprintf(buf, buf_len, "lba"); break;
+		case PATTERN_RANDOM: snprintf(buf, buf_len, "random:0x%"PRIX64, pattern->value); break;
+	}
+	return buf;
+}
@@ -0,0 +1,33 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_PATTERN_H
+#define DISKSCAN_PATTERN_H
+
+#include "diskscan.h"
+
+/* Buffers must be aligned to PATTERN_ALIGN and the sector size a multiple of it */
+#define PATTERN_ALIGN 16
+
+void pattern_fill(const pattern_t *pattern, void *buf, uint64_t lba, unsigned num_sectors, unsigned sector_size);
+/* Returns the number of sectors that don't match the pattern, the first one is returned in first_bad_lba */
+unsigned pattern_verify(const pattern_t *pattern, const void *buf, uint64_t lba, unsigned num_sectors, unsigned sector_size, uint64_t *first_bad_lba);
+
+#endif
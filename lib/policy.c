@@ -0,0 +1,177 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Verdict policy file.
+ *
+ * An INI style file where every section is a shell pattern matched against the
+ * "vendor model" string of the disk, or the model alone. Settings before the
+ * first section apply to all disks, then every matching section is applied in
+ * the order of the file so a later and more specific section overrides an
+ * earlier one:
+ *
+ *   max_io_errors = 0
+ *
+ *   [ST4000*]
+ *   max_latency_msec = 5000
+ *   latency_percentile = 99.9
+ *   percentile_latency_msec = 3000
+ */
+
+#include "policy.h"
+#include "verbose.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <inttypes.h>
+
+void policy_defaults(verdict_policy_t *policy)
+{
+	policy->max_latency_msec = 10000;
+	policy->latency_percentile = 99.99;
+	policy->percentile_latency_msec = 8000;
+	policy->max_io_errors = 0;
+	policy->max_miscompare_sectors = 0;
+}
+
+static char *strip(char *s)
+{
+	char *end;
+
+	while (isspace((unsigned char)*s))
+		s++;
+	end = s + strlen(s);
+	while (end > s && isspace((unsigned char)end[-1]))
+		end--;
+	*end = 0;
+	return s;
+}
+
+static int parse_u64(const char *s, uint64_t *val)
+{
+	char *end;
+
+	errno = 0;
+	unsigned long long v = strtoull(s, &end, 0);
+	if (errno || end == s || *end || s[0] == '-')
+		return -1;
+	*val = v;
+	return 0;
+}
+
+static int policy_set(verdict_policy_t *policy, const char *key, const char *value)
+{
+	uint64_t val;
+
+	if (strcmp(key, "latency_percentile") == 0) {
+		char *end;
+		double pct = strtod(value, &end);
+		if (end == value || *end || pct <= 0.0 || pct >= 100.0)
+			return -1;
+		policy->latency_percentile = pct;
+		return 0;
+	}
+
+	if (parse_u64(value, &val))
+		return -1;
+
+	if (strcmp(key, "max_latency_msec") == 0 && val <= UINT32_MAX)
+		policy->max_latency_msec = val;
+	else if (strcmp(key, "percentile_latency_msec") == 0 && val <= UINT32_MAX)
+		policy->percentile_latency_msec = val;
+	else if (strcmp(key, "max_io_errors") == 0)
+		policy->max_io_errors = val;
+	else if (strcmp(key, "max_miscompare_sectors") == 0)
+		policy->max_miscompare_sectors = val;
+	else
+		return -1;
+	return 0;
+}
+
+int policy_load(disk_t *disk, const char *path)
+{
+	char full_model[160];
+	char line[POLICY_LINE_MAX];
+	bool match = true;
+	unsigned line_num = 0;
+	int ret = 0;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (f == NULL) {
+		ERROR("Failed to open policy file %s, errno=%d: %s", path, errno, strerror(errno));
+		return -1;
+	}
+
+	snprintf(full_model, sizeof(full_model), "%s%s%s", disk->vendor, disk->model[0] && disk->vendor[0] ? " " : "", disk->model);
+
+	while (fgets(line, sizeof(line), f)) {
+		char *s = strip(line);
+		line_num++;
+
+		if (*s == 0 || *s == '#' || *s == ';')
+			continue;
+
+		if (*s == '[') {
+			char *end = strchr(s, ']');
+			if (end == NULL || end[1]) {
+				ERROR("Policy file %s line %u: malformed section", path, line_num);
+				ret = -1;
+				break;
+			}
+			*end = 0;
+			s = strip(s + 1);
+			match = fnmatch(s, full_model, 0) == 0 || fnmatch(s, disk->model, 0) == 0;
+			if (match)
+				VERBOSE("Policy section [%s] matches the disk", s);
+			continue;
+		}
+
+		char *eq = strchr(s, '=');
+		if (eq == NULL) {
+			ERROR("Policy file %s line %u: expected key = value", path, line_num);
+			ret = -1;
+			break;
+		}
+		*eq = 0;
+		char *key = strip(s);
+		char *value = strip(eq + 1);
+
+		// Validate settings of sections that don't match too, a typo shouldn't wait for the right disk
+		verdict_policy_t scratch = disk->policy;
+		if (policy_set(match ? &disk->policy : &scratch, key, value)) {
+			ERROR("Policy file %s line %u: invalid setting %s = %s", path, line_num, key, value);
+			ret = -1;
+			break;
+		}
+	}
+
+	fclose(f);
+
+	if (ret == 0) {
+		const verdict_policy_t *p = &disk->policy;
+		INFO("Verdict policy: max latency %u msec, %g%% latency %u msec, max io errors %"PRIu64", max miscompare sectors %"PRIu64,
+				p->max_latency_msec, p->latency_percentile, p->percentile_latency_msec, p->max_io_errors, p->max_miscompare_sectors);
+	}
+	return ret;
+}
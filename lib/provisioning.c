@@ -0,0 +1,191 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+/* Thin provisioning.
+ *
+ * On a thin LUN or an SSD the unmapped extents are answered by the controller
+ * without touching the media, reading them measures nothing about the disk.
+ * The mapped extents are loaded at the start of the scan and reads that fall
+ * entirely in unmapped extents are skipped, a percentage of them can still be
+ * sampled to keep an eye on the controller.
+ */
+
+#include "provisioning.h"
+#include "disk.h"
+#include "verbose.h"
+#include "libscsicmd/include/parse_get_lba_status.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static int provisioning_add_mapped(provisioning_t *p, unsigned *size, uint64_t start, uint64_t len)
+{
+	if (p->len && p->mapped[p->len-1].start_sector + p->mapped[p->len-1].len_sectors == start) {
+		p->mapped[p->len-1].len_sectors += len;
+		p->mapped_sectors += len;
+		return 0;
+	}
+
+	if (p->len == *size) {
+		unsigned new_size = *size ? *size * 2 : 1024;
+		lba_extent_t *mapped = realloc(p->mapped, new_size * sizeof(lba_extent_t));
+		if (mapped == NULL)
+			return -1;
+		p->mapped = mapped;
+		*size = new_size;
+	}
+
+	p->mapped[p->len].start_sector = start;
+	p->mapped[p->len].len_sectors = len;
+	p->len++;
+	p->mapped_sectors += len;
+	return 0;
+}
+
+/* Returns -1 only on a failure, a disk that can't report its mapping is scanned whole */
+int provisioning_load(disk_t *disk)
+{
+	provisioning_t *p = &disk->provisioning;
+	const uint64_t num_sectors = disk->num_bytes / disk->sector_size;
+	unsigned size = 0;
+	uint64_t lba = 0;
+
+	if (!p->mapped_only)
+		return 0;
+
+	provisioning_free(disk);
+	if (!disk->thin_provisioned) {
+		INFO("Disk is not thin provisioned, scanning all of it");
+		return 0;
+	}
+
+	unsigned char *buf = malloc(PROVISIONING_STATUS_BUF_SIZE);
+	if (buf == NULL) {
+		ERROR("Failed to allocate memory for the LBA status");
+		return -1;
+	}
+
+	while (lba < num_sectors) {
+		uint8_t *desc;
+		unsigned idx;
+		uint64_t next_lba = lba;
+		int len = disk_get_lba_status(&disk->dev, lba, buf, PROVISIONING_STATUS_BUF_SIZE);
+
+		if (len < 0 && lba == 0) {
+			INFO("Disk doesn't report the LBA status, scanning all of it");
+			free(buf);
+			return 0;
+		}
+		if (len < 0) {
+			ERROR("Failed to get the LBA status from LBA %"PRIu64, lba);
+			goto Error;
+		}
+
+		for_all_get_lba_status_descs(buf, len, desc, idx) {
+			uint64_t start = lba_status_desc_start_lba(desc);
+			uint64_t end = start + lba_status_desc_num_blocks(desc);
+
+			// The first extent holds the start LBA and may begin before it
+			if (start < next_lba)
+				start = next_lba;
+			if (end > num_sectors)
+				end = num_sectors;
+			if (end <= start)
+				continue;
+
+			if (lba_status_desc_status(desc) == LBA_STATUS_MAPPED &&
+			    provisioning_add_mapped(p, &size, start, end - start))
+			{
+				ERROR("Failed to allocate memory for the mapped extents");
+				goto Error;
+			}
+			next_lba = end;
+		}
+
+		if (next_lba <= lba) {
+			ERROR("LBA status doesn't advance past LBA %"PRIu64, lba);
+			goto Error;
+		}
+		lba = next_lba;
+	}
+	free(buf);
+
+	p->valid = true;
+	INFO("Disk has %"PRIu64" of %"PRIu64" sectors mapped (%.1f%%) in %u extents, only the mapped extents are scanned",
+			p->mapped_sectors, num_sectors, p->mapped_sectors * 100.0 / num_sectors, p->len);
+	if (p->sample_percent)
+		INFO("Sampling %u%% of the reads of unmapped extents", p->sample_percent);
+	return 0;
+
+Error:
+	free(buf);
+	provisioning_free(disk);
+	return -1;
+}
+
+static bool provisioning_is_mapped(provisioning_t *p, uint64_t start, uint64_t end)
+{
+	unsigned low = 0, high = p->len;
+
+	// Find the first extent that ends after start
+	while (low < high) {
+		unsigned mid = low + (high - low) / 2;
+		if (p->mapped[mid].start_sector + p->mapped[mid].len_sectors <= start)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low < p->len && p->mapped[low].start_sector < end;
+}
+
+bool provisioning_read_wanted(disk_t *disk, uint64_t offset, uint64_t size)
+{
+	provisioning_t *p = &disk->provisioning;
+
+	if (!p->valid)
+		return true;
+
+	if (provisioning_is_mapped(p, offset / disk->sector_size, (offset + size + disk->sector_size - 1) / disk->sector_size))
+		return true;
+
+	// Spread the sampled reads evenly over the unmapped reads
+	const uint64_t unmapped_reads = p->skipped_reads + p->sampled_reads;
+	if ((unmapped_reads + 1) * p->sample_percent / 100 > unmapped_reads * p->sample_percent / 100) {
+		p->sampled_reads++;
+		return true;
+	}
+
+	p->skipped_reads++;
+	return false;
+}
+
+void provisioning_free(disk_t *disk)
+{
+	provisioning_t *p = &disk->provisioning;
+
+	free(p->mapped);
+	p->mapped = NULL;
+	p->len = 0;
+	p->valid = false;
+	p->mapped_sectors = p->skipped_reads = p->sampled_reads = 0;
+}
@@ -0,0 +1,33 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_PROVISIONING_H
+#define DISKSCAN_PROVISIONING_H
+
+#include "diskscan.h"
+
+/* GET LBA STATUS is issued in chunks of this size */
+#define PROVISIONING_STATUS_BUF_SIZE (64*1024)
+
+int provisioning_load(disk_t *disk);
+bool provisioning_read_wanted(disk_t *disk, uint64_t offset, uint64_t size);
+void provisioning_free(disk_t *disk);
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Drive side error recovery time limits.
+ *
+ * A desktop disk can spend tens of seconds retrying a weak sector internally
+ * before it returns the data or an error. With a time limit the disk gives up
+ * early and reports a medium error, the scan then bisects the read to find the
+ * weak sectors. The original limits are restored when the disk is closed.
+ *
+ * ATA disks use SCT Error Recovery Control. SCSI disks use the Read-Write Error
+ * Recovery mode page, which has a single time limit for reads and writes, the
+ * read retry count is reduced and recovered errors are reported too.
+ */
+
+#include "recovery.h"
+#include "disk.h"
+#include "verbose.h"
+#include "libscsicmd/include/parse_mode_sense.h"
+
+#include <string.h>
+
+static uint16_t msec_to_ata(unsigned msec)
+{
+	unsigned val = (msec + RECOVERY_ATA_UNIT_MSEC - 1) / RECOVERY_ATA_UNIT_MSEC;
+	return val > UINT16_MAX ? UINT16_MAX : val;
+}
+
+static int recovery_limit_set_ata(disk_t *disk, unsigned read_msec, unsigned write_msec)
+{
+	error_recovery_t *r = &disk->recovery;
+	uint16_t orig_read, orig_write;
+
+	if (disk->ata_buf_len < 512 || !ata_identify_sct_erc_supported(disk->ata_buf)) {
+		ERROR("Disk doesn't support SCT Error Recovery Control, can't limit its error recovery time");
+		return -1;
+	}
+
+	if (disk_ata_sct_erc_get(&disk->dev, ATA_SCT_ERC_READ, &orig_read) ||
+	    disk_ata_sct_erc_get(&disk->dev, ATA_SCT_ERC_WRITE, &orig_write))
+	{
+		ERROR("Failed to read the current SCT Error Recovery Control time limits");
+		return -1;
+	}
+
+	if (disk_ata_sct_erc_set(&disk->dev, ATA_SCT_ERC_READ, msec_to_ata(read_msec)) ||
+	    disk_ata_sct_erc_set(&disk->dev, ATA_SCT_ERC_WRITE, msec_to_ata(write_msec)))
+	{
+		ERROR("Failed to set the SCT Error Recovery Control time limits");
+		// The read limit may have been set already
+		disk_ata_sct_erc_set(&disk->dev, ATA_SCT_ERC_READ, orig_read);
+		return -1;
+	}
+
+	r->read_msec = msec_to_ata(read_msec) * RECOVERY_ATA_UNIT_MSEC;
+	r->write_msec = msec_to_ata(write_msec) * RECOVERY_ATA_UNIT_MSEC;
+	r->orig_read_msec = orig_read * RECOVERY_ATA_UNIT_MSEC;
+	r->orig_write_msec = orig_write * RECOVERY_ATA_UNIT_MSEC;
+	return 0;
+}
+
+static int recovery_limit_restore_ata(disk_t *disk)
+{
+	error_recovery_t *r = &disk->recovery;
+
+	if (disk_ata_sct_erc_set(&disk->dev, ATA_SCT_ERC_READ, r->orig_read_msec / RECOVERY_ATA_UNIT_MSEC) ||
+	    disk_ata_sct_erc_set(&disk->dev, ATA_SCT_ERC_WRITE, r->orig_write_msec / RECOVERY_ATA_UNIT_MSEC))
+		return -1;
+	return 0;
+}
+
+/* Only the bits the disk reports as changeable are modified */
+static void mode_page_set_masked(uint8_t *param, const uint8_t *mask, unsigned offset, unsigned len, unsigned val)
+{
+	unsigned i;
+
+	for (i = 0; i < len; i++) {
+		const uint8_t b = val >> (8 * (len - 1 - i));
+		param[offset + i] = (param[offset + i] & ~mask[offset + i]) | (b & mask[offset + i]);
+	}
+}
+
+static int recovery_limit_set_scsi(disk_t *disk, unsigned read_msec)
+{
+	error_recovery_t *r = &disk->recovery;
+	unsigned char page[sizeof(r->orig_mode_page)];
+	unsigned char mask[sizeof(r->orig_mode_page)];
+	int page_len, mask_len;
+
+	page_len = disk_mode_page_read(&disk->dev, MODE_PAGE_RW_ERROR_RECOVERY, PAGE_CONTROL_CURRENT, page, sizeof(page), NULL);
+	mask_len = disk_mode_page_read(&disk->dev, MODE_PAGE_RW_ERROR_RECOVERY, PAGE_CONTROL_CHANGEABLE, mask, sizeof(mask), NULL);
+	if (page_len < MODE_PAGE_RW_ERROR_RECOVERY_LEN || mask_len != page_len) {
+		ERROR("Failed to read the Read-Write Error Recovery mode page");
+		return -1;
+	}
+
+	uint8_t *param = mode_sense_data_param(page);
+	uint8_t *param_mask = mode_sense_data_param(mask);
+	if (rw_error_recovery_time_limit(param_mask) != 0xFFFF) {
+		ERROR("Disk doesn't allow changing the recovery time limit, can't limit its error recovery time");
+		return -1;
+	}
+
+	memcpy(r->orig_mode_page, page, page_len);
+	r->orig_mode_page_len = page_len;
+	r->orig_read_msec = r->orig_write_msec = rw_error_recovery_time_limit(param);
+
+	if (read_msec > UINT16_MAX)
+		read_msec = UINT16_MAX;
+	rw_error_recovery_set_time_limit(param, read_msec);
+	if (rw_error_recovery_read_retry_count(param) > RECOVERY_SCSI_READ_RETRIES)
+		mode_page_set_masked(param, param_mask, 1, 1, RECOVERY_SCSI_READ_RETRIES);
+	mode_page_set_masked(param, param_mask, 0, 1, rw_error_recovery_flags(param) | RW_ERROR_RECOVERY_PER);
+
+	if (disk_mode_page_write(&disk->dev, page, page_len)) {
+		ERROR("Failed to set the Read-Write Error Recovery mode page");
+		return -1;
+	}
+
+	VERBOSE("Read retries reduced from %u to %u, recovered errors are %s",
+			rw_error_recovery_read_retry_count(mode_sense_data_param(r->orig_mode_page)),
+			rw_error_recovery_read_retry_count(param),
+			rw_error_recovery_flags(param) & RW_ERROR_RECOVERY_PER ? "reported" : "not reported");
+	r->read_msec = r->write_msec = read_msec;
+	return 0;
+}
+
+static int recovery_limit_restore_scsi(disk_t *disk)
+{
+	error_recovery_t *r = &disk->recovery;
+
+	return disk_mode_page_write(&disk->dev, r->orig_mode_page, r->orig_mode_page_len);
+}
+
+int disk_recovery_limit_set(disk_t *disk, unsigned read_msec, unsigned write_msec)
+{
+	error_recovery_t *r = &disk->recovery;
+
+	int ret;
+
+	if (disk->is_ata)
+		ret = recovery_limit_set_ata(disk, read_msec, write_msec);
+	else
+		ret = recovery_limit_set_scsi(disk, read_msec);
+	if (ret)
+		return -1;
+
+	r->active = true;
+	INFO("Error recovery time limits set to read %u msec write %u msec, were read %u msec write %u msec (0 is unlimited)",
+			r->read_msec, r->write_msec, r->orig_read_msec, r->orig_write_msec);
+	return 0;
+}
+
+void recovery_limit_restore(disk_t *disk)
+{
+	error_recovery_t *r = &disk->recovery;
+
+	if (!r->active)
+		return;
+
+	if (disk->is_ata ? recovery_limit_restore_ata(disk) : recovery_limit_restore_scsi(disk))
+		ERROR("Failed to restore the original error recovery time limits, they will be reset on the next power cycle");
+	else
+		VERBOSE("Restored the original error recovery time limits");
+	r->active = false;
+}
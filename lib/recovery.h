@@ -0,0 +1,34 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_RECOVERY_H
+#define DISKSCAN_RECOVERY_H
+
+#include "diskscan.h"
+
+/* SCT ERC time limits are in 100 msec units */
+#define RECOVERY_ATA_UNIT_MSEC 100
+
+/* Read retries left to a SCSI disk with a time limit, fewer if the disk already uses fewer */
+#define RECOVERY_SCSI_READ_RETRIES 1
+
+void recovery_limit_restore(disk_t *disk);
+
+#endif
@@ -0,0 +1,319 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Repair of slow and unreadable regions found by the scan.
+ *
+ * A slow region is usually a sector the disk struggles to read, writing the
+ * same data back lets the disk remap it or refresh it in place. The data is
+ * first recovered with read retries and written back from the worker's own
+ * buffer, then read again from the media (FUA) and compared. Only sectors
+ * that can't be read at all are overwritten with zeros, everything else keeps
+ * its content.
+ *
+ * The work is done by a separate thread so the scan keeps streaming, the
+ * scan only blocks when the queue is full. Each repair command holds the I/O
+ * lock and the scan takes it around its timed reads, so the commands never
+ * overlap and the repairs stay out of the scan latencies.
+ */
+
+#include "repair.h"
+#include "verbose.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <inttypes.h>
+
+struct repair_req {
+	uint64_t offset;
+	uint32_t size;
+};
+
+struct repair {
+	disk_t *disk;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_mutex_t io_lock;
+	struct repair_req queue[REPAIR_QUEUE_LEN];
+	unsigned head;
+	unsigned tail;
+	bool stop;
+
+	/* Owned by the worker thread */
+	void *buf;
+	void *verify_buf;
+	unsigned num_rewritten;
+	unsigned num_zeroed;
+	unsigned num_failed;
+};
+
+enum repair_read_e {
+	REPAIR_READ_OK,
+	REPAIR_READ_UNCORRECTABLE,
+	REPAIR_READ_FAILED,
+};
+
+static bool repair_io_ok(const io_result_t *io_res)
+{
+	return io_res->data == DATA_FULL && (io_res->error == ERROR_NONE || io_res->error == ERROR_CORRECTED);
+}
+
+static enum repair_read_e repair_read(struct repair *r, uint64_t offset, uint32_t size)
+{
+	io_result_t io_res;
+	bool uncorrectable = false;
+	int i;
+
+	for (i = 0; i < REPAIR_READ_RETRIES; i++) {
+		pthread_mutex_lock(&r->io_lock);
+		disk_dev_read(&r->disk->dev, offset, size, r->buf, &io_res);
+		pthread_mutex_unlock(&r->io_lock);
+		if (repair_io_ok(&io_res))
+			return REPAIR_READ_OK;
+		if (io_res.error == ERROR_FATAL)
+			break;
+		uncorrectable = io_res.error == ERROR_UNCORRECTED;
+	}
+
+	return uncorrectable ? REPAIR_READ_UNCORRECTABLE : REPAIR_READ_FAILED;
+}
+
+/* Write the data in r->buf and read it back from the media to check it stuck */
+static bool repair_write_verify(struct repair *r, uint64_t offset, uint32_t size)
+{
+	io_result_t io_res;
+	ssize_t ret;
+
+	pthread_mutex_lock(&r->io_lock);
+	ret = disk_dev_write(&r->disk->dev, offset, size, r->buf, &io_res);
+	pthread_mutex_unlock(&r->io_lock);
+	if (ret != (ssize_t)size || !repair_io_ok(&io_res)) {
+		ERROR("Error while rewriting offset=%"PRIu64" size=%u error=%d", offset, size, io_res.error);
+		return false;
+	}
+
+	pthread_mutex_lock(&r->io_lock);
+	disk_dev_read_fua(&r->disk->dev, offset, size, r->verify_buf, &io_res);
+	pthread_mutex_unlock(&r->io_lock);
+	if (!repair_io_ok(&io_res)) {
+		ERROR("Failed to read back rewritten data, offset=%"PRIu64" size=%u error=%d", offset, size, io_res.error);
+		return false;
+	}
+
+	if (memcmp(r->buf, r->verify_buf, size) != 0) {
+		ERROR("Rewritten data does not match when read back, offset=%"PRIu64" size=%u", offset, size);
+		return false;
+	}
+
+	return true;
+}
+
+static void repair_chunk(struct repair *r, uint64_t offset, uint32_t size)
+{
+	const disk_t *disk = r->disk;
+	// The disk loses and rewrites whole physical sectors, narrow down to those when the chunk is aligned
+	const uint32_t sector_size = offset % disk->phys_sector_size == disk->phys_align_offset && size % disk->phys_sector_size == 0 ?
+		disk->phys_sector_size : disk->sector_size;
+
+	switch (repair_read(r, offset, size)) {
+		case REPAIR_READ_OK:
+			VERBOSE("Rewriting region offset=%"PRIu64" size=%u", offset, size);
+			if (repair_write_verify(r, offset, size))
+				r->num_rewritten++;
+			else
+				r->num_failed++;
+			break;
+
+		case REPAIR_READ_UNCORRECTABLE:
+			// Narrow it down so only the sectors that are really lost get zeroed
+			if (size > sector_size) {
+				uint32_t sector_offset;
+				for (sector_offset = 0; sector_offset + sector_size <= size; sector_offset += sector_size)
+					repair_chunk(r, offset + sector_offset, sector_size);
+				break;
+			}
+
+			INFO("Fixing uncorrectable sector by writing zeros, offset=%"PRIu64" size=%u", offset, size);
+			memset(r->buf, 0, size);
+			if (repair_write_verify(r, offset, size))
+				r->num_zeroed++;
+			else
+				r->num_failed++;
+			break;
+
+		case REPAIR_READ_FAILED:
+			ERROR("Failed to read region for repair and it isn't known to be uncorrectable, leaving it as is. offset=%"PRIu64" size=%u",
+					offset, size);
+			r->num_failed++;
+			break;
+	}
+}
+
+/* A chunk holds whole physical sectors so a lost one is never rewritten by a read-modify-write */
+static uint32_t repair_chunk_size(const disk_t *disk)
+{
+	const uint32_t chunk_size = REPAIR_CHUNK_SIZE > disk->phys_sector_size ? REPAIR_CHUNK_SIZE : disk->phys_sector_size;
+
+	return (chunk_size + disk->phys_sector_size - 1) / disk->phys_sector_size * disk->phys_sector_size;
+}
+
+static void repair_region(struct repair *r, uint64_t offset, uint32_t size)
+{
+	const disk_t *disk = r->disk;
+	const uint32_t chunk_size = repair_chunk_size(disk);
+	// Widen the region to the physical sectors it touches, the chunks then end on their boundaries
+	uint64_t end = disk_phys_align_down(disk, offset + size - 1 + disk->phys_sector_size);
+	uint64_t chunk_offset = disk_phys_align_down(disk, offset);
+
+	if (end > disk->num_bytes)
+		end = disk->num_bytes;
+
+	INFO("Repairing region offset=%"PRIu64" size=%u", offset, size);
+	while (chunk_offset < end) {
+		uint64_t next = disk_phys_align_down(disk, chunk_offset + chunk_size);
+		if (next <= chunk_offset || next > end)
+			next = end;
+		repair_chunk(r, chunk_offset, next - chunk_offset);
+		chunk_offset = next;
+	}
+}
+
+static void *repair_thread(void *arg)
+{
+	struct repair *r = arg;
+
+	pthread_mutex_lock(&r->lock);
+	while (1) {
+		while (r->head == r->tail && !r->stop)
+			pthread_cond_wait(&r->cond, &r->lock);
+		if (r->head == r->tail)
+			break; // Stopped and drained
+
+		struct repair_req req = r->queue[r->tail % REPAIR_QUEUE_LEN];
+		pthread_mutex_unlock(&r->lock);
+
+		repair_region(r, req.offset, req.size);
+
+		pthread_mutex_lock(&r->lock);
+		r->tail++;
+		pthread_cond_broadcast(&r->cond);
+	}
+	pthread_mutex_unlock(&r->lock);
+
+	return NULL;
+}
+
+int repair_start(disk_t *disk)
+{
+	struct repair *r = calloc(1, sizeof(*r));
+	if (r == NULL)
+		return -1;
+
+	r->disk = disk;
+	pthread_mutex_init(&r->lock, NULL);
+	pthread_cond_init(&r->cond, NULL);
+	pthread_mutex_init(&r->io_lock, NULL);
+
+	if (posix_memalign(&r->buf, 4096, repair_chunk_size(disk)) ||
+	    posix_memalign(&r->verify_buf, 4096, repair_chunk_size(disk)))
+	{
+		ERROR("Failed to allocate repair buffers");
+		goto Error;
+	}
+
+	if (pthread_create(&r->thread, NULL, repair_thread, r) != 0) {
+		ERROR("Failed to start the repair thread");
+		goto Error;
+	}
+
+	disk->repair = r;
+	return 0;
+
+Error:
+	free(r->buf);
+	free(r->verify_buf);
+	pthread_cond_destroy(&r->cond);
+	pthread_mutex_destroy(&r->lock);
+	pthread_mutex_destroy(&r->io_lock);
+	free(r);
+	return -1;
+}
+
+void repair_queue(disk_t *disk, uint64_t offset, uint32_t size)
+{
+	struct repair *r = disk->repair;
+
+	if (r == NULL)
+		return;
+
+	pthread_mutex_lock(&r->lock);
+	while (r->head - r->tail >= REPAIR_QUEUE_LEN)
+		pthread_cond_wait(&r->cond, &r->lock);
+	r->queue[r->head % REPAIR_QUEUE_LEN].offset = offset;
+	r->queue[r->head % REPAIR_QUEUE_LEN].size = size;
+	r->head++;
+	pthread_cond_broadcast(&r->cond);
+	pthread_mutex_unlock(&r->lock);
+}
+
+void repair_io_begin(disk_t *disk)
+{
+	struct repair *r = disk->repair;
+
+	if (r)
+		pthread_mutex_lock(&r->io_lock);
+}
+
+void repair_io_end(disk_t *disk)
+{
+	struct repair *r = disk->repair;
+
+	if (r)
+		pthread_mutex_unlock(&r->io_lock);
+}
+
+void repair_end(disk_t *disk)
+{
+	struct repair *r = disk->repair;
+
+	if (r == NULL)
+		return;
+
+	pthread_mutex_lock(&r->lock);
+	if (r->head != r->tail)
+		INFO("Waiting for %u queued repairs to finish", r->head - r->tail);
+	r->stop = true;
+	pthread_cond_broadcast(&r->cond);
+	pthread_mutex_unlock(&r->lock);
+
+	pthread_join(r->thread, NULL);
+
+	if (r->num_rewritten || r->num_zeroed || r->num_failed)
+		INFO("Repair done: %u chunks rewritten, %u sectors zeroed, %u repairs failed", r->num_rewritten, r->num_zeroed, r->num_failed);
+
+	free(r->buf);
+	free(r->verify_buf);
+	pthread_cond_destroy(&r->cond);
+	pthread_mutex_destroy(&r->lock);
+	pthread_mutex_destroy(&r->io_lock);
+	free(r);
+	disk->repair = NULL;
+}
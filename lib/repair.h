@@ -0,0 +1,40 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_REPAIR_H
+#define DISKSCAN_REPAIR_H
+
+#include "diskscan.h"
+
+/* Regions waiting for the repair worker, the scan blocks when it is full */
+#define REPAIR_QUEUE_LEN 64
+/* Regions are repaired in chunks of at least this size and of whole physical sectors,
+ * uncorrectable chunks are handled per sector */
+#define REPAIR_CHUNK_SIZE 4096
+#define REPAIR_READ_RETRIES 5
+
+int repair_start(disk_t *disk);
+void repair_queue(disk_t *disk, uint64_t offset, uint32_t size);
+/* Keep the repair commands off the disk while the scan times its own */
+void repair_io_begin(disk_t *disk);
+void repair_io_end(disk_t *disk);
+void repair_end(disk_t *disk);
+
+#endif
@@ -0,0 +1,281 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Retry policy for failed I/O.
+ *
+ * The sense key alone doesn't tell a transient condition from a persistent
+ * one, a unit attention after a bus reset is gone on the next command while a
+ * medium error will take the full recovery time of the disk again on every
+ * retry. The rules below are matched in order on the sense key, ASC and ASCQ
+ * and the first match decides what to do.
+ */
+
+#include "retry.h"
+#include "verbose.h"
+
+#include <time.h>
+#include <inttypes.h>
+
+static const struct retry_rule retry_rules[] = {
+	{SENSE_KEY_NO_SENSE,        RETRY_ANY, RETRY_ANY, RETRY_ACTION_NONE, 0},
+	{SENSE_KEY_RECOVERED_ERROR, RETRY_ANY, RETRY_ANY, RETRY_ACTION_NONE, 0},
+
+	// Reset, power on and changed parameters are reported once and cleared
+	{SENSE_KEY_UNIT_ATTENTION,  RETRY_ANY, RETRY_ANY, RETRY_ACTION_NOW, 3},
+
+	{SENSE_KEY_NOT_READY,       0x04, 0x02, RETRY_ACTION_ABORT, 0},     // Initializing command required
+	{SENSE_KEY_NOT_READY,       0x04, 0x03, RETRY_ACTION_ABORT, 0},     // Manual intervention required
+	{SENSE_KEY_NOT_READY,       0x04, RETRY_ANY, RETRY_ACTION_BACKOFF, 8}, // Becoming ready, operation in progress
+	{SENSE_KEY_NOT_READY,       0x3A, RETRY_ANY, RETRY_ACTION_ABORT, 0}, // Medium not present
+	{SENSE_KEY_NOT_READY,       RETRY_ANY, RETRY_ANY, RETRY_ACTION_BACKOFF, 4},
+
+	// Transport errors, the command never got to the media
+	{SENSE_KEY_ABORTED_COMMAND, RETRY_ANY, RETRY_ANY, RETRY_ACTION_NOW, 3},
+
+	{SENSE_KEY_MEDIUM_ERROR,    0x31, RETRY_ANY, RETRY_ACTION_ABORT, 0}, // Medium format corrupted
+	{SENSE_KEY_MEDIUM_ERROR,    RETRY_ANY, RETRY_ANY, RETRY_ACTION_BISECT, 0},
+
+	{SENSE_KEY_HARDWARE_ERROR,  0x15, RETRY_ANY, RETRY_ACTION_BACKOFF, 2}, // Positioning error
+	{SENSE_KEY_HARDWARE_ERROR,  RETRY_ANY, RETRY_ANY, RETRY_ACTION_ABORT, 0},
+
+	{SENSE_KEY_ILLEGAL_REQUEST, 0x21, RETRY_ANY, RETRY_ACTION_SKIP, 0},  // LBA out of range
+	{SENSE_KEY_ILLEGAL_REQUEST, RETRY_ANY, RETRY_ANY, RETRY_ACTION_ABORT, 0},
+
+	{SENSE_KEY_MISCOMPARE,      RETRY_ANY, RETRY_ANY, RETRY_ACTION_SKIP, 0},
+
+	{RETRY_ANY,                 RETRY_ANY, RETRY_ANY, RETRY_ACTION_ABORT, 0},
+};
+
+/* Failures without a usable sense are judged by the error the OS layer
+ * reported, mostly transport problems (timeout, reset) where a few retries
+ * get over them but a dead disk doesn't come back.
+ */
+static const struct retry_rule retry_rules_no_sense[] = {
+	[ERROR_NONE]        = {RETRY_ANY, RETRY_ANY, RETRY_ANY, RETRY_ACTION_BACKOFF, 2}, // Partial data
+	[ERROR_CORRECTED]   = {RETRY_ANY, RETRY_ANY, RETRY_ANY, RETRY_ACTION_BACKOFF, 2},
+	[ERROR_UNCORRECTED] = {RETRY_ANY, RETRY_ANY, RETRY_ANY, RETRY_ACTION_BISECT, 0},  // EIO from a plain read
+	[ERROR_NEED_RETRY]  = {RETRY_ANY, RETRY_ANY, RETRY_ANY, RETRY_ACTION_BACKOFF, 2},
+	[ERROR_FATAL]       = {RETRY_ANY, RETRY_ANY, RETRY_ANY, RETRY_ACTION_ABORT, 0},   // The OS failed the command
+	[ERROR_UNKNOWN]     = {RETRY_ANY, RETRY_ANY, RETRY_ANY, RETRY_ACTION_BACKOFF, 2},
+};
+static const struct retry_rule retry_rule_success = {RETRY_ANY, RETRY_ANY, RETRY_ANY, RETRY_ACTION_NONE, 0};
+
+static bool retry_io_ok(const io_result_t *io_res)
+{
+	return io_res->data == DATA_FULL && (io_res->error == ERROR_NONE || io_res->error == ERROR_CORRECTED);
+}
+
+static bool rule_match(int rule_val, int val)
+{
+	return rule_val == RETRY_ANY || rule_val == val;
+}
+
+const struct retry_rule *retry_rule_find(const io_result_t *io_res)
+{
+	unsigned i;
+
+	if (retry_io_ok(io_res))
+		return &retry_rule_success;
+
+	// An unknown error with a sense means the sense couldn't be parsed
+	if (io_res->sense_len && io_res->error != ERROR_UNKNOWN) {
+		for (i = 0; i < ARRAY_SIZE(retry_rules); i++) {
+			const struct retry_rule *rule = &retry_rules[i];
+
+			if (rule_match(rule->sense_key, io_res->info.sense_key) &&
+			    rule_match(rule->asc, io_res->info.asc) &&
+			    rule_match(rule->ascq, io_res->info.ascq))
+			{
+				// The command still failed, a sense that says all is fine doesn't explain it
+				if (rule->action != RETRY_ACTION_NONE)
+					return rule;
+				break;
+			}
+		}
+	}
+
+	return &retry_rules_no_sense[io_res->error];
+}
+
+const char *retry_action_to_str(retry_action_e action)
+{
+	switch (action) {
+		case RETRY_ACTION_NONE: return "none";
+		case RETRY_ACTION_NOW: return "retry";
+		case RETRY_ACTION_BACKOFF: return "backoff";
+		case RETRY_ACTION_BISECT: return "bisect";
+		case RETRY_ACTION_SKIP: return "skip";
+		case RETRY_ACTION_ABORT: return "abort";
+	}
+	return "unknown";
+}
+
+static inline uint64_t ts_diff_nsec(const struct timespec *end, const struct timespec *start)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000000ULL + end->tv_nsec - start->tv_nsec;
+}
+
+/* Reissue the command, its latency goes to the retry histogram so it doesn't skew the first attempt latencies */
+static void retry_issue(disk_t *disk, bool write, uint64_t offset, uint32_t size, void *data, io_result_t *io_res)
+{
+	struct timespec t_start;
+	struct timespec t_end;
+
+	clock_gettime(CLOCK_MONOTONIC, &t_start);
+	if (write)
+		disk_dev_write(&disk->dev, offset, size, data, io_res);
+	else
+		disk_dev_read(&disk->dev, offset, size, data, io_res);
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+	const uint64_t t = ts_diff_nsec(&t_end, &t_start);
+	disk->profile.io_nsec += t;
+	hdr_record_value(disk->retry_histogram, t / 1000);
+}
+
+static void retry_backoff(disk_t *disk, unsigned attempt)
+{
+	const uint64_t msec = (uint64_t)RETRY_BACKOFF_MSEC << attempt;
+	struct timespec ts = {.tv_sec = msec / 1000, .tv_nsec = (msec % 1000) * 1000000};
+
+	VERBOSE("Waiting %"PRIu64" msec before retrying", msec);
+	nanosleep(&ts, NULL);
+	disk->profile.retry_wait_nsec += msec * 1000000;
+}
+
+/* The granule boundary inside the part that is closest below its middle, granules are
+ * counted from LBA 0 and follow the physical sector alignment. Returns 0 when the part
+ * is within a single granule.
+ */
+static uint64_t retry_bisect_split(const disk_t *disk, uint64_t offset, uint32_t size, uint32_t granule)
+{
+	const uint64_t lead = disk->phys_align_offset % granule;
+	const uint64_t middle = offset + size / 2;
+	uint64_t split = middle < lead ? lead : (middle - lead) / granule * granule + lead;
+
+	if (split <= offset)
+		split += granule;
+	return split < offset + size ? split : 0;
+}
+
+/* Split the failed read in halves until the unreadable parts are isolated,
+ * the readable parts end up in the data buffer. Returns the number of bad sectors.
+ */
+static uint64_t retry_bisect(disk_t *disk, uint64_t offset, uint32_t size, void *data, io_result_t *io_res)
+{
+	uint32_t min_size = RETRY_BISECT_MIN_BYTES > disk->phys_sector_size ? RETRY_BISECT_MIN_BYTES : disk->phys_sector_size;
+
+	// Split on the bisection granules so a defect is reported at its own granule whatever the
+	// read offset, within a granule keep to a physical sector boundary or else a sector boundary
+	uint64_t mid = retry_bisect_split(disk, offset, size, min_size);
+	if (mid == 0)
+		mid = disk_phys_align_down(disk, offset + size / 2);
+	const uint32_t half = mid > offset ? mid - offset : size / 2 / disk->sector_size * disk->sector_size;
+
+	if (size <= min_size || half == 0) {
+		const uint64_t first_phys = disk_phys_sector(disk, offset);
+		const uint64_t num_phys = disk_phys_sector(disk, offset + size - 1) - first_phys + 1;
+		char asc_name[ASC_NUM_NAME_LEN];
+
+		ERROR("Unreadable sectors at LBA %"PRIu64" count %"PRIu64", physical sector %"PRIu64" count %"PRIu64" (%s)",
+				offset / disk->sector_size, size / disk->sector_size, first_phys, num_phys,
+				asc_num_to_name_r(io_res->info.asc, io_res->info.ascq, asc_name, sizeof(asc_name)));
+		disk->retry.bad_phys_sectors += num_phys;
+		return size / disk->sector_size;
+	}
+
+	const uint32_t sizes[2] = {half, size - half};
+	uint64_t bad = 0;
+	uint32_t part_offset = 0;
+	unsigned i;
+
+	for (i = 0; i < 2; i++) {
+		io_result_t part_res;
+
+		retry_issue(disk, false, offset + part_offset, sizes[i], (char *)data + part_offset, &part_res);
+		if (!retry_io_ok(&part_res)) {
+			if (retry_rule_find(&part_res)->action == RETRY_ACTION_BISECT) {
+				bad += retry_bisect(disk, offset + part_offset, sizes[i], (char *)data + part_offset, &part_res);
+			} else {
+				ERROR("Bisection of offset %"PRIu64" size %u stopped by a %s error", offset + part_offset, sizes[i],
+						sense_key_to_name(part_res.info.sense_key));
+				bad += sizes[i] / disk->sector_size;
+				disk->retry.bad_phys_sectors += disk_phys_sector(disk, offset + part_offset + sizes[i] - 1) -
+					disk_phys_sector(disk, offset + part_offset) + 1;
+			}
+		}
+		part_offset += sizes[i];
+	}
+
+	return bad;
+}
+
+retry_action_e retry_io(disk_t *disk, bool write, uint64_t offset, uint32_t size, void *data, io_result_t *io_res, bool allow_bisect)
+{
+	const struct retry_rule *rule = retry_rule_find(io_res);
+	const sense_info_t first_info = io_res->info;
+	const bool first_has_sense = io_res->sense_len > 0;
+	unsigned attempt = 0;
+
+	// The rule can change as the error does, a unit attention may be followed by the real error
+	while ((rule->action == RETRY_ACTION_NOW || rule->action == RETRY_ACTION_BACKOFF) && attempt < rule->max_retries) {
+		if (rule->action == RETRY_ACTION_BACKOFF)
+			retry_backoff(disk, attempt);
+		attempt++;
+		disk->retry.retries++;
+		retry_issue(disk, write, offset, size, data, io_res);
+		rule = retry_rule_find(io_res);
+	}
+
+	if (rule->action == RETRY_ACTION_NONE) {
+		if (attempt) {
+			char asc_name[ASC_NUM_NAME_LEN];
+
+			if (first_has_sense)
+				INFO("I/O at offset %"PRIu64" size %u succeeded after %u retries, first error %02X/%02X/%02X %s", offset, size, attempt,
+						first_info.sense_key, first_info.asc, first_info.ascq, asc_num_to_name_r(first_info.asc, first_info.ascq, asc_name, sizeof(asc_name)));
+			else
+				INFO("I/O at offset %"PRIu64" size %u succeeded after %u retries", offset, size, attempt);
+			disk->retry.recovered++;
+		}
+		return RETRY_ACTION_NONE;
+	}
+
+	if (rule->action == RETRY_ACTION_BISECT && allow_bisect && !write && size > disk->sector_size) {
+		disk->retry.bisected++;
+		const uint64_t bad = retry_bisect(disk, offset, size, data, io_res);
+		disk->retry.bad_sectors += bad;
+		// Every part was read so the medium error was transient and the data is complete
+		if (bad == 0) {
+			INFO("I/O at offset %"PRIu64" size %u read in parts after a medium error", offset, size);
+			io_res->data = DATA_FULL;
+			io_res->error = ERROR_CORRECTED;
+			disk->retry.recovered++;
+		}
+		return RETRY_ACTION_BISECT;
+	}
+
+	// Out of retries is just an error to count, it is up to the scan to give up on persistent ones
+	if (rule->action == RETRY_ACTION_NOW || rule->action == RETRY_ACTION_BACKOFF)
+		return RETRY_ACTION_SKIP;
+	if (rule->action == RETRY_ACTION_BISECT)
+		return RETRY_ACTION_SKIP;
+	return rule->action;
+}
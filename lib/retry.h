@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKSCAN_RETRY_H
+#define DISKSCAN_RETRY_H
+
+#include "diskscan.h"
+
+/* Backoff before the first retry, doubled on every further retry */
+#define RETRY_BACKOFF_MSEC 100
+/* Bisection stops at this size, or the sector size if it is larger */
+#define RETRY_BISECT_MIN_BYTES 4096
+
+typedef enum retry_action_e {
+	RETRY_ACTION_NONE,    /* Not an error, nothing to do */
+	RETRY_ACTION_NOW,     /* Transient condition (bus reset, aborted command), retry right away */
+	RETRY_ACTION_BACKOFF, /* The disk is busy or becoming ready, retry after a pause */
+	RETRY_ACTION_BISECT,  /* Media error, split the read to find the bad sectors instead of retrying */
+	RETRY_ACTION_SKIP,    /* A retry will not help, count the error and move on */
+	RETRY_ACTION_ABORT,   /* The disk can't be scanned any further */
+} retry_action_e;
+
+#define RETRY_ANY -1
+
+struct retry_rule {
+	int sense_key;  /* RETRY_ANY to match any */
+	int asc;
+	int ascq;
+	retry_action_e action;
+	unsigned max_retries;
+};
+
+const struct retry_rule *retry_rule_find(const io_result_t *io_res);
+const char *retry_action_to_str(retry_action_e action);
+
+/* Apply the policy to a failed I/O, io_res is updated to the result of the last retry.
+ * Bisection is only worth it for an isolated error, in a bad area every part fails.
+ * Returns the action that was taken, RETRY_ACTION_NONE if a retry succeeded.
+ */
+retry_action_e retry_io(disk_t *disk, bool write, uint64_t offset, uint32_t size, void *data, io_result_t *io_res, bool allow_bisect);
+
+#endif
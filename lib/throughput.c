@@ -0,0 +1,112 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Zone transfer-rate analysis.
+ *
+ * An HDD transfer rate only goes down from the outer to the inner tracks, in
+ * steps at the zone boundaries. We fit a non-increasing curve to the
+ * per-bucket throughput with the pool adjacent violators algorithm, weighted
+ * by the bytes read in each bucket, and flag buckets that fall well below it.
+ * Those are the dips from weak heads or background work in the disk.
+ */
+
+#include "throughput.h"
+#include "verbose.h"
+
+#include <stdlib.h>
+#include <inttypes.h>
+
+struct pava_block {
+	double sum_wy;
+	double sum_w;
+	unsigned len;
+};
+
+static inline double pava_mean(const struct pava_block *b)
+{
+	return b->sum_wy / b->sum_w;
+}
+
+void throughput_analyze(disk_t *disk)
+{
+	latency_t *graph = disk->latency_graph;
+	struct pava_block *blocks;
+	unsigned num_blocks = 0;
+	unsigned i;
+
+	disk->num_throughput_dips = 0;
+
+	blocks = malloc(sizeof(*blocks) * disk->latency_graph_len);
+	if (blocks == NULL) {
+		ERROR("Failed to allocate memory for throughput analysis");
+		return;
+	}
+
+	for (i = 0; i < disk->latency_graph_len; i++) {
+		latency_t *l = &graph[i];
+
+		l->throughput_mbps = 0.0;
+		l->model_mbps = 0.0;
+		l->throughput_dip = false;
+
+		// Buckets that were never scanned (an aborted scan) don't take part in the fit
+		if (l->io_nsec == 0)
+			continue;
+
+		l->throughput_mbps = l->bytes * 1000.0 / l->io_nsec;
+
+		blocks[num_blocks].sum_wy = l->bytes * l->throughput_mbps;
+		blocks[num_blocks].sum_w = l->bytes;
+		blocks[num_blocks].len = 1;
+		num_blocks++;
+
+		// Pool with the previous block as long as the rate goes up
+		while (num_blocks > 1 && pava_mean(&blocks[num_blocks-2]) < pava_mean(&blocks[num_blocks-1])) {
+			blocks[num_blocks-2].sum_wy += blocks[num_blocks-1].sum_wy;
+			blocks[num_blocks-2].sum_w += blocks[num_blocks-1].sum_w;
+			blocks[num_blocks-2].len += blocks[num_blocks-1].len;
+			num_blocks--;
+		}
+	}
+
+	unsigned block = 0;
+	unsigned used = 0;
+	for (i = 0; i < disk->latency_graph_len; i++) {
+		latency_t *l = &graph[i];
+
+		if (l->io_nsec == 0)
+			continue;
+
+		l->model_mbps = pava_mean(&blocks[block]);
+		if (++used == blocks[block].len) {
+			block++;
+			used = 0;
+		}
+
+		if (l->throughput_mbps < l->model_mbps * (100 - THROUGHPUT_DIP_PERCENT) / 100.0) {
+			l->throughput_dip = true;
+			disk->num_throughput_dips++;
+			VERBOSE("Throughput dip at sectors %"PRIu64"-%"PRIu64": %.1f MB/s while the zone rate is %.1f MB/s",
+					l->start_sector, l->end_sector, l->throughput_mbps, l->model_mbps);
+		}
+	}
+
+	free(blocks);
+}
@@ -0,0 +1,182 @@
+/*
+ *  Copyright 2026 DiskScan contributors
+ *
+ *  This file is part of DiskScan.
+ *
+ *  DiskScan is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *  DiskScan is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DiskScan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+/* Zoned disks.
+ *
+ * A host managed SMR disk fails reads past the write pointer of a sequential
+ * zone and a host aware one returns filler data there, either way it is time
+ * wasted. The zones are loaded at the start of the scan, the scan then reads
+ * only the part of each zone that holds data and keeps one latency bucket per
+ * zone.
+ */
+
+#include "zones.h"
+#include "disk.h"
+#include "verbose.h"
+#include "libscsicmd/include/parse_report_zones.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static int zones_add(zones_t *z, unsigned *size, uint8_t *desc)
+{
+	if (z->len == *size) {
+		unsigned new_size = *size ? *size * 2 : 1024;
+		zone_t *zones = realloc(z->zones, new_size * sizeof(zone_t));
+		if (zones == NULL)
+			return -1;
+		z->zones = zones;
+		*size = new_size;
+	}
+
+	zone_t *zone = &z->zones[z->len++];
+	zone->start_sector = zone_desc_start_lba(desc);
+	zone->len_sectors = zone_desc_len(desc);
+	zone->readable_sectors = zone_desc_readable_len(desc);
+	zone->type = zone_desc_type(desc);
+	zone->cond = zone_desc_cond(desc);
+	return 0;
+}
+
+/* Latency buckets map to zones by dividing the offset by the zone size */
+static bool zones_uniform(disk_t *disk, zones_t *z)
+{
+	const uint64_t num_sectors = disk->num_bytes / disk->sector_size;
+	unsigned i;
+
+	z->zone_sectors = z->zones[0].len_sectors;
+	for (i = 0; i < z->len; i++) {
+		const zone_t *zone = &z->zones[i];
+		if (zone->start_sector != i * z->zone_sectors)
+			return false;
+		if (zone->len_sectors != z->zone_sectors && i != z->len - 1)
+			return false;
+	}
+
+	return z->zones[z->len-1].start_sector + z->zones[z->len-1].len_sectors == num_sectors;
+}
+
+/* Returns -1 only on a failure, a disk that isn't zoned is not an error */
+int zones_load(disk_t *disk)
+{
+	zones_t *z = &disk->zones;
+	const uint64_t num_sectors = disk->num_bytes / disk->sector_size;
+	unsigned size = 0;
+	uint64_t lba = 0;
+	unsigned i;
+
+	zones_free(disk);
+
+	unsigned char *buf = malloc(ZONES_REPORT_BUF_SIZE);
+	if (buf == NULL) {
+		ERROR("Failed to allocate memory for the zone report");
+		return -1;
+	}
+
+	while (lba < num_sectors) {
+		uint8_t *desc;
+		unsigned idx;
+		int len = disk_report_zones(&disk->dev, lba, buf, ZONES_REPORT_BUF_SIZE);
+
+		if (len < 0 && z->len == 0) {
+			VERBOSE("Disk doesn't report zones, scanning it as a whole");
+			free(buf);
+			return 0;
+		}
+		if (len < 0) {
+			ERROR("Failed to report the zones from LBA %"PRIu64, lba);
+			goto Error;
+		}
+
+		if (report_zones_num_descs(buf, len) == 0)
+			break;
+
+		for_all_report_zones_descs(buf, len, desc, idx) {
+			if (zones_add(z, &size, desc)) {
+				ERROR("Failed to allocate memory for the zone list");
+				goto Error;
+			}
+		}
+
+		const zone_t *last = &z->zones[z->len-1];
+		if (last->start_sector + last->len_sectors <= lba) {
+			ERROR("Zone report doesn't advance past LBA %"PRIu64, lba);
+			goto Error;
+		}
+		lba = last->start_sector + last->len_sectors;
+	}
+	free(buf);
+	buf = NULL;
+
+	if (z->len == 0)
+		return 0;
+
+	if (!zones_uniform(disk, z)) {
+		INFO("Disk zones are not of a uniform size, scanning it as a whole");
+		zones_free(disk);
+		return 0;
+	}
+
+	for (i = 0; i < z->len; i++) {
+		const zone_t *zone = &z->zones[i];
+		z->readable_sectors += zone->readable_sectors;
+		if (zone->type == ZONE_TYPE_SEQ_WRITE_REQUIRED)
+			z->num_seq_required++;
+		if (zone->cond == ZONE_COND_EMPTY)
+			z->num_empty++;
+		else if (zone->cond == ZONE_COND_OFFLINE)
+			z->num_offline++;
+	}
+
+	// One latency bucket per zone
+	latency_t *graph = calloc(z->len, sizeof(latency_t));
+	latency_t *write_graph = calloc(z->len, sizeof(latency_t));
+	if (graph == NULL || write_graph == NULL) {
+		ERROR("Failed to allocate memory for the zone latency graph");
+		free(graph);
+		free(write_graph);
+		goto Error;
+	}
+	free(disk->latency_graph);
+	free(disk->write_latency_graph);
+	disk->latency_graph = graph;
+	disk->write_latency_graph = write_graph;
+	disk->latency_graph_len = z->len;
+
+	z->zoned = true;
+	INFO("Disk is zoned with %u zones of %"PRIu64" sectors, %"PRIu64" sectors hold data, %u zones empty and %u offline",
+			z->len, z->zone_sectors, z->readable_sectors, z->num_empty, z->num_offline);
+	if (z->num_offline)
+		ERROR("Disk has %u offline zones that can't be read", z->num_offline);
+	return 0;
+
+Error:
+	free(buf);
+	zones_free(disk);
+	return -1;
+}
+
+void zones_free(disk_t *disk)
+{
+	free(disk->zones.zones);
+	memset(&disk->zones, 0, sizeof(disk->zones));
+}
@@ -214,6 +214,78 @@ static inline int cdb_ata_smart_read_threshold(unsigned char *cdb)
 	return cdb_ata_passthrough_12(cdb, 0xB0, 0xD1, 0xC24F<<8, 1, PT_PROTO_DMA, true, 0);
 }
 
+static inline int cdb_ata_smart_write_log(unsigned char *cdb, uint8_t log_addr, uint8_t num_pages, int ck_cond)
+{
+	return cdb_ata_passthrough_12(cdb, 0xB0, 0xD6, (0xC24F<<8) | log_addr, num_pages, PT_PROTO_PIO_DATA_OUT, false, ck_cond);
+}
+
+/* SCT commands are sent as a 512 byte sector written to the SCT command log */
+#define ATA_SCT_LOG_ADDR 0xE0
+#define ATA_SCT_ACTION_ERC 3
+#define ATA_SCT_ERC_FUNCTION_SET 1
+#define ATA_SCT_ERC_FUNCTION_GET 2
+
+typedef enum ata_sct_erc_e {
+	ATA_SCT_ERC_READ = 1,
+	ATA_SCT_ERC_WRITE = 2,
+} ata_sct_erc_e;
+
+static inline bool ata_identify_sct_erc_supported(const unsigned char *identify)
+{
+	// Word 206: bit 0 SCT command transport, bit 3 error recovery control action
+	return ata_get_bit(identify, 206, 0) && ata_get_bit(identify, 206, 3);
+}
+
+static inline void ata_set_word(unsigned char *buf, int word, ata_word_t val)
+{
+	buf[word*2] = val & 0xFF;
+	buf[word*2+1] = val >> 8;
+}
+
+/** SCT Error Recovery Control, the time limit is in 100 msec units and 0 disables the limit.
+ * buf must be 512 bytes and is sent with the command. The current limit of a get is returned in the ATA
+ * status so it is requested with the check condition bit.
+ */
+static inline int cdb_ata_sct_erc(unsigned char *cdb, unsigned char *buf, bool set, ata_sct_erc_e selection, uint16_t time_limit)
+{
+	int i;
+
+	for (i = 0; i < 512; i++)
+		buf[i] = 0;
+	ata_set_word(buf, 0, ATA_SCT_ACTION_ERC);
+	ata_set_word(buf, 1, set ? ATA_SCT_ERC_FUNCTION_SET : ATA_SCT_ERC_FUNCTION_GET);
+	ata_set_word(buf, 2, selection);
+	if (set)
+		ata_set_word(buf, 3, time_limit);
+
+	return cdb_ata_smart_write_log(cdb, ATA_SCT_LOG_ADDR, 1, !set);
+}
+
+bool ata_sct_erc_get_result(unsigned char *sense, int sense_len, uint16_t *time_limit);
+
+#define ATA_SET_FEATURES_READ_LOOK_AHEAD_DISABLE 0x55
+#define ATA_SET_FEATURES_READ_LOOK_AHEAD_ENABLE 0xAA
+
+static inline int cdb_ata_set_features(unsigned char *cdb, uint8_t feature, uint8_t sector_count)
+{
+	return cdb_ata_passthrough_12(cdb, 0xEF, feature, 0, sector_count, PT_PROTO_NON_DATA, false, 0);
+}
+
+static inline bool ata_identify_read_look_ahead_supported(const unsigned char *identify)
+{
+	return ata_get_bit(identify, 82, 6);
+}
+
+static inline bool ata_identify_read_look_ahead_enabled(const unsigned char *identify)
+{
+	return ata_get_bit(identify, 85, 6);
+}
+
+static inline bool ata_identify_write_cache_enabled(const unsigned char *identify)
+{
+	return ata_get_bit(identify, 85, 5);
+}
+
 static inline int cdb_ata_check_power_mode(unsigned char *cdb)
 {
 	return cdb_ata_passthrough_12(cdb, 0xE5, 0, 0, 0, PT_PROTO_NON_DATA, true, 1);
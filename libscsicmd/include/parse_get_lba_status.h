@@ -0,0 +1,85 @@
+/* Copyright 2026 libscsicmd contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef LIBSCSICMD_GET_LBA_STATUS_H
+#define LIBSCSICMD_GET_LBA_STATUS_H
+
+#include "scsicmd_utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* GET LBA STATUS (SBC-3), the descriptors cover consecutive extents from the start LBA */
+
+#define GET_LBA_STATUS_HDR_LEN 8
+#define GET_LBA_STATUS_DESC_LEN 16
+
+typedef enum {
+	LBA_STATUS_MAPPED = 0,
+	LBA_STATUS_DEALLOCATED = 1,
+	LBA_STATUS_ANCHORED = 2,
+} lba_status_e;
+
+const char *lba_status_to_str(uint8_t status);
+
+/* Length of the data that follows the length field itself */
+static inline uint32_t get_lba_status_param_len(uint8_t *data)
+{
+	return get_uint32(data, 0);
+}
+
+static inline bool get_lba_status_is_valid(uint8_t *data, unsigned data_len)
+{
+	if (data_len < GET_LBA_STATUS_HDR_LEN)
+		return false;
+	if (get_lba_status_param_len(data) < GET_LBA_STATUS_HDR_LEN - 4)
+		return false;
+	if ((get_lba_status_param_len(data) - (GET_LBA_STATUS_HDR_LEN - 4)) % GET_LBA_STATUS_DESC_LEN != 0)
+		return false;
+	return true;
+}
+
+static inline unsigned get_lba_status_num_descs(uint8_t *data, unsigned data_len)
+{
+	const unsigned len = safe_len(data, data_len, data + GET_LBA_STATUS_HDR_LEN, get_lba_status_param_len(data) - (GET_LBA_STATUS_HDR_LEN - 4));
+	return len / GET_LBA_STATUS_DESC_LEN;
+}
+
+static inline uint8_t *get_lba_status_desc(uint8_t *data, unsigned idx)
+{
+	return data + GET_LBA_STATUS_HDR_LEN + idx * GET_LBA_STATUS_DESC_LEN;
+}
+
+static inline uint64_t lba_status_desc_start_lba(uint8_t *desc)
+{
+	return get_uint64(desc, 0);
+}
+
+static inline uint32_t lba_status_desc_num_blocks(uint8_t *desc)
+{
+	return get_uint32(desc, 8);
+}
+
+static inline uint8_t lba_status_desc_status(uint8_t *desc)
+{
+	return desc[12] & 0x0F;
+}
+
+#define for_all_get_lba_status_descs(data, data_len, desc, idx) \
+	for (idx = 0, desc = get_lba_status_desc(data, 0); \
+	     idx < get_lba_status_num_descs(data, data_len); \
+	     idx++, desc = get_lba_status_desc(data, idx))
+
+#endif
@@ -21,6 +21,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* Log Pages */
+#define LOG_SENSE_PAGE_SUPPORTED 0x00
+#define LOG_SENSE_PAGE_WRITE_ERRORS 0x02
+#define LOG_SENSE_PAGE_READ_ERRORS 0x03
+#define LOG_SENSE_PAGE_VERIFY_ERRORS 0x05
+#define LOG_SENSE_PAGE_TEMPERATURE 0x0D
+#define LOG_SENSE_PAGE_INFORMATIONAL_EXCEPTIONS 0x2F
+
 /* Log Sense Header decode */
 
 #define LOG_SENSE_MIN_LEN 4
@@ -57,7 +65,7 @@ static inline uint8_t *log_sense_data(uint8_t *data)
 
 static inline uint8_t *log_sense_data_end(uint8_t *data, unsigned data_len)
 {
-	return data + safe_len(data, data_len, log_sense_data(data), log_sense_data_len(data));
+	return log_sense_data(data) + safe_len(data, data_len, log_sense_data(data), log_sense_data_len(data));
 }
 
 static inline bool log_sense_is_valid(uint8_t *data, unsigned data_len)
@@ -138,6 +146,24 @@ static inline bool log_sense_param_is_valid(uint8_t *data, unsigned data_len, ui
 	return true;
 }
 
+/* Counters are big-endian of any length, only the low 64 bits are kept */
+static inline uint64_t log_sense_param_counter(uint8_t *param)
+{
+	uint8_t *data = log_sense_param_data(param);
+	unsigned len = log_sense_param_len(param);
+	uint64_t val = 0;
+	unsigned i;
+
+	if (len > 8) {
+		data += len - 8;
+		len = 8;
+	}
+
+	for (i = 0; i < len; i++)
+		val = (val << 8) | data[i];
+	return val;
+}
+
 #define for_all_log_sense_params(data, data_len, param) \
 	for (param = log_sense_data(data); \
 		 log_sense_param_is_valid(data, data_len, param); \
@@ -153,4 +179,21 @@ static inline bool log_sense_param_is_valid(uint8_t *data, unsigned data_len, ui
 
 bool log_sense_page_informational_exceptions(uint8_t *page, unsigned page_len, uint8_t *asc, uint8_t *ascq, uint8_t *temperature);
 
+/* Temperature values of 0xFF mean the temperature is not available */
+#define LOG_SENSE_TEMPERATURE_INVALID 0xFF
+bool log_sense_page_temperature(uint8_t *page, unsigned page_len, uint8_t *temperature, uint8_t *reference_temperature);
+
+/* Write, Read and Verify Error Counter pages share the same parameters */
+typedef struct log_sense_error_counters_t {
+	uint64_t corrected_fast;         /* 0000h Errors corrected without substantial delay */
+	uint64_t corrected_delayed;      /* 0001h Errors corrected with possible delays */
+	uint64_t total_retries;          /* 0002h Total rewrites or rereads */
+	uint64_t total_corrected;        /* 0003h Total errors corrected */
+	uint64_t correction_invocations; /* 0004h Total times correction algorithm processed */
+	uint64_t bytes_processed;        /* 0005h Total bytes processed */
+	uint64_t total_uncorrected;      /* 0006h Total uncorrected errors */
+} log_sense_error_counters_t;
+
+bool log_sense_page_error_counters(uint8_t *page, unsigned page_len, log_sense_error_counters_t *counters);
+
 #endif
@@ -78,6 +78,9 @@ static inline bool mode_sense_6_is_valid_header(uint8_t *data, unsigned data_len
 	return true;
 }
 
+/* DPOFUA bit of the device specific parameter of a direct access device */
+#define MODE_SENSE_DEVICE_DPOFUA 0x10
+
 /* Mode parameter header for the MODE SENSE 10 */
 #define MODE_SENSE_10_MIN_LEN 8u
 
@@ -213,6 +216,87 @@ static inline bool mode_sense_data_param_is_valid(uint8_t *data, unsigned data_l
 	return true;
 }
 
+/* Read-Write Error Recovery mode page, the offsets are of the page parameters */
+#define MODE_PAGE_RW_ERROR_RECOVERY 0x01
+#define MODE_PAGE_RW_ERROR_RECOVERY_LEN 12
+
+#define RW_ERROR_RECOVERY_AWRE 0x80
+#define RW_ERROR_RECOVERY_ARRE 0x40
+#define RW_ERROR_RECOVERY_TB   0x20
+#define RW_ERROR_RECOVERY_RC   0x10
+#define RW_ERROR_RECOVERY_EER  0x08
+#define RW_ERROR_RECOVERY_PER  0x04
+#define RW_ERROR_RECOVERY_DTE  0x02
+#define RW_ERROR_RECOVERY_DCR  0x01
+
+static inline uint8_t rw_error_recovery_flags(uint8_t *param)
+{
+	return param[0];
+}
+
+static inline uint8_t rw_error_recovery_read_retry_count(uint8_t *param)
+{
+	return param[1];
+}
+
+static inline uint8_t rw_error_recovery_write_retry_count(uint8_t *param)
+{
+	return param[6];
+}
+
+/* In msec, 0 is the vendor default */
+static inline uint16_t rw_error_recovery_time_limit(uint8_t *param)
+{
+	return get_uint16(param, 8);
+}
+
+static inline void rw_error_recovery_set_flags(uint8_t *param, uint8_t flags)
+{
+	param[0] = flags;
+}
+
+static inline void rw_error_recovery_set_read_retry_count(uint8_t *param, uint8_t count)
+{
+	param[1] = count;
+}
+
+static inline void rw_error_recovery_set_write_retry_count(uint8_t *param, uint8_t count)
+{
+	param[6] = count;
+}
+
+static inline void rw_error_recovery_set_time_limit(uint8_t *param, uint16_t msec)
+{
+	param[8] = msec >> 8;
+	param[9] = msec & 0xFF;
+}
+/* Caching mode page, the offsets are of the page parameters */
+#define MODE_PAGE_CACHING 0x08
+#define MODE_PAGE_CACHING_LEN 20
+
+#define CACHING_WCE 0x04
+#define CACHING_RCD 0x01
+#define CACHING_DRA 0x20
+
+static inline bool caching_write_cache_enabled(uint8_t *param)
+{
+	return param[0] & CACHING_WCE;
+}
+
+static inline bool caching_read_cache_disabled(uint8_t *param)
+{
+	return param[0] & CACHING_RCD;
+}
+
+static inline bool caching_read_ahead_disabled(uint8_t *param)
+{
+	return param[10] & CACHING_DRA;
+}
+
+static inline void caching_set_read_ahead_disabled(uint8_t *param, bool disabled)
+{
+	param[10] = disabled ? (param[10] | CACHING_DRA) : (param[10] & ~CACHING_DRA);
+}
 
 #define for_all_mode_sense_pages(data, data_len, mode_data, mode_data_len, page, remaining_len) \
 	for (remaining_len = mode_data - data + safe_len(data, data_len, mode_data, mode_data_len), page = mode_data; \
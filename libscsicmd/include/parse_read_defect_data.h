@@ -131,7 +131,7 @@ static inline uint32_t format_address_short_lba(uint8_t *data)
 
 /* Long format */
 #define FORMAT_ADDRESS_LONG_LEN 8
-static inline uint32_t format_address_long_lba(uint8_t *data)
+static inline uint64_t format_address_long_lba(uint8_t *data)
 {
 	return get_uint64(data, 0);
 }
@@ -0,0 +1,159 @@
+/* Copyright 2026 libscsicmd contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef LIBSCSICMD_REPORT_ZONES_H
+#define LIBSCSICMD_REPORT_ZONES_H
+
+#include "scsicmd_utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* REPORT ZONES (ZBC), ATA ZAC disks get the same data through the SAT layer */
+
+#define REPORT_ZONES_HDR_LEN 64
+#define REPORT_ZONES_DESC_LEN 64
+
+typedef enum {
+	ZONE_LIST_SAME_NONE = 0,      /* Zone type and length may differ */
+	ZONE_LIST_SAME_ALL = 1,       /* All zones have the same type and length */
+	ZONE_LIST_SAME_LAST_DIFF = 2, /* Same as the first except the last zone length */
+	ZONE_LIST_SAME_LEN = 3,       /* Same length, types may differ */
+} zone_list_same_e;
+
+typedef enum {
+	ZONE_TYPE_CONVENTIONAL = 1,
+	ZONE_TYPE_SEQ_WRITE_REQUIRED = 2,
+	ZONE_TYPE_SEQ_WRITE_PREFERRED = 3,
+} zone_type_e;
+
+typedef enum {
+	ZONE_COND_NOT_WP = 0x0,
+	ZONE_COND_EMPTY = 0x1,
+	ZONE_COND_IMPLICIT_OPEN = 0x2,
+	ZONE_COND_EXPLICIT_OPEN = 0x3,
+	ZONE_COND_CLOSED = 0x4,
+	ZONE_COND_READ_ONLY = 0xD,
+	ZONE_COND_FULL = 0xE,
+	ZONE_COND_OFFLINE = 0xF,
+} zone_cond_e;
+
+const char *zone_type_to_str(uint8_t type);
+const char *zone_cond_to_str(uint8_t cond);
+
+static inline uint32_t report_zones_list_len(uint8_t *data)
+{
+	return get_uint32(data, 0);
+}
+
+static inline uint8_t report_zones_same(uint8_t *data)
+{
+	return data[4] & 0x0F;
+}
+
+static inline uint64_t report_zones_max_lba(uint8_t *data)
+{
+	return get_uint64(data, 8);
+}
+
+static inline bool report_zones_is_valid(uint8_t *data, unsigned data_len)
+{
+	if (data_len < REPORT_ZONES_HDR_LEN)
+		return false;
+	if (report_zones_list_len(data) % REPORT_ZONES_DESC_LEN != 0)
+		return false;
+	return true;
+}
+
+/* The list length is of all the zones from the start LBA, the buffer may hold only part of them */
+static inline unsigned report_zones_num_descs(uint8_t *data, unsigned data_len)
+{
+	const unsigned len = safe_len(data, data_len, data + REPORT_ZONES_HDR_LEN, report_zones_list_len(data));
+	return len / REPORT_ZONES_DESC_LEN;
+}
+
+static inline uint8_t *report_zones_desc(uint8_t *data, unsigned idx)
+{
+	return data + REPORT_ZONES_HDR_LEN + idx * REPORT_ZONES_DESC_LEN;
+}
+
+static inline uint8_t zone_desc_type(uint8_t *desc)
+{
+	return desc[0] & 0x0F;
+}
+
+static inline uint8_t zone_desc_cond(uint8_t *desc)
+{
+	return desc[1] >> 4;
+}
+
+static inline bool zone_desc_non_seq(uint8_t *desc)
+{
+	return desc[1] & 0x02;
+}
+
+static inline bool zone_desc_reset_recommended(uint8_t *desc)
+{
+	return desc[1] & 0x01;
+}
+
+static inline uint64_t zone_desc_len(uint8_t *desc)
+{
+	return get_uint64(desc, 8);
+}
+
+static inline uint64_t zone_desc_start_lba(uint8_t *desc)
+{
+	return get_uint64(desc, 16);
+}
+
+static inline uint64_t zone_desc_write_pointer(uint8_t *desc)
+{
+	return get_uint64(desc, 24);
+}
+
+/* Number of blocks from the zone start that hold data and can be read.
+ * A conventional or read only zone is read whole, a sequential zone up to its write pointer and an offline zone not at all.
+ */
+static inline uint64_t zone_desc_readable_len(uint8_t *desc)
+{
+	const uint64_t start = zone_desc_start_lba(desc);
+	const uint64_t len = zone_desc_len(desc);
+	const uint64_t wp = zone_desc_write_pointer(desc);
+
+	if (zone_desc_type(desc) == ZONE_TYPE_CONVENTIONAL)
+		return len;
+
+	switch (zone_desc_cond(desc)) {
+		case ZONE_COND_NOT_WP:
+		case ZONE_COND_READ_ONLY:
+		case ZONE_COND_FULL:
+			return len;
+		case ZONE_COND_EMPTY:
+		case ZONE_COND_OFFLINE:
+			return 0;
+		default:
+			if (wp < start)
+				return 0;
+			return wp - start < len ? wp - start : len;
+	}
+}
+
+#define for_all_report_zones_descs(data, data_len, desc, idx) \
+	for (idx = 0, desc = report_zones_desc(data, 0); \
+	     idx < report_zones_num_descs(data, data_len); \
+	     idx++, desc = report_zones_desc(data, idx))
+
+#endif
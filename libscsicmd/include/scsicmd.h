@@ -41,6 +41,14 @@ enum sense_key_e {
 #undef SENSE_KEY_MAP
 
 const char *sense_key_to_name(enum sense_key_e sense_key);
+/* Buffer length that holds any name returned by asc_num_to_name_r */
+#define ASC_NUM_NAME_LEN 64
+
+/* The name of the ASC/ASCQ, fixed codes return a constant string and codes with
+ * a variable part are formatted into buf. Safe to call from multiple threads.
+ */
+const char *asc_num_to_name_r(uint8_t asc, uint8_t ascq, char *buf, unsigned buf_len);
+/* Same as asc_num_to_name_r with an internal static buffer, not thread safe */
 const char *asc_num_to_name(uint8_t asc, uint8_t ascq);
 
 int cdb_tur(unsigned char *cdb);
@@ -197,12 +205,31 @@ static inline bool parse_read_capacity_16_simple(unsigned char *buf, unsigned bu
 	return parse_read_capacity_16(buf, buf_len, max_lba, block_size, 0, 0, 0, 0, 0, 0, 0);
 }
 
+/* get lba status, the provisioning status of the extents from the start LBA, expects at least 24 bytes */
+int cdb_get_lba_status(unsigned char *cdb, uint64_t start_lba, uint32_t alloc_len);
+
 /* read & write */
 int cdb_read_10(unsigned char *cdb, bool fua, uint64_t lba, uint16_t transfer_length_blocks);
 int cdb_write_10(unsigned char *cdb, bool fua, uint64_t lba, uint16_t transfer_length_blocks);
 int cdb_read_16(unsigned char *cdb, bool fua, bool fua_nv, bool dpo, uint64_t lba, uint32_t transfer_length_blocks);
 int cdb_write_16(unsigned char *cdb, bool dpo, bool fua, bool fua_nv, uint64_t lba, uint32_t transfer_length_blocks);
 
+/* report zones */
+typedef enum {
+	REPORT_ZONES_ALL = 0x00,
+	REPORT_ZONES_EMPTY = 0x01,
+	REPORT_ZONES_IMPLICIT_OPEN = 0x02,
+	REPORT_ZONES_EXPLICIT_OPEN = 0x03,
+	REPORT_ZONES_CLOSED = 0x04,
+	REPORT_ZONES_FULL = 0x05,
+	REPORT_ZONES_READ_ONLY = 0x06,
+	REPORT_ZONES_OFFLINE = 0x07,
+	REPORT_ZONES_RWP_RECOMMENDED = 0x10,
+	REPORT_ZONES_NON_SEQ = 0x11,
+	REPORT_ZONES_NOT_WP = 0x3F,
+} report_zones_option_e;
+int cdb_report_zones(unsigned char *cdb, uint64_t zone_start_lba, uint32_t alloc_len, report_zones_option_e option, bool partial);
+
 /* log sense */
 int cdb_log_sense(unsigned char *cdb, uint8_t page_code, uint8_t subpage_code, uint16_t alloc_len);
 
@@ -216,6 +243,10 @@ typedef enum {
 int cdb_mode_sense_6(unsigned char *cdb, bool disable_block_descriptor, page_control_e page_control, uint8_t page_code, uint8_t subpage_code, uint8_t alloc_len);
 int cdb_mode_sense_10(unsigned char *cdb, bool long_lba_accepted, bool disable_block_descriptor, page_control_e page_control, uint8_t page_code, uint8_t subpage_code, uint16_t alloc_len);
 
+/* mode select, page_format is required for the standard mode pages and save_pages makes the change persistent */
+int cdb_mode_select_6(unsigned char *cdb, bool page_format, bool save_pages, uint8_t param_len);
+int cdb_mode_select_10(unsigned char *cdb, bool page_format, bool save_pages, uint16_t param_len);
+
 /* send/receive diagnostics */
 int cdb_receive_diagnostics(unsigned char *cdb, bool page_code_valid, uint8_t page_code, uint16_t alloc_len);
 
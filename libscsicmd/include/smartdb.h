@@ -14,10 +14,15 @@ typedef enum smart_attr_type {
 	SMART_ATTR_TYPE_REALLOC_PENDING,
 	SMART_ATTR_TYPE_CRC_ERRORS,
 } smart_attr_type_e;
+#define SMART_ATTR_TYPE_NUM (SMART_ATTR_TYPE_CRC_ERRORS+1)
 
 typedef enum smart_attr_raw {
 	SMART_ATTR_RAW_HEX48,
 	SMART_ATTR_RAW_DEC48,
+	SMART_ATTR_RAW_TEMPMINMAX,   /* Current temperature in the low word, lifetime min and max in the next two words */
+	SMART_ATTR_RAW_RAW16,        /* Only the low word is meaningful */
+	SMART_ATTR_RAW_RAW8,         /* Only the low byte is meaningful */
+	SMART_ATTR_RAW_MSEC24HOUR32, /* Hours in the low 32 bits and milliseconds in the next 24 bits */
 } smart_attr_raw_e;
 
 struct smart_attr {
@@ -30,11 +35,17 @@ struct smart_attr {
 
 struct smart_table {
 	int num_attrs;
-	smart_attr_t attrs[30];
+	smart_attr_t attrs[40];
+	/* Generated lookup indexes, hold the position in attrs plus one, zero if there is no such attribute */
+	uint8_t id_index[256];
+	uint8_t type_index[SMART_ATTR_TYPE_NUM];
 };
 
 const smart_table_t *smart_table_for_disk(const char *vendor, const char *model, const char *firmware);
 const smart_attr_t *smart_attr_for_id(const smart_table_t *table, uint8_t id);
 const smart_attr_t *smart_attr_for_type(const smart_table_t *table, smart_attr_type_e attr_type);
 
+/* Decode the 48-bit raw value of an attribute according to its raw format */
+uint64_t smart_attr_raw_value(const smart_attr_t *attr, uint64_t raw);
+
 #endif
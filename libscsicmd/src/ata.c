@@ -67,6 +67,21 @@ bool ata_status_from_scsi_sense(unsigned char *sense, int sense_len, ata_status_
         return false;
 }
 
+bool ata_sct_erc_get_result(unsigned char *sense, int sense_len, uint16_t *time_limit)
+{
+	ata_status_t status;
+
+	if (!ata_status_from_scsi_sense(sense, sense_len, &status))
+		return false;
+
+	// The error bit means the drive rejected the SCT command
+	if (status.status & 0x01)
+		return false;
+
+	*time_limit = (status.sector_count & 0xFF) | ((status.lba & 0xFF) << 8);
+	return true;
+}
+
 /* ATA SMART READ DATA */
 
 uint16_t ata_get_ata_smart_read_data_version(const unsigned char *buf)
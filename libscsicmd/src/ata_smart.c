@@ -31,7 +31,7 @@ static int ata_smart_get_simple(const ata_smart_attr_t *attrs, int num_attrs, co
 	if (attr_info == NULL)
 		return -1;
 
-	return smart_attr->raw;
+	return smart_attr_raw_value(attr_info, smart_attr->raw);
 }
 
 int ata_smart_get_temperature(const ata_smart_attr_t *attrs, int num_attrs, const smart_table_t *table, int *pmin_temp, int *pmax_temp)
@@ -44,18 +44,25 @@ int ata_smart_get_temperature(const ata_smart_attr_t *attrs, int num_attrs, cons
 		return -1;
 
 	// Temperature is some offset minus the current value, usually
-	int temp = attr_info->offset - smart_attr->value;
+	int temp = attr_info->offset > 0 ? attr_info->offset - smart_attr->value : -1;
 	*pmin_temp = *pmax_temp = -1;
 
-	if (smart_attr->raw) {
-		int min_temp = (smart_attr->raw >> 16) & 0xFFFF;
-		int max_temp = (smart_attr->raw >> 32) & 0xFFFF;
+	// The raw value is more accurate when the disk provides it, only the low word is the current temperature
+	uint64_t raw = smart_attr_raw_value(attr_info, smart_attr->raw);
+	if (attr_info->raw == SMART_ATTR_RAW_HEX48 || attr_info->raw == SMART_ATTR_RAW_DEC48)
+		raw &= 0xFFFF;
 
-		temp = smart_attr->raw & 0xFFFF;
+	if (raw) {
+		temp = raw;
 
-		if (max_temp >= temp && min_temp <= temp) {
-			*pmin_temp = min_temp;
-			*pmax_temp = max_temp;
+		if (attr_info->raw == SMART_ATTR_RAW_TEMPMINMAX) {
+			int min_temp = (smart_attr->raw >> 16) & 0xFFFF;
+			int max_temp = (smart_attr->raw >> 32) & 0xFFFF;
+
+			if (max_temp >= temp && min_temp <= temp) {
+				*pmin_temp = min_temp;
+				*pmax_temp = max_temp;
+			}
 		}
 	}
 	return temp;
@@ -63,8 +70,19 @@ int ata_smart_get_temperature(const ata_smart_attr_t *attrs, int num_attrs, cons
 
 int ata_smart_get_power_on_hours(const ata_smart_attr_t *attrs, int num_attrs, const smart_table_t *table, int *pminutes)
 {
+	const smart_attr_t *attr_info;
+	const ata_smart_attr_t *smart_attr;
+
 	*pminutes = -1;
-	return ata_smart_get_simple(attrs, num_attrs, table, SMART_ATTR_TYPE_POH);
+
+	attr_info = ata_smart_get(attrs, num_attrs, table, &smart_attr, SMART_ATTR_TYPE_POH);
+	if (attr_info == NULL)
+		return -1;
+
+	if (attr_info->raw == SMART_ATTR_RAW_MSEC24HOUR32)
+		*pminutes = ((smart_attr->raw >> 32) & 0xFFFFFF) / (60*1000);
+
+	return smart_attr_raw_value(attr_info, smart_attr->raw);
 }
 
 int ata_smart_get_num_reallocations(const ata_smart_attr_t *attrs, int num_attrs, const smart_table_t *table)
@@ -82,6 +82,18 @@ int cdb_read_capacity_16(unsigned char *cdb, uint32_t alloc_len)
 	return LEN;
 }
 
+int cdb_get_lba_status(unsigned char *cdb, uint64_t start_lba, uint32_t alloc_len)
+{
+	const int LEN = 16;
+	cdb[0] = 0x9E;
+	cdb[1] = 0x12;
+	set_uint64(cdb, 2, start_lba);
+	set_uint32(cdb, 10, alloc_len);
+	cdb[14] = 0;
+	cdb[15] = 0;
+	return LEN;
+}
+
 int cdb_read_10(unsigned char *cdb, bool fua, uint64_t lba, uint16_t transfer_length_blocks)
 {
 	const int LEN = 10;
@@ -190,6 +202,41 @@ int cdb_mode_sense_10(unsigned char *cdb, bool long_lba_accepted, bool disable_b
 	return LEN;
 }
 
+int cdb_report_zones(unsigned char *cdb, uint64_t zone_start_lba, uint32_t alloc_len, report_zones_option_e option, bool partial)
+{
+	const int LEN = 16;
+	cdb[0] = 0x95;
+	cdb[1] = 0x00;
+	set_uint64(cdb, 2, zone_start_lba);
+	set_uint32(cdb, 10, alloc_len);
+	cdb[14] = (partial ? 0x80 : 0) | option;
+	cdb[15] = 0;
+	return LEN;
+}
+
+int cdb_mode_select_6(unsigned char *cdb, bool page_format, bool save_pages, uint8_t param_len)
+{
+	const int LEN = 6;
+	cdb[0] = 0x15;
+	cdb[1] = (page_format ? 1<<4 : 0) | (save_pages ? 1 : 0);
+	cdb[2] = 0;
+	cdb[3] = 0;
+	cdb[4] = param_len;
+	cdb[5] = 0;
+	return LEN;
+}
+
+int cdb_mode_select_10(unsigned char *cdb, bool page_format, bool save_pages, uint16_t param_len)
+{
+	const int LEN = 10;
+	cdb[0] = 0x55;
+	cdb[1] = (page_format ? 1<<4 : 0) | (save_pages ? 1 : 0);
+	cdb[2] = cdb[3] = cdb[4] = cdb[5] = cdb[6] = 0;
+	set_uint16(cdb, 7, param_len);
+	cdb[9] = 0;
+	return LEN;
+}
+
 int cdb_read_defect_data_10(unsigned char *cdb, bool plist, bool glist, address_desc_format_e format, uint16_t alloc_len)
 {
 	const int LEN = 10;
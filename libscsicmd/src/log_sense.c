@@ -1,10 +1,11 @@
 #include "parse_log_sense.h"
+#include <memory.h>
 
 bool log_sense_page_informational_exceptions(uint8_t *page, unsigned page_len, uint8_t *asc, uint8_t *ascq, uint8_t *temperature)
 {
 	if (!log_sense_is_valid(page, page_len))
 		return false;
-	if (log_sense_page_code(page) != 0x2F)
+	if (log_sense_page_code(page) != LOG_SENSE_PAGE_INFORMATIONAL_EXCEPTIONS)
 		return false;
 	if (log_sense_subpage_format(page) && log_sense_subpage_code(page) != 0)
 		return false;
@@ -23,4 +24,72 @@ bool log_sense_page_informational_exceptions(uint8_t *page, unsigned page_len, u
 	return false;
 }
 
+bool log_sense_page_temperature(uint8_t *page, unsigned page_len, uint8_t *temperature, uint8_t *reference_temperature)
+{
+	bool found = false;
+
+	if (!log_sense_is_valid(page, page_len))
+		return false;
+	if (log_sense_page_code(page) != LOG_SENSE_PAGE_TEMPERATURE)
+		return false;
+	if (log_sense_subpage_format(page) && log_sense_subpage_code(page) != 0)
+		return false;
+
+	*temperature = LOG_SENSE_TEMPERATURE_INVALID;
+	*reference_temperature = LOG_SENSE_TEMPERATURE_INVALID;
+
+	uint8_t *param;
+	for_all_log_sense_params(page, page_len, param) {
+		if (log_sense_param_len(param) < 2)
+			continue;
+
+		uint8_t *param_data = log_sense_param_data(param);
+		switch (log_sense_param_code(param)) {
+			case 0:
+				*temperature = param_data[1];
+				found = true;
+				break;
+			case 1:
+				*reference_temperature = param_data[1];
+				break;
+		}
+	}
+
+	return found;
+}
 
+bool log_sense_page_error_counters(uint8_t *page, unsigned page_len, log_sense_error_counters_t *counters)
+{
+	if (!log_sense_is_valid(page, page_len))
+		return false;
+
+	switch (log_sense_page_code(page)) {
+		case LOG_SENSE_PAGE_WRITE_ERRORS:
+		case LOG_SENSE_PAGE_READ_ERRORS:
+		case LOG_SENSE_PAGE_VERIFY_ERRORS:
+			break;
+		default:
+			return false;
+	}
+	if (log_sense_subpage_format(page) && log_sense_subpage_code(page) != 0)
+		return false;
+
+	memset(counters, 0, sizeof(*counters));
+
+	uint8_t *param;
+	for_all_log_sense_params(page, page_len, param) {
+		const uint64_t val = log_sense_param_counter(param);
+
+		switch (log_sense_param_code(param)) {
+			case 0: counters->corrected_fast = val; break;
+			case 1: counters->corrected_delayed = val; break;
+			case 2: counters->total_retries = val; break;
+			case 3: counters->total_corrected = val; break;
+			case 4: counters->correction_invocations = val; break;
+			case 5: counters->bytes_processed = val; break;
+			case 6: counters->total_uncorrected = val; break;
+		}
+	}
+
+	return true;
+}
@@ -1,4 +1,6 @@
 #include "parse_read_defect_data.h"
+#include "parse_report_zones.h"
+#include "parse_get_lba_status.h"
 
 static const char *defect_data_format_str[] = {
 	"Short",
@@ -17,3 +19,38 @@ const char *read_defect_data_format_to_str(uint8_t fmt)
 		return "Unknown";
 	return defect_data_format_str[fmt];
 }
+
+const char *zone_type_to_str(uint8_t type)
+{
+	switch (type) {
+		case ZONE_TYPE_CONVENTIONAL: return "Conventional";
+		case ZONE_TYPE_SEQ_WRITE_REQUIRED: return "Sequential write required";
+		case ZONE_TYPE_SEQ_WRITE_PREFERRED: return "Sequential write preferred";
+		default: return "Reserved";
+	}
+}
+
+const char *zone_cond_to_str(uint8_t cond)
+{
+	switch (cond) {
+		case ZONE_COND_NOT_WP: return "Not write pointer";
+		case ZONE_COND_EMPTY: return "Empty";
+		case ZONE_COND_IMPLICIT_OPEN: return "Implicitly opened";
+		case ZONE_COND_EXPLICIT_OPEN: return "Explicitly opened";
+		case ZONE_COND_CLOSED: return "Closed";
+		case ZONE_COND_READ_ONLY: return "Read only";
+		case ZONE_COND_FULL: return "Full";
+		case ZONE_COND_OFFLINE: return "Offline";
+		default: return "Reserved";
+	}
+}
+
+const char *lba_status_to_str(uint8_t status)
+{
+	switch (status) {
+		case LBA_STATUS_MAPPED: return "Mapped";
+		case LBA_STATUS_DEALLOCATED: return "Deallocated";
+		case LBA_STATUS_ANCHORED: return "Anchored";
+		default: return "Reserved";
+	}
+}
@@ -3,24 +3,40 @@
 
 const smart_attr_t *smart_attr_for_id(const smart_table_t *table, uint8_t id)
 {
-	int i;
+	const uint8_t idx = table->id_index[id];
 
-	for (i = 0; i < table->num_attrs; i++) {
-		if (table->attrs[i].id == id)
-			return &table->attrs[i];
-	}
-
-	return NULL;
+	if (idx == 0)
+		return NULL;
+	return &table->attrs[idx - 1];
 }
 
 const smart_attr_t *smart_attr_for_type(const smart_table_t *table, smart_attr_type_e attr_type)
 {
-	int i;
+	uint8_t idx;
+
+	if ((unsigned)attr_type >= SMART_ATTR_TYPE_NUM)
+		return NULL;
 
-	for (i = 0; i < table->num_attrs; i++) {
-		if (table->attrs[i].type == attr_type)
-			return &table->attrs[i];
+	idx = table->type_index[attr_type];
+	if (idx == 0)
+		return NULL;
+	return &table->attrs[idx - 1];
+}
+
+uint64_t smart_attr_raw_value(const smart_attr_t *attr, uint64_t raw)
+{
+	switch (attr->raw) {
+		case SMART_ATTR_RAW_TEMPMINMAX:
+		case SMART_ATTR_RAW_RAW16:
+			return raw & 0xFFFF;
+		case SMART_ATTR_RAW_RAW8:
+			return raw & 0xFF;
+		case SMART_ATTR_RAW_MSEC24HOUR32:
+			return raw & 0xFFFFFFFF;
+		case SMART_ATTR_RAW_HEX48:
+		case SMART_ATTR_RAW_DEC48:
+			break;
 	}
 
-	return NULL;
+	return raw & 0xFFFFFFFFFFFFULL;
 }
@@ -1,4 +1,7 @@
 #include "smartdb.h"
+#include <stdio.h>
+#include <fnmatch.h>
+#include <stddef.h>
 static const smart_table_t defaults = {
 .num_attrs = 26,
 .attrs = {
@@ -17,7 +20,7 @@ static const smart_table_t defaults = {
 {.id=191, .type=SMART_ATTR_TYPE_NONE, .name="G Sense Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
 {.id=192, .type=SMART_ATTR_TYPE_NONE, .name="Power Off Retract Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
 {.id=193, .type=SMART_ATTR_TYPE_NONE, .name="Load/Unload Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
-{.id=194, .type=SMART_ATTR_TYPE_TEMP, .name="Temperature", .raw=SMART_ATTR_RAW_DEC48, .offset=150},
+{.id=194, .type=SMART_ATTR_TYPE_TEMP, .name="Temperature", .raw=SMART_ATTR_RAW_TEMPMINMAX, .offset=150},
 {.id=195, .type=SMART_ATTR_TYPE_NONE, .name="Hardware ECC Recovered", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
 {.id=196, .type=SMART_ATTR_TYPE_NONE, .name="Reallocation Event Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
 {.id=197, .type=SMART_ATTR_TYPE_REALLOC_PENDING, .name="Pending Sector Reallocation Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
@@ -28,12 +31,345 @@ static const smart_table_t defaults = {
 {.id=241, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Written", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
 {.id=242, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Read", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
 {.id=254, .type=SMART_ATTR_TYPE_NONE, .name="Free Fall Sensor", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
-}
+},
+.id_index = {
+[1]=1,
+[2]=2,
+[3]=3,
+[4]=4,
+[5]=5,
+[7]=6,
+[8]=7,
+[9]=8,
+[10]=9,
+[11]=10,
+[12]=11,
+[13]=12,
+[191]=13,
+[192]=14,
+[193]=15,
+[194]=16,
+[195]=17,
+[196]=18,
+[197]=19,
+[198]=20,
+[199]=21,
+[200]=22,
+[240]=23,
+[241]=24,
+[242]=25,
+[254]=26,
+},
+.type_index = {
+[SMART_ATTR_TYPE_REALLOC]=5,
+[SMART_ATTR_TYPE_POH]=8,
+[SMART_ATTR_TYPE_TEMP]=16,
+[SMART_ATTR_TYPE_REALLOC_PENDING]=19,
+[SMART_ATTR_TYPE_CRC_ERRORS]=21,
+},
+};
+static const smart_table_t seagate = {
+.num_attrs = 30,
+.attrs = {
+{.id=1, .type=SMART_ATTR_TYPE_NONE, .name="Raw Read Error Rate", .raw=SMART_ATTR_RAW_HEX48, .offset=-1},
+{.id=2, .type=SMART_ATTR_TYPE_NONE, .name="Throughput Performance", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=3, .type=SMART_ATTR_TYPE_NONE, .name="Spin Up Time", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=4, .type=SMART_ATTR_TYPE_NONE, .name="Start/Stop Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=5, .type=SMART_ATTR_TYPE_REALLOC, .name="Reallocated Sectors Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=7, .type=SMART_ATTR_TYPE_NONE, .name="Seek Error Rate", .raw=SMART_ATTR_RAW_HEX48, .offset=-1},
+{.id=8, .type=SMART_ATTR_TYPE_NONE, .name="Seek Time Performance", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=9, .type=SMART_ATTR_TYPE_POH, .name="Power On Hours", .raw=SMART_ATTR_RAW_MSEC24HOUR32, .offset=-1},
+{.id=10, .type=SMART_ATTR_TYPE_NONE, .name="Spin Retry Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=11, .type=SMART_ATTR_TYPE_NONE, .name="Drive Calibration Retry Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=12, .type=SMART_ATTR_TYPE_NONE, .name="Device Power Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=13, .type=SMART_ATTR_TYPE_NONE, .name="Read Soft Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=187, .type=SMART_ATTR_TYPE_NONE, .name="Reported Uncorrectable Errors", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=188, .type=SMART_ATTR_TYPE_NONE, .name="Command Timeout", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=189, .type=SMART_ATTR_TYPE_NONE, .name="High Fly Writes", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=190, .type=SMART_ATTR_TYPE_NONE, .name="Airflow Temperature", .raw=SMART_ATTR_RAW_TEMPMINMAX, .offset=-1},
+{.id=191, .type=SMART_ATTR_TYPE_NONE, .name="G Sense Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=192, .type=SMART_ATTR_TYPE_NONE, .name="Power Off Retract Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=193, .type=SMART_ATTR_TYPE_NONE, .name="Load/Unload Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=194, .type=SMART_ATTR_TYPE_TEMP, .name="Temperature", .raw=SMART_ATTR_RAW_TEMPMINMAX, .offset=150},
+{.id=195, .type=SMART_ATTR_TYPE_NONE, .name="Hardware ECC Recovered", .raw=SMART_ATTR_RAW_HEX48, .offset=-1},
+{.id=196, .type=SMART_ATTR_TYPE_NONE, .name="Reallocation Event Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=197, .type=SMART_ATTR_TYPE_REALLOC_PENDING, .name="Pending Sector Reallocation Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=198, .type=SMART_ATTR_TYPE_NONE, .name="Off-Line Scan Uncorrecable Sector Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=199, .type=SMART_ATTR_TYPE_CRC_ERRORS, .name="CRC Error Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=200, .type=SMART_ATTR_TYPE_NONE, .name="Multi-zone Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=240, .type=SMART_ATTR_TYPE_NONE, .name="Head Flying Hours", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=241, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Written", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=242, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Read", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=254, .type=SMART_ATTR_TYPE_NONE, .name="Free Fall Sensor", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+},
+.id_index = {
+[1]=1,
+[2]=2,
+[3]=3,
+[4]=4,
+[5]=5,
+[7]=6,
+[8]=7,
+[9]=8,
+[10]=9,
+[11]=10,
+[12]=11,
+[13]=12,
+[187]=13,
+[188]=14,
+[189]=15,
+[190]=16,
+[191]=17,
+[192]=18,
+[193]=19,
+[194]=20,
+[195]=21,
+[196]=22,
+[197]=23,
+[198]=24,
+[199]=25,
+[200]=26,
+[240]=27,
+[241]=28,
+[242]=29,
+[254]=30,
+},
+.type_index = {
+[SMART_ATTR_TYPE_REALLOC]=5,
+[SMART_ATTR_TYPE_POH]=8,
+[SMART_ATTR_TYPE_TEMP]=20,
+[SMART_ATTR_TYPE_REALLOC_PENDING]=23,
+[SMART_ATTR_TYPE_CRC_ERRORS]=25,
+},
+};
+static const smart_table_t wdc = {
+.num_attrs = 26,
+.attrs = {
+{.id=1, .type=SMART_ATTR_TYPE_NONE, .name="Raw Read Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=2, .type=SMART_ATTR_TYPE_NONE, .name="Throughput Performance", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=3, .type=SMART_ATTR_TYPE_NONE, .name="Spin Up Time", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=4, .type=SMART_ATTR_TYPE_NONE, .name="Start/Stop Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=5, .type=SMART_ATTR_TYPE_REALLOC, .name="Reallocated Sectors Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=7, .type=SMART_ATTR_TYPE_NONE, .name="Seek Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=8, .type=SMART_ATTR_TYPE_NONE, .name="Seek Time Performance", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=9, .type=SMART_ATTR_TYPE_POH, .name="Power On Hours", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=10, .type=SMART_ATTR_TYPE_NONE, .name="Spin Retry Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=11, .type=SMART_ATTR_TYPE_NONE, .name="Drive Calibration Retry Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=12, .type=SMART_ATTR_TYPE_NONE, .name="Device Power Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=13, .type=SMART_ATTR_TYPE_NONE, .name="Read Soft Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=191, .type=SMART_ATTR_TYPE_NONE, .name="G Sense Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=192, .type=SMART_ATTR_TYPE_NONE, .name="Power Off Retract Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=193, .type=SMART_ATTR_TYPE_NONE, .name="Load/Unload Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=194, .type=SMART_ATTR_TYPE_TEMP, .name="Temperature", .raw=SMART_ATTR_RAW_RAW16, .offset=150},
+{.id=195, .type=SMART_ATTR_TYPE_NONE, .name="Hardware ECC Recovered", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=196, .type=SMART_ATTR_TYPE_NONE, .name="Reallocation Event Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=197, .type=SMART_ATTR_TYPE_REALLOC_PENDING, .name="Pending Sector Reallocation Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=198, .type=SMART_ATTR_TYPE_NONE, .name="Off-Line Scan Uncorrecable Sector Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=199, .type=SMART_ATTR_TYPE_CRC_ERRORS, .name="CRC Error Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=200, .type=SMART_ATTR_TYPE_NONE, .name="Multi-zone Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=240, .type=SMART_ATTR_TYPE_NONE, .name="Head Flying Hours", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=241, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Written", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=242, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Read", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=254, .type=SMART_ATTR_TYPE_NONE, .name="Free Fall Sensor", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+},
+.id_index = {
+[1]=1,
+[2]=2,
+[3]=3,
+[4]=4,
+[5]=5,
+[7]=6,
+[8]=7,
+[9]=8,
+[10]=9,
+[11]=10,
+[12]=11,
+[13]=12,
+[191]=13,
+[192]=14,
+[193]=15,
+[194]=16,
+[195]=17,
+[196]=18,
+[197]=19,
+[198]=20,
+[199]=21,
+[200]=22,
+[240]=23,
+[241]=24,
+[242]=25,
+[254]=26,
+},
+.type_index = {
+[SMART_ATTR_TYPE_REALLOC]=5,
+[SMART_ATTR_TYPE_POH]=8,
+[SMART_ATTR_TYPE_TEMP]=16,
+[SMART_ATTR_TYPE_REALLOC_PENDING]=19,
+[SMART_ATTR_TYPE_CRC_ERRORS]=21,
+},
+};
+static const smart_table_t samsung_ssd = {
+.num_attrs = 28,
+.attrs = {
+{.id=1, .type=SMART_ATTR_TYPE_NONE, .name="Raw Read Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=2, .type=SMART_ATTR_TYPE_NONE, .name="Throughput Performance", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=3, .type=SMART_ATTR_TYPE_NONE, .name="Spin Up Time", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=4, .type=SMART_ATTR_TYPE_NONE, .name="Start/Stop Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=5, .type=SMART_ATTR_TYPE_REALLOC, .name="Reallocated Sectors Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=7, .type=SMART_ATTR_TYPE_NONE, .name="Seek Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=8, .type=SMART_ATTR_TYPE_NONE, .name="Seek Time Performance", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=9, .type=SMART_ATTR_TYPE_POH, .name="Power On Hours", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=10, .type=SMART_ATTR_TYPE_NONE, .name="Spin Retry Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=11, .type=SMART_ATTR_TYPE_NONE, .name="Drive Calibration Retry Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=12, .type=SMART_ATTR_TYPE_NONE, .name="Device Power Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=13, .type=SMART_ATTR_TYPE_NONE, .name="Read Soft Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=177, .type=SMART_ATTR_TYPE_NONE, .name="Wear Leveling Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=190, .type=SMART_ATTR_TYPE_TEMP, .name="Airflow Temperature", .raw=SMART_ATTR_RAW_RAW8, .offset=-1},
+{.id=191, .type=SMART_ATTR_TYPE_NONE, .name="G Sense Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=192, .type=SMART_ATTR_TYPE_NONE, .name="Power Off Retract Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=193, .type=SMART_ATTR_TYPE_NONE, .name="Load/Unload Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=194, .type=SMART_ATTR_TYPE_NONE, .name="Temperature", .raw=SMART_ATTR_RAW_TEMPMINMAX, .offset=150},
+{.id=195, .type=SMART_ATTR_TYPE_NONE, .name="Hardware ECC Recovered", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=196, .type=SMART_ATTR_TYPE_NONE, .name="Reallocation Event Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=197, .type=SMART_ATTR_TYPE_REALLOC_PENDING, .name="Pending Sector Reallocation Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=198, .type=SMART_ATTR_TYPE_NONE, .name="Off-Line Scan Uncorrecable Sector Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=199, .type=SMART_ATTR_TYPE_CRC_ERRORS, .name="CRC Error Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=200, .type=SMART_ATTR_TYPE_NONE, .name="Multi-zone Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=240, .type=SMART_ATTR_TYPE_NONE, .name="Head Flying Hours", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=241, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Written", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=242, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Read", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=254, .type=SMART_ATTR_TYPE_NONE, .name="Free Fall Sensor", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+},
+.id_index = {
+[1]=1,
+[2]=2,
+[3]=3,
+[4]=4,
+[5]=5,
+[7]=6,
+[8]=7,
+[9]=8,
+[10]=9,
+[11]=10,
+[12]=11,
+[13]=12,
+[177]=13,
+[190]=14,
+[191]=15,
+[192]=16,
+[193]=17,
+[194]=18,
+[195]=19,
+[196]=20,
+[197]=21,
+[198]=22,
+[199]=23,
+[200]=24,
+[240]=25,
+[241]=26,
+[242]=27,
+[254]=28,
+},
+.type_index = {
+[SMART_ATTR_TYPE_REALLOC]=5,
+[SMART_ATTR_TYPE_POH]=8,
+[SMART_ATTR_TYPE_TEMP]=14,
+[SMART_ATTR_TYPE_REALLOC_PENDING]=21,
+[SMART_ATTR_TYPE_CRC_ERRORS]=23,
+},
+};
+static const smart_table_t intel_ssd = {
+.num_attrs = 27,
+.attrs = {
+{.id=1, .type=SMART_ATTR_TYPE_NONE, .name="Raw Read Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=2, .type=SMART_ATTR_TYPE_NONE, .name="Throughput Performance", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=3, .type=SMART_ATTR_TYPE_NONE, .name="Spin Up Time", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=4, .type=SMART_ATTR_TYPE_NONE, .name="Start/Stop Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=5, .type=SMART_ATTR_TYPE_REALLOC, .name="Reallocated Sectors Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=7, .type=SMART_ATTR_TYPE_NONE, .name="Seek Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=8, .type=SMART_ATTR_TYPE_NONE, .name="Seek Time Performance", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=9, .type=SMART_ATTR_TYPE_POH, .name="Power On Hours", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=10, .type=SMART_ATTR_TYPE_NONE, .name="Spin Retry Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=11, .type=SMART_ATTR_TYPE_NONE, .name="Drive Calibration Retry Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=12, .type=SMART_ATTR_TYPE_NONE, .name="Device Power Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=13, .type=SMART_ATTR_TYPE_NONE, .name="Read Soft Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=190, .type=SMART_ATTR_TYPE_TEMP, .name="Temperature Case", .raw=SMART_ATTR_RAW_TEMPMINMAX, .offset=-1},
+{.id=191, .type=SMART_ATTR_TYPE_NONE, .name="G Sense Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=192, .type=SMART_ATTR_TYPE_NONE, .name="Power Off Retract Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=193, .type=SMART_ATTR_TYPE_NONE, .name="Load/Unload Cycle Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=194, .type=SMART_ATTR_TYPE_NONE, .name="Temperature Internal", .raw=SMART_ATTR_RAW_RAW16, .offset=-1},
+{.id=195, .type=SMART_ATTR_TYPE_NONE, .name="Hardware ECC Recovered", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=196, .type=SMART_ATTR_TYPE_NONE, .name="Reallocation Event Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=197, .type=SMART_ATTR_TYPE_REALLOC_PENDING, .name="Pending Sector Reallocation Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=198, .type=SMART_ATTR_TYPE_NONE, .name="Off-Line Scan Uncorrecable Sector Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=199, .type=SMART_ATTR_TYPE_CRC_ERRORS, .name="CRC Error Count", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=200, .type=SMART_ATTR_TYPE_NONE, .name="Multi-zone Error Rate", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=240, .type=SMART_ATTR_TYPE_NONE, .name="Head Flying Hours", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=241, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Written", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=242, .type=SMART_ATTR_TYPE_NONE, .name="Total LBAs Read", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+{.id=254, .type=SMART_ATTR_TYPE_NONE, .name="Free Fall Sensor", .raw=SMART_ATTR_RAW_DEC48, .offset=-1},
+},
+.id_index = {
+[1]=1,
+[2]=2,
+[3]=3,
+[4]=4,
+[5]=5,
+[7]=6,
+[8]=7,
+[9]=8,
+[10]=9,
+[11]=10,
+[12]=11,
+[13]=12,
+[190]=13,
+[191]=14,
+[192]=15,
+[193]=16,
+[194]=17,
+[195]=18,
+[196]=19,
+[197]=20,
+[198]=21,
+[199]=22,
+[200]=23,
+[240]=24,
+[241]=25,
+[242]=26,
+[254]=27,
+},
+.type_index = {
+[SMART_ATTR_TYPE_REALLOC]=5,
+[SMART_ATTR_TYPE_POH]=8,
+[SMART_ATTR_TYPE_TEMP]=13,
+[SMART_ATTR_TYPE_REALLOC_PENDING]=20,
+[SMART_ATTR_TYPE_CRC_ERRORS]=22,
+},
+};
+static const struct {
+const char *model;
+const char *firmware;
+const smart_table_t *table;
+} disk_tables[] = {
+{.model="ST*", .firmware=NULL, .table=&seagate},
+{.model="WDC *", .firmware=NULL, .table=&wdc},
+{.model="Samsung SSD*", .firmware=NULL, .table=&samsung_ssd},
+{.model="INTEL SSD*", .firmware=NULL, .table=&intel_ssd},
 };
 const smart_table_t * smart_table_for_disk(const char *vendor, const char *model, const char *firmware)
 {
-(void)vendor;
-(void)model;
-(void)firmware;
+char full_model[160];
+unsigned i;
+if (vendor == NULL || model == NULL)
+return &defaults;
+// Patterns match against the full model string, the vendor is only split from it for ATA disks
+snprintf(full_model, sizeof(full_model), "%s%s%s", vendor, model[0] && vendor[0] ? " " : "", model);
+for (i = 0; i < sizeof(disk_tables)/sizeof(disk_tables[0]); i++) {
+if (fnmatch(disk_tables[i].model, full_model, 0) != 0)
+continue;
+if (disk_tables[i].firmware && (firmware == NULL || fnmatch(disk_tables[i].firmware, firmware, 0) != 0))
+continue;
+return disk_tables[i].table;
+}
 return &defaults;
 }
@@ -10,10 +10,17 @@ assert root.tag == 'smartdb'
 
 names = {}
 defaults = {}
+disks = []
+
+max_attrs = 40
 
 raw_types = {
         'hex48': 'SMART_ATTR_RAW_HEX48',
         'dec48': 'SMART_ATTR_RAW_DEC48',
+        'tempminmax': 'SMART_ATTR_RAW_TEMPMINMAX',
+        'raw16': 'SMART_ATTR_RAW_RAW16',
+        'raw8': 'SMART_ATTR_RAW_RAW8',
+        'msec24hour32': 'SMART_ATTR_RAW_MSEC24HOUR32',
 }
 raw_type_default = 'dec48'
 def raw_type_to_enum(raw):
@@ -52,7 +59,7 @@ def validate_attr(d, root):
     raw = raw_type_default
     code = attr_code_default
     for child in root:
-        assert child.tag in ('id', 'name', 'raw', 'tempoffset')
+        assert child.tag in ('id', 'name', 'raw', 'tempoffset', 'type')
         if child.tag == 'id':
             val = int(child.text)
             assert val > 0
@@ -71,41 +78,120 @@ def validate_attr(d, root):
             val = int(child.text)
             assert val > 0 and val < 255
             tempoffset = val
-        d[aid] = (aid, name, raw, code, tempoffset)
+        elif child.tag == 'type':
+            val = child.text.strip()
+            assert val in attr_code
+            code = val
+    assert aid is not None and name is not None
+    # Only one attribute of each type, a later attribute takes the type over
+    if code != attr_code_default:
+        for other in list(d.keys()):
+            if other != aid and d[other][3] == code:
+                d[other] = d[other][:3] + (attr_code_default,) + d[other][4:]
+    d[aid] = (aid, name, raw, code, tempoffset)
+
+def validate_disk(root):
+    assert root.tag == 'disk'
+    tname = root.get('name')
+    assert tname is not None and tname.isidentifier() and tname != 'defaults'
+    assert tname not in [disk[0] for disk in disks]
+    model = None
+    firmware = None
+    attrs = dict(defaults)
+    for child in root:
+        assert child.tag in ('model', 'firmware', 'attr')
+        if child.tag == 'model':
+            model = child.text.strip()
+        elif child.tag == 'firmware':
+            firmware = child.text.strip()
+        else:
+            validate_attr(attrs, child)
+    assert model is not None, 'disk %s needs a model pattern' % tname
+    disks.append((tname, model, firmware, attrs))
 
 nodes = {
         'names': validate_name,
         'default': validate_attr,
 }
 
+# Disks are merged on top of the defaults so they are handled after everything else
 for child in root:
+    if child.tag == 'disk':
+        continue
     if child.tag not in list(nodes.keys()):
-        raise 'tag %s is unknown at smartdb level' % child.tag
+        raise ValueError('tag %s is unknown at smartdb level' % child.tag)
     vfunc = nodes.get(child.tag)
     for subchild in child:
         vfunc(defaults, subchild)
 
+for child in root:
+    if child.tag == 'disk':
+        validate_disk(child)
+
+def c_str(val):
+    if val is None:
+        return 'NULL'
+    return '"%s"' % val.replace('\\', '\\\\').replace('"', '\\"')
+
+def print_table(tname, attrs):
+    assert len(attrs) <= max_attrs
+    keys = list(attrs.keys())
+    keys.sort()
+    print('static const smart_table_t %s = {' % tname)
+    print('.num_attrs = %d,' % len(attrs))
+    print('.attrs = {')
+    for aid in keys:
+        attr = attrs[aid]
+        name = attr[1]
+        raw = raw_type_to_enum(attr[2])
+        atype = attr_code_to_enum(attr[3])
+        tempoffset = attr[4]
+        print('{.id=%d, .type=%s, .name="%s", .raw=%s, .offset=%d},' % (aid, atype, name, raw, tempoffset))
+    print('},')
+    print('.id_index = {')
+    for idx, aid in enumerate(keys):
+        print('[%d]=%d,' % (aid, idx + 1))
+    print('},')
+    print('.type_index = {')
+    for idx, aid in enumerate(keys):
+        code = attrs[aid][3]
+        if code != attr_code_default:
+            print('[%s]=%d,' % (attr_code_to_enum(code), idx + 1))
+    print('},')
+    print('};')
+
 print('#include "smartdb.h"')
+print('#include <stdio.h>')
+print('#include <fnmatch.h>')
+print('#include <stddef.h>')
 
-print('static const smart_table_t defaults = {')
-print('.num_attrs = %d,' % len(defaults))
-print('.attrs = {')
-keys = list(defaults.keys())
-keys.sort()
-for aid in keys:
-    attr = defaults[aid]
-    name = attr[1]
-    raw = raw_type_to_enum(attr[2])
-    atype = attr_code_to_enum(attr[3])
-    tempoffset = attr[4]
-    print('{.id=%d, .type=%s, .name="%s", .raw=%s, .offset=%d},' % (aid, atype, name, raw, tempoffset))
-print('}')
+print_table('defaults', defaults)
+for disk in disks:
+    print_table(disk[0], disk[3])
+
+print('static const struct {')
+print('const char *model;')
+print('const char *firmware;')
+print('const smart_table_t *table;')
+print('} disk_tables[] = {')
+for disk in disks:
+    print('{.model=%s, .firmware=%s, .table=&%s},' % (c_str(disk[1]), c_str(disk[2]), disk[0]))
 print('};')
 
 print('const smart_table_t * smart_table_for_disk(const char *vendor, const char *model, const char *firmware)')
 print('{')
-print('(void)vendor;')
-print('(void)model;')
-print('(void)firmware;')
+print('char full_model[160];')
+print('unsigned i;')
+print('if (vendor == NULL || model == NULL)')
+print('return &defaults;')
+print('// Patterns match against the full model string, the vendor is only split from it for ATA disks')
+print('snprintf(full_model, sizeof(full_model), "%s%s%s", vendor, model[0] && vendor[0] ? " " : "", model);')
+print('for (i = 0; i < sizeof(disk_tables)/sizeof(disk_tables[0]); i++) {')
+print('if (fnmatch(disk_tables[i].model, full_model, 0) != 0)')
+print('continue;')
+print('if (disk_tables[i].firmware && (firmware == NULL || fnmatch(disk_tables[i].firmware, firmware, 0) != 0))')
+print('continue;')
+print('return disk_tables[i].table;')
+print('}')
 print('return &defaults;')
 print('}')
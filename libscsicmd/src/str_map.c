@@ -16,10 +16,8 @@ const char *sense_key_to_name(enum sense_key_e sense_key)
 	return "Unknown sense key";
 }
 
-const char *asc_num_to_name(uint8_t asc, uint8_t ascq)
+const char *asc_num_to_name_r(uint8_t asc, uint8_t ascq, char *buf, unsigned buf_len)
 {
-	static char msg[64];
-
 	uint16_t asc_full = asc<<8 | ascq;
 
 	switch (asc_full) {
@@ -30,12 +28,19 @@ const char *asc_num_to_name(uint8_t asc, uint8_t ascq)
 #undef SENSE_CODE_KEYED
 	}
 
-#define SENSE_CODE_KEYED(_asc_, _fmt_) if (asc == _asc_) { snprintf(msg, sizeof(msg), _fmt_, ascq); return msg; }
+#define SENSE_CODE_KEYED(_asc_, _fmt_) if (asc == _asc_) { snprintf(buf, buf_len, _fmt_, ascq); return buf; }
 #define SENSE_CODE(_asc_, _ascq_, _msg_)
 	ASC_NUM_LIST
 #undef SENSE_CODE
 #undef SENSE_CODE_KEYED
 
-	snprintf(msg, sizeof(msg), "UNKNOWN ASC/ASCQ (%02Xh/%02Xh)", asc, ascq);
-	return msg;
+	snprintf(buf, buf_len, "UNKNOWN ASC/ASCQ (%02Xh/%02Xh)", asc, ascq);
+	return buf;
+}
+
+const char *asc_num_to_name(uint8_t asc, uint8_t ascq)
+{
+	static char msg[ASC_NUM_NAME_LEN];
+
+	return asc_num_to_name_r(asc, ascq, msg, sizeof(msg));
 }
@@ -57,7 +57,7 @@ static void emit_data_csv(uint8_t *cdb, uint8_t cdb_len, uint8_t *sense, uint8_t
 	hex_dump(sense, sense_len);
 	putchar(',');
 	hex_dump(buf, buf_len);
-	putchar('\n');
+	printf(",%u\n", last_duration_msec);
 }
 
 static int simple_command(int fd, uint8_t *cdb, unsigned cdb_len, uint8_t *buf, unsigned buf_len)
@@ -326,6 +326,25 @@ static void do_read_capacity(int fd)
 	do_read_capacity_16(fd);
 }
 
+static void do_get_lba_status(int fd)
+{
+	unsigned char cdb[32];
+	unsigned char buf[4096];
+	unsigned cdb_len = cdb_get_lba_status(cdb, 0, sizeof(buf));
+
+	simple_command(fd, cdb, cdb_len, buf, sizeof(buf));
+}
+
+/* Only the first zones, enough to capture the zone types and conditions */
+static void do_report_zones(int fd)
+{
+	unsigned char cdb[32];
+	unsigned char buf[4096];
+	unsigned cdb_len = cdb_report_zones(cdb, 0, sizeof(buf), REPORT_ZONES_ALL, true);
+
+	simple_command(fd, cdb, cdb_len, buf, sizeof(buf));
+}
+
 static void do_read_defect_data_10(int fd, bool plist, bool glist, uint8_t format, bool count_only)
 {
 	unsigned char cdb[32];
@@ -509,7 +528,7 @@ void do_command(int fd)
 	debug = 0;
 	is_ata = false;
 
-	printf("msg,cdb,sense,data\n");
+	printf("msg,cdb,sense,data,duration_msec\n");
 	do_read_capacity(fd);
 	do_simple_inquiry(fd);
 	do_extended_inquiry(fd);
@@ -517,6 +536,8 @@ void do_command(int fd)
 	do_mode_sense(fd);
 	do_receive_diagnostic(fd);
 	do_read_defect_data(fd);
+	do_report_zones(fd);
+	do_get_lba_status(fd);
 
 	if (is_ata) {
 		do_ata_identify(fd);
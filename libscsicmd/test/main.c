@@ -30,6 +30,7 @@
 static unsigned char sense[128];
 
 int debug = 1;
+unsigned last_duration_msec;
 
 bool submit_cmd(int fd, unsigned char *cdb, unsigned cdb_len, unsigned char *buf, unsigned buf_len, int dxfer_dir)
 {
@@ -61,6 +62,7 @@ bool read_response_buf(int fd, unsigned char **sensep, unsigned *sense_len, unsi
 {
 	*sensep = NULL;
 	*sense_len = 0;
+	last_duration_msec = 0;
 
 	sg_io_hdr_t hdr;
 	int ret = read(fd, &hdr, sizeof(hdr));
@@ -87,6 +89,7 @@ bool read_response_buf(int fd, unsigned char **sensep, unsigned *sense_len, unsi
 	}
 	if (buf_read)
 		*buf_read = hdr.dxfer_len - hdr.resid;
+	last_duration_msec = hdr.duration;
 	return true;
 }
 
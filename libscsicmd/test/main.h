@@ -4,6 +4,8 @@
 #include <stdio.h>
 
 extern int debug;
+/** Time the last command took in the device in msec, as reported by the OS. */
+extern unsigned last_duration_msec;
 
 /** Do the command that we want to test on the open disk interface. */
 void do_command(int fd);
@@ -10,6 +10,8 @@
 #include "parse_extended_inquiry.h"
 #include "parse_read_defect_data.h"
 #include "parse_receive_diagnostics.h"
+#include "parse_report_zones.h"
+#include "parse_get_lba_status.h"
 #include "scsicmd.h"
 #include "sense_dump.h"
 
@@ -129,6 +131,21 @@ static void parse_log_sense_param_informational_exceptions(uint16_t param_code,
 	}
 }
 
+static void parse_log_sense_param_temperature(uint16_t param_code, uint8_t *param, uint8_t param_len)
+{
+	if (param_len < 2 || param_code > 1) {
+		unparsed_data(param, param_len, param, param_len);
+		return;
+	}
+
+	if (param[1] == LOG_SENSE_TEMPERATURE_INVALID)
+		printf("%s: not available\n", param_code == 0 ? "Temperature" : "Reference Temperature");
+	else
+		printf("%s: %u\n", param_code == 0 ? "Temperature" : "Reference Temperature", param[1]);
+	if (param_len > 2)
+		unparsed_data(param+2, param_len-2, param, param_len);
+}
+
 static void parse_log_sense_param_ascii(uint8_t *param, unsigned param_len)
 {
 	uint8_t *ascii = log_sense_param_data(param);
@@ -168,7 +185,8 @@ static void parse_log_sense_param(uint8_t page, uint8_t subpage, uint16_t param_
 	(void)subpage;
 
 	switch (page) {
-		case 0x2F: parse_log_sense_param_informational_exceptions(param_code, log_sense_param_data(param), log_sense_param_len(param)); break;
+		case LOG_SENSE_PAGE_TEMPERATURE: parse_log_sense_param_temperature(param_code, log_sense_param_data(param), log_sense_param_len(param)); break;
+		case LOG_SENSE_PAGE_INFORMATIONAL_EXCEPTIONS: parse_log_sense_param_informational_exceptions(param_code, log_sense_param_data(param), log_sense_param_len(param)); break;
 		/* TODO: parse more LOG SENSE pages */
 		default:
 				   switch (log_sense_param_fmt(param)) {
@@ -540,6 +558,63 @@ static int parse_read_defect_data_12(uint8_t *data, unsigned data_len)
 	return 0;
 }
 
+static int parse_report_zones(uint8_t *data, unsigned data_len)
+{
+	uint8_t *desc;
+	unsigned idx;
+
+	printf("Report Zones\n");
+
+	if (!report_zones_is_valid(data, data_len)) {
+		printf("Data is not valid\n");
+		unparsed_data(data, data_len, data, data_len);
+		return 1;
+	}
+
+	printf("Zone list len: %u\n", report_zones_list_len(data));
+	printf("Same: %u\n", report_zones_same(data));
+	printf("Max LBA: %lu\n", report_zones_max_lba(data));
+
+	for_all_report_zones_descs(data, data_len, desc, idx) {
+		printf("\nZone %u\n", idx);
+		printf("Type: %s\n", zone_type_to_str(zone_desc_type(desc)));
+		printf("Condition: %s\n", zone_cond_to_str(zone_desc_cond(desc)));
+		printf("Non sequential: %s\n", yes_no(zone_desc_non_seq(desc)));
+		printf("Reset recommended: %s\n", yes_no(zone_desc_reset_recommended(desc)));
+		printf("Length: %lu\n", zone_desc_len(desc));
+		printf("Start LBA: %lu\n", zone_desc_start_lba(desc));
+		printf("Write pointer: %lu\n", zone_desc_write_pointer(desc));
+		printf("Readable length: %lu\n", zone_desc_readable_len(desc));
+	}
+
+	return 0;
+}
+
+static int parse_get_lba_status(uint8_t *data, unsigned data_len)
+{
+	uint8_t *desc;
+	unsigned idx;
+
+	printf("Get LBA Status\n");
+
+	if (!get_lba_status_is_valid(data, data_len)) {
+		printf("Data is not valid\n");
+		unparsed_data(data, data_len, data, data_len);
+		return 1;
+	}
+
+	printf("Parameter data len: %u\n", get_lba_status_param_len(data));
+
+	for_all_get_lba_status_descs(data, data_len, desc, idx) {
+		printf("\nExtent %u\n", idx);
+		printf("Start LBA: %lu\n", lba_status_desc_start_lba(desc));
+		printf("Num blocks: %u\n", lba_status_desc_num_blocks(desc));
+		printf("Status: %s\n", lba_status_to_str(lba_status_desc_status(desc)));
+	}
+
+	return 0;
+}
+
 static void parse_receive_diagnostic_results_pg_0(uint8_t *data, unsigned data_len)
 {
 	printf("Supported Receive Diagnostic Results pages:\n");
@@ -670,13 +745,26 @@ static void process_data(char *cdb_src, char *sense_src, char *data_src)
 	switch (cdb[0]) {
 		case 0x4D: parse_log_sense(data, data_len); break;
 		case 0x25: parse_read_cap_10(data, data_len); break;
-		case 0x9E: parse_read_cap_16(data, data_len); break;
+		case 0x9E:
+				   if ((cdb[1] & 0x1F) == 0x10)
+					   parse_read_cap_16(data, data_len);
+				   else if ((cdb[1] & 0x1F) == 0x12)
+					   parse_get_lba_status(data, data_len);
+				   else
+					   unparsed_data(data, data_len, data, data_len);
+				   break;
 		case 0x12: parse_inquiry_data(cdb, cdb_len, data, data_len); break;
 		case 0x5A: parse_mode_sense_10(data, data_len); break;
 		case 0x1A: parse_mode_sense_6(data, data_len); break;
 		case 0x1C: parse_receive_diagnostic_results(data, data_len); break;
 		case 0x37: parse_read_defect_data_10(data, data_len); break;
 		case 0xB7: parse_read_defect_data_12(data, data_len); break;
+		case 0x95:
+				   if ((cdb[1] & 0x1F) == 0x00)
+					   parse_report_zones(data, data_len);
+				   else
+					   unparsed_data(data, data_len, data, data_len);
+				   break;
 		default:
 				   printf("Unsupported CDB opcode %02X\n", cdb[0]);
 				   unparsed_data(data, data_len, data, data_len);
@@ -0,0 +1,176 @@
+/* Copyright 2026 libscsicmd contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Benchmark the sense decoding over the sense buffers of the afl test cases.
+ *
+ * Usage: sense_bench <iterations> testcase...
+ *
+ * Each test case is a CSV line of the form ",cdb,sense,data", only the lines with sense
+ * are used. Every iteration parses all the sense buffers and names their sense key and
+ * ASC/ASCQ, then all 64K ASC/ASCQ values are named to cover the keyed and unknown codes.
+ */
+
+#include "scsicmd.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#define MAX_SENSES 4096
+
+typedef struct sense_buf_t {
+	unsigned char sense[256];
+	int sense_len;
+} sense_buf_t;
+
+static sense_buf_t senses[MAX_SENSES];
+static unsigned num_senses;
+
+static int hex_val(char ch)
+{
+	if (ch >= '0' && ch <= '9')
+		return ch - '0';
+	else if (ch >= 'a' && ch <= 'f')
+		return ch - 'a' + 10;
+	else if (ch >= 'A' && ch <= 'F')
+		return ch - 'A' + 10;
+	return -1;
+}
+
+static void load_line(char *line)
+{
+	char *sense_src = strchr(line, ',');
+	if (!sense_src)
+		return;
+	sense_src = strchr(sense_src + 1, ',');
+	if (!sense_src)
+		return;
+	sense_src++;
+
+	sense_buf_t *s = &senses[num_senses];
+	int top = -1;
+	s->sense_len = 0;
+
+	for (; *sense_src && *sense_src != ',' && *sense_src != '\n'; sense_src++) {
+		if (isspace((unsigned char)*sense_src))
+			continue;
+		int val = hex_val(*sense_src);
+		if (val < 0)
+			return;
+		if (top < 0) {
+			top = val;
+		} else {
+			if (s->sense_len == (int)sizeof(s->sense))
+				return;
+			s->sense[s->sense_len++] = top << 4 | val;
+			top = -1;
+		}
+	}
+
+	if (s->sense_len > 0)
+		num_senses++;
+}
+
+static void load_file(const char *filename)
+{
+	char line[64*1024];
+	FILE *f = fopen(filename, "r");
+
+	if (!f) {
+		fprintf(stderr, "Failed to open %s\n", filename);
+		return;
+	}
+
+	while (num_senses < MAX_SENSES && fgets(line, sizeof(line), f))
+		load_line(line);
+
+	fclose(f);
+}
+
+static double now_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	char buf[ASC_NUM_NAME_LEN];
+	unsigned long iterations;
+	unsigned long i;
+	unsigned j;
+	size_t total = 0;
+	double start, sense_time, all_time, static_time;
+
+	if (argc < 3) {
+		printf("Usage: %s <iterations> testcase...\n", argv[0]);
+		return 1;
+	}
+
+	iterations = strtoul(argv[1], NULL, 0);
+	for (i = 2; i < (unsigned long)argc; i++)
+		load_file(argv[i]);
+
+	if (num_senses == 0) {
+		printf("No sense data found in the test cases\n");
+		return 1;
+	}
+
+	// The reentrant and static variants must agree on every code
+	for (j = 0; j < 0x10000; j++) {
+		const char *name = asc_num_to_name_r(j >> 8, j & 0xFF, buf, sizeof(buf));
+		if (strcmp(name, asc_num_to_name(j >> 8, j & 0xFF)) != 0) {
+			printf("Mismatch for ASC/ASCQ %02X/%02X\n", j >> 8, j & 0xFF);
+			return 1;
+		}
+	}
+
+	start = now_sec();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < num_senses; j++) {
+			sense_info_t info;
+			if (scsi_parse_sense(senses[j].sense, senses[j].sense_len, &info)) {
+				total += strlen(sense_key_to_name(info.sense_key));
+				total += strlen(asc_num_to_name_r(info.asc, info.ascq, buf, sizeof(buf)));
+			}
+		}
+	}
+	sense_time = now_sec() - start;
+
+	start = now_sec();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < 0x10000; j++)
+			total += strlen(asc_num_to_name_r(j >> 8, j & 0xFF, buf, sizeof(buf)));
+	}
+	all_time = now_sec() - start;
+
+	start = now_sec();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < 0x10000; j++)
+			total += strlen(asc_num_to_name(j >> 8, j & 0xFF));
+	}
+	static_time = now_sec() - start;
+
+	printf("Sense buffers: %u\n", num_senses);
+	printf("Sense decode: %.0f per sec\n", iterations * num_senses / sense_time);
+	printf("ASC/ASCQ names (reentrant): %.0f per sec\n", iterations * 65536.0 / all_time);
+	printf("ASC/ASCQ names (static): %.0f per sec\n", iterations * 65536.0 / static_time);
+	printf("Checksum: %zu\n", total);
+	return 0;
+}